@@ -0,0 +1,75 @@
+#ifndef BENCHWORLDS_H
+#define BENCHWORLDS_H
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "../include/World.h"
+#include "../include/Entity.h"
+#include "../include/AnimalConfig.h"
+
+namespace bench {
+    // Every world is seeded alike, so runs compare between builds
+    const uint64_t SEED = 20240601;
+
+    // A rows x columns world seeded uniformly with plants, herbivores and
+    // carnivores at the given fractions of its cells
+    inline std::unique_ptr<World> makeWorld(const int& rows, const int& columns, const double& plants, const double& herbivores, const double& carnivores) {
+        const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+        std::unique_ptr<World> world = World::createTestInstance(rows, columns);
+        world->setSeed(SEED);
+        std::vector<World::Population> populations(3);
+        populations[0].species = registry.findBySymbol(animalconfig::PLANT_CONFIG.symbol);
+        populations[0].density = plants;
+        populations[1].species = registry.findBySymbol(animalconfig::HERBIVORE_CONFIG.symbol);
+        populations[1].density = herbivores;
+        populations[2].species = registry.findBySymbol(animalconfig::CARNIVORE_CONFIG.symbol);
+        populations[2].density = carnivores;
+        world->populate(populations);
+        return world;
+    }
+
+    // The world's agents of `symbol`, in grid order
+    inline std::vector<Entity*> findAll(const World& world, const char& symbol) {
+        const animalconfig::SpeciesId species = animalconfig::SpeciesRegistry::getInstance().findBySymbol(symbol);
+        std::vector<Entity*> found;
+        for (int x = 0; x < world.size.x; ++x) {
+            for (int y = 0; y < world.size.y; ++y) {
+                if (world.getCellSpecies(x, y) == species)
+                    found.push_back(world.getEntityAt(x, y));
+            }
+        }
+        return found;
+    }
+
+    // Gives the species of `symbol` another vision range until destroyed,
+    // then puts back its entry as it was, leaving the rest of the registry alone
+    class VisionOverride {
+        public:
+            VisionOverride(const char& symbol, const uint32_t& range) {
+                animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+                const animalconfig::SpeciesId species = registry.findBySymbol(symbol);
+                name = registry.getName(species);
+                original = registry.get(species);
+                rank = registry.hasExplicitRank(species) ? registry.getRank(species) : 0;
+                mobile = registry.isMobile(species);
+                animalconfig::config changed = original;
+                changed.visionRange = range;
+                registry.add(name, changed, rank, mobile);
+            }
+            ~VisionOverride() { animalconfig::SpeciesRegistry::getInstance().add(name, original, rank, mobile); }
+
+            VisionOverride(const VisionOverride&) = delete;
+            VisionOverride& operator=(const VisionOverride&) = delete;
+
+        private:
+            std::string name;
+            animalconfig::config original;
+            uint8_t rank;
+            bool mobile;
+    };
+}
+
+#endif
@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "BenchWorlds.h"
+
+namespace {
+    // Large enough that no search window reaches the edge often
+    const int SIDE = 512;
+}
+
+// Herbivores looking for plants, with plants on 1% or 20% of the cells
+static void BM_FindNearestPrey(benchmark::State& state) {
+    bench::VisionOverride vision(animalconfig::HERBIVORE_CONFIG.symbol, state.range(0));
+    std::unique_ptr<World> world = bench::makeWorld(SIDE, SIDE, state.range(1) / 100.0, 0.02, 0.002);
+    const std::vector<Entity*> herbivores = bench::findAll(*world, animalconfig::HERBIVORE_CONFIG.symbol);
+    size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(herbivores[next]->findNearestPrey());
+        next = next + 1 == herbivores.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FindNearestPrey)->ArgNames({"vision", "prey%"})->ArgsProduct({{1, 2, 5, 10, 20}, {1, 20}});
+
+// Herbivores looking out for carnivores, which are mostly out of sight
+static void BM_FindNearestPredator(benchmark::State& state) {
+    bench::VisionOverride vision(animalconfig::HERBIVORE_CONFIG.symbol, state.range(0));
+    std::unique_ptr<World> world = bench::makeWorld(SIDE, SIDE, 0.1, 0.02, state.range(1) / 1000.0);
+    const std::vector<Entity*> herbivores = bench::findAll(*world, animalconfig::HERBIVORE_CONFIG.symbol);
+    size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(herbivores[next]->findNearestPredator());
+        next = next + 1 == herbivores.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FindNearestPredator)->ArgNames({"vision", "predators_per_mille"})->ArgsProduct({{1, 2, 5, 10, 20}, {1, 20}});
+
+// Herbivores picking a free neighbour, with the grid 10% to 90% full
+static void BM_MoveRandom(benchmark::State& state) {
+    const double fill = state.range(0) / 100.0;
+    std::unique_ptr<World> world = bench::makeWorld(SIDE, SIDE, fill / 2, fill / 2, 0.0);
+    const std::vector<Entity*> herbivores = bench::findAll(*world, animalconfig::HERBIVORE_CONFIG.symbol);
+    size_t next = 0;
+    for (auto _ : state) {
+        // Topped up, or every herbivore would starve within a few hundred calls
+        herbivores[next]->energy = animalconfig::HERBIVORE_CONFIG.energy;
+        herbivores[next]->moveRandom();
+        next = next + 1 == herbivores.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MoveRandom)->ArgName("fill%")->Arg(10)->Arg(50)->Arg(90);
@@ -0,0 +1,20 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include "../include/VisionKernel.h"
+#include "BenchWorlds.h"
+
+// Google Benchmark's own flags apply, e.g. for results to compare between releases:
+//   ./EcoSimBench --benchmark_out=bench.json --benchmark_out_format=json
+// The JSON context records what the numbers depend on besides the machine.
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::AddCustomContext("ecosim_version", ECOSIM_VERSION);
+    benchmark::AddCustomContext("ecosim_build_type", ECOSIM_BUILD_TYPE);
+    benchmark::AddCustomContext("ecosim_seed", std::to_string(bench::SEED));
+    benchmark::AddCustomContext("vision_kernel", vision::getKernelName(vision::getKernel()));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+#include "BenchWorlds.h"
+
+namespace {
+    const int EMPTY_CELL_SIDE = 1024;
+    // Shares of the occupied cells in full-tick runs
+    const double PLANT_SHARE = 0.6;
+    const double HERBIVORE_SHARE = 0.35;
+    const double CARNIVORE_SHARE = 0.05;
+    // Full-tick runs start over after this many ticks, before small worlds die out
+    const uint64_t TICKS_PER_WORLD = 50;
+}
+
+// Spawn positions as the world fills up: random probing while at least half
+// of it is free, the free-cell index past that
+static void BM_GetNewEmptyCell(benchmark::State& state) {
+    std::unique_ptr<World> world = bench::makeWorld(EMPTY_CELL_SIDE, EMPTY_CELL_SIDE, state.range(0) / 100.0, 0.0, 0.0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(world->getNewEmptyCell());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetNewEmptyCell)->ArgName("fill%")->Arg(0)->Arg(25)->Arg(50)->Arg(75)->Arg(90)->Arg(99);
+
+// Whole ticks of the default engine. Iterations run the first
+// TICKS_PER_WORLD ticks of the seeded world over and over, so every run
+// measures the same stretch of the simulation.
+static void BM_WorldRun(benchmark::State& state) {
+    const int side = state.range(0);
+    const double density = state.range(1) / 100.0;
+    auto seed = [&]() {
+        return bench::makeWorld(side, side, density * PLANT_SHARE, density * HERBIVORE_SHARE, density * CARNIVORE_SHARE);
+    };
+    std::unique_ptr<World> world = seed();
+    state.counters["agents"] = world->getOccupiedCellsCount();
+
+    int64_t updates = 0;
+    for (auto _ : state) {
+        if (world->getTick() == TICKS_PER_WORLD) {
+            state.PauseTiming();
+            world.reset();
+            world = seed();
+            state.ResumeTiming();
+        }
+        updates += world->getOccupiedCellsCount();
+        world->run();
+    }
+    // Items are agents at the start of each tick
+    state.SetItemsProcessed(updates);
+    state.counters["cells"] = static_cast<double>(side) * side;
+}
+BENCHMARK(BM_WorldRun)
+    ->ArgNames({"side", "density%"})
+    ->ArgsProduct({{15, 64, 256, 1024, 4096, 8192}, {1, 10, 50, 90}})
+    ->Unit(benchmark::kMillisecond);
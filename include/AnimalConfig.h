@@ -2,6 +2,8 @@
 #define ANIMALCONFIG_H
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 namespace animalconfig{
     struct config {
@@ -16,20 +18,14 @@ namespace animalconfig{
         uint32_t energyCostPerTick;
     };
 
-    inline uint8_t getEntityRank(const char& symbol){
-        switch (symbol) {
-            case '*':
-                return 1;
-            case 'H':
-                return 2;
-            case 'C':
-                return 3;
-            default:
-                return 0;
-        }
-    }
+    // Farthest any species may see. Distance fields stop here, and the
+    // parallel sweep's stripes are sized from it.
+    const uint32_t MAX_VISION_RANGE = 254;
+
+    // Index into the species registry; 0 means "no species" (an empty cell)
+    typedef uint8_t SpeciesId;
+    const SpeciesId NO_SPECIES = 0;
 
-    
     const config HERBIVORE_CONFIG = {
         symbol: 'H',
         prey: '*',
@@ -41,7 +37,7 @@ namespace animalconfig{
         energyGainFromEating: 20,
         energyCostPerTick: 1
     };
-    
+
     const config CARNIVORE_CONFIG = {
         symbol : 'C',
         prey : 'H',
@@ -53,7 +49,7 @@ namespace animalconfig{
         energyGainFromEating : 30,
         energyCostPerTick : 2
     };
-    
+
     const config PLANT_CONFIG = {
         symbol: '*',
         prey: ' ',
@@ -66,18 +62,76 @@ namespace animalconfig{
         energyCostPerTick: 0
     };
 
+    // Immutable per-species parameters, stored once and indexed by SpeciesId.
+    // Starts with the built-in plant, herbivore and carnivore (ids 1, 2, 3);
+    // loadFromFile() adds species or overrides existing ones by symbol.
+    class SpeciesRegistry {
+        public:
+            SpeciesRegistry();
+
+            static SpeciesRegistry& getInstance() {
+                static SpeciesRegistry instance;
+                return instance;
+            }
+
+            // Adds a species, or replaces the one already using config.symbol.
+            // Throws std::runtime_error for a reserved symbol or a visionRange
+            // above MAX_VISION_RANGE.
+            SpeciesId add(const std::string& name, const config& species, uint8_t rank, bool mobile);
+
+            // JSON: {"species": [{"name": "sheep", "symbol": "H", "prey": "*", ...}, ...]}
+            // Throws std::runtime_error on malformed input.
+            void loadFromFile(const std::string& path);
+            void loadFromString(const std::string& text);
+
+            // Back to the built-in species only
+            void reset();
+
+            inline SpeciesId findBySymbol(const char& symbol) const { return bySymbol[static_cast<uint8_t>(symbol)]; }
+            inline const config& get(const SpeciesId& id) const { return configs[id]; }
+            inline uint8_t getRank(const SpeciesId& id) const { return ranks[id]; }
+            inline SpeciesId getPrey(const SpeciesId& id) const { return preys[id]; }
+            // False when the rank follows from the prey chain
+            inline bool hasExplicitRank(const SpeciesId& id) const { return explicitRank[id]; }
+            inline bool isMobile(const SpeciesId& id) const { return mobile[id] != 0; }
+            inline const std::string& getName(const SpeciesId& id) const { return names[id]; }
+            inline const uint8_t* getRankTable() const { return ranks.data(); }
+            // Species ranked above `id`, i.e. the ones it flees from
+            inline const std::vector<SpeciesId>& getPredators(const SpeciesId& id) const { return predators[id]; }
+            // Number of registered species, not counting NO_SPECIES
+            inline uint32_t getCount() const { return configs.size() - 1; }
+
+        private:
+            void resolveRelations();
+
+            std::vector<config> configs;
+            std::vector<uint8_t> ranks;
+            std::vector<SpeciesId> preys;
+            std::vector<std::vector<SpeciesId>> predators;
+            std::vector<uint8_t> mobile;
+            std::vector<std::string> names;
+            std::vector<bool> explicitRank;
+            SpeciesId bySymbol[256];
+    };
+
+    // Energy left after paying `cost`; never wraps below zero
+    inline uint32_t spend(const uint32_t& energy, const uint32_t& cost) {
+        return energy > cost ? energy - cost : 0;
+    }
+
+    inline uint8_t getEntityRank(const char& symbol){
+        const SpeciesRegistry& registry = SpeciesRegistry::getInstance();
+        return registry.getRank(registry.findBySymbol(symbol));
+    }
+
     inline config getConfig(char symbol) {
-        switch (symbol) {
-            case 'H':
-                return HERBIVORE_CONFIG;
-            case 'C':
-                return CARNIVORE_CONFIG;
-            case '*':
-                return PLANT_CONFIG;
-            default:
-                return PLANT_CONFIG;
+        const SpeciesRegistry& registry = SpeciesRegistry::getInstance();
+        SpeciesId id = registry.findBySymbol(symbol);
+        if (id == NO_SPECIES) {
+            id = registry.findBySymbol(PLANT_CONFIG.symbol);
         }
+        return registry.get(id);
     }
 }
 
-#endif
\ No newline at end of file
+#endif
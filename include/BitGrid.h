@@ -0,0 +1,137 @@
+#ifndef BITGRID_H
+#define BITGRID_H
+
+#include <vector>
+#include <cstdint>
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+// Packed rows x cols bit matrix. Every row starts on a 64-bit word boundary
+// so rows can be scanned (and written from different threads) word by word.
+class BitGrid {
+    public:
+        BitGrid() = default;
+        BitGrid(const uint32_t& rows, const uint32_t& cols) { resize(rows, cols); }
+
+        void resize(const uint32_t& rows, const uint32_t& cols) {
+            numRows = rows;
+            numCols = cols;
+            wordsPerRow = (cols + 63) / 64;
+            words.assign(static_cast<size_t>(rows) * wordsPerRow, 0);
+            bitCount = 0;
+        }
+
+        void clear() {
+            words.assign(words.size(), 0);
+            bitCount = 0;
+        }
+
+        inline bool test(const uint32_t& row, const uint32_t& col) const {
+            return (words[wordIndex(row, col)] >> (col & 63)) & 1ULL;
+        }
+
+        // Returns true if the bit changed
+        inline bool set(const uint32_t& row, const uint32_t& col) {
+            uint64_t& word = words[wordIndex(row, col)];
+            uint64_t mask = 1ULL << (col & 63);
+            if (word & mask)
+                return false;
+            word |= mask;
+            if (counting)
+                ++bitCount;
+            return true;
+        }
+
+        // Returns true if the bit changed
+        inline bool reset(const uint32_t& row, const uint32_t& col) {
+            uint64_t& word = words[wordIndex(row, col)];
+            uint64_t mask = 1ULL << (col & 63);
+            if (!(word & mask))
+                return false;
+            word &= ~mask;
+            if (counting)
+                --bitCount;
+            return true;
+        }
+
+        // While paused, set/reset leave the count alone so different rows can be
+        // written from different threads; resumeCount() recounts every word.
+        void pauseCount() { counting = false; }
+        void resumeCount() {
+            uint32_t count = 0;
+            for (const uint64_t& word : words) {
+                count += popcount(word);
+            }
+            bitCount = count;
+            counting = true;
+        }
+
+        static inline uint32_t popcount(const uint64_t& word) {
+#if defined(_MSC_VER)
+            return static_cast<uint32_t>(__popcnt64(word));
+#else
+            return static_cast<uint32_t>(__builtin_popcountll(word));
+#endif
+        }
+
+        // Index of the lowest / highest set bit; word must not be zero
+        static inline uint32_t lowestBit(const uint64_t& word) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, word);
+            return index;
+#else
+            return static_cast<uint32_t>(__builtin_ctzll(word));
+#endif
+        }
+        static inline uint32_t highestBit(const uint64_t& word) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanReverse64(&index, word);
+            return index;
+#else
+            return 63 - static_cast<uint32_t>(__builtin_clzll(word));
+#endif
+        }
+
+        // Calls visit(row, col) for each set bit in rows [firstRow, endRow), in
+        // row-major order. The word is re-read after every visit, so bits that
+        // visit() sets ahead of the scan are seen and bits it clears are skipped,
+        // just like a cell-by-cell sweep.
+        template <typename Visit>
+        void forEachSet(const uint32_t& firstRow, const uint32_t& endRow, Visit visit) const {
+            for (uint32_t row = firstRow; row < endRow; ++row) {
+                const uint64_t* rowWords = getRowWords(row);
+                for (uint32_t word = 0; word < wordsPerRow; ++word) {
+                    uint64_t bits = rowWords[word];
+                    while (bits != 0) {
+                        const uint32_t bit = lowestBit(bits);
+                        visit(row, (word << 6) + bit);
+                        bits = bit == 63 ? 0 : rowWords[word] & (~0ULL << (bit + 1));
+                    }
+                }
+            }
+        }
+
+        inline uint32_t getCount() const { return bitCount; }
+        inline uint32_t getRows() const { return numRows; }
+        inline uint32_t getCols() const { return numCols; }
+        inline uint32_t getWordsPerRow() const { return wordsPerRow; }
+        inline const uint64_t* getRowWords(const uint32_t& row) const { return words.data() + static_cast<size_t>(row) * wordsPerRow; }
+        inline size_t getMemoryBytes() const { return words.size() * sizeof(uint64_t); }
+
+    private:
+        inline size_t wordIndex(const uint32_t& row, const uint32_t& col) const {
+            return static_cast<size_t>(row) * wordsPerRow + (col >> 6);
+        }
+
+        std::vector<uint64_t> words;
+        uint32_t numRows = 0;
+        uint32_t numCols = 0;
+        uint32_t wordsPerRow = 0;
+        uint32_t bitCount = 0;
+        bool counting = true;
+};
+
+#endif
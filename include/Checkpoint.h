@@ -0,0 +1,69 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+// On-disk layout of World checkpoints, see Checkpoint.cpp.
+//
+// A file is a Header followed by the payload; every section starts on an
+// 8-byte boundary and all values are little-endian, as the host writes them:
+//   SpeciesRecord[speciesCount], then the species names back to back
+//   posX, posY (int32), velX, velY (int8), energy (uint32), species (uint8),
+//   id (uint64), updated (uint32): entityCount entries each
+//   freeSlots, retiredSlots (uint32), dense storage only
+// Objects storage writes one entry per agent; dense storage writes its
+// EntityStore slot for slot, free slots included, so a restore continues
+// exactly where the saved run left off.
+namespace checkpoint {
+    const char MAGIC[8] = {'E', 'C', 'O', 'S', 'I', 'M', 'C', 'K'};
+    const uint32_t VERSION = 2;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerBytes;
+        uint64_t payloadBytes;
+        uint64_t checksum;          // Of the header with this field zeroed, then the payload
+        uint64_t seed;
+        uint64_t tick;
+        uint64_t worldDraws;
+        uint32_t generation;
+        uint32_t rows;
+        uint32_t cols;
+        uint32_t speciesCount;
+        uint32_t entityCount;
+        uint32_t freeSlotCount;
+        uint32_t retiredSlotCount;
+        uint8_t storage;            // World::StorageMode
+        uint8_t layout;             // World::GridLayout
+        uint8_t engine;             // World::TickEngine
+        uint8_t search;             // World::NearestSearch
+    };
+    static_assert(sizeof(Header) == 88 && std::is_trivially_copyable<Header>::value, "Header is written as raw bytes");
+
+    struct SpeciesRecord {
+        char symbol;
+        char prey;
+        uint8_t rank;               // 0 when derived from the prey chain
+        uint8_t mobile;
+        uint32_t energy;
+        uint32_t maxEnergy;
+        uint32_t visionRange;
+        uint32_t reproductionCost;
+        uint32_t reproductionThreshold;
+        uint32_t energyGainFromEating;
+        uint32_t energyCostPerTick;
+        uint32_t nameBytes;
+    };
+    static_assert(sizeof(SpeciesRecord) == 36 && std::is_trivially_copyable<SpeciesRecord>::value, "SpeciesRecord is written as raw bytes");
+
+    inline size_t alignUp(const size_t& bytes) { return (bytes + 7) & ~static_cast<size_t>(7); }
+
+    // 64-bit hash of `size` bytes, four independent lanes over 32-byte stripes
+    // so it runs near memory speed; chain calls by passing the previous result.
+    uint64_t checksum(const void* data, const size_t& size, const uint64_t& seed = 0);
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef CHUNKEDGRID_H
+#define CHUNKEDGRID_H
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include "Kinematics.h"
+#include "BitGrid.h"
+#include "FreeCellIndex.h"
+#include "AnimalConfig.h"
+
+class Entity;
+
+// Sparse cell storage for huge, mostly empty worlds. Cells live in 64x64
+// chunks that are allocated on first occupancy and freed by collect() once
+// empty, so memory follows the occupied area rather than the map size. Each
+// chunk row is one 64-bit word of occupancy and of every species' bitplane.
+class ChunkedGrid {
+    public:
+        static constexpr uint32_t CHUNK_BITS = 6;
+        static constexpr uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+
+        // Drops every chunk
+        void resize(const uint32_t& rows, const uint32_t& cols);
+        void clear();
+
+        inline Entity* get(const int& x, const int& y) const {
+            const Chunk* chunk = findChunk(x >> CHUNK_BITS, y >> CHUNK_BITS);
+            return chunk != nullptr ? chunk->cells[cellIndex(x, y)] : nullptr;
+        }
+        inline bool test(const int& x, const int& y) const {
+            const Chunk* chunk = findChunk(x >> CHUNK_BITS, y >> CHUNK_BITS);
+            return chunk != nullptr && ((chunk->occupied[x & (CHUNK_SIZE - 1)] >> (y & (CHUNK_SIZE - 1))) & 1ULL);
+        }
+        // Puts entity in the cell, replacing any occupant; nullptr empties it
+        void set(const int& x, const int& y, Entity* entity);
+
+        // Frees chunks that have become empty. Chunks are never freed in the
+        // middle of a forEachSet, which may still hold on to them.
+        void collect();
+
+        // Same contract as SpatialIndex::findNearest
+        kinematics::Vector2D findNearest(const kinematics::Vector2D& pos, const int& range,
+                                         const animalconfig::SpeciesId* species, const size_t& count) const;
+
+        // Calls visit(x, y) for occupied cells, or only those of `species` unless
+        // it is NO_SPECIES, chunk by chunk in row-major chunk order and row-major
+        // inside a chunk. Like BitGrid::forEachSet, cells filled ahead of the scan
+        // inside a chunk are seen; chunks created during the scan are not.
+        template <typename Visit>
+        void forEachSet(const animalconfig::SpeciesId& species, Visit visit) const {
+            std::vector<uint64_t> keys;
+            keys.reserve(chunks.size());
+            for (const auto& entry : chunks) {
+                keys.push_back(entry.first);
+            }
+            std::sort(keys.begin(), keys.end());
+
+            for (const uint64_t& key : keys) {
+                const Chunk& chunk = *chunks.find(key)->second;
+                const int baseX = static_cast<int>(key >> 32) << CHUNK_BITS;
+                const int baseY = static_cast<int>(key & UINT32_MAX) << CHUNK_BITS;
+                for (uint32_t row = 0; row < CHUNK_SIZE; ++row) {
+                    uint64_t bits = rowWord(chunk, species, row);
+                    while (bits != 0) {
+                        const uint32_t bit = BitGrid::lowestBit(bits);
+                        visit(baseX + static_cast<int>(row), baseY + static_cast<int>(bit));
+                        bits = bit == 63 ? 0 : rowWord(chunk, species, row) & (~0ULL << (bit + 1));
+                    }
+                }
+            }
+        }
+
+        // Cell id of the rank-th free cell, see FreeCellIndex::select
+        uint64_t findFree(const uint64_t& rank) const;
+        inline uint64_t getFreeCount() const { return freeCells.getFreeCount(); }
+
+        inline uint64_t getCount() const { return cellCount; }
+        inline size_t getChunkCount() const { return chunks.size(); }
+        size_t getMemoryBytes() const;
+
+    private:
+        struct Chunk {
+            Entity* cells[CHUNK_SIZE * CHUNK_SIZE] = {};
+            uint64_t occupied[CHUNK_SIZE] = {};
+            std::vector<uint64_t> speciesRows;      // CHUNK_SIZE words per species id
+            uint32_t count = 0;
+        };
+
+        static inline uint64_t chunkKey(const int& chunkX, const int& chunkY) {
+            return (static_cast<uint64_t>(chunkX) << 32) | static_cast<uint32_t>(chunkY);
+        }
+        static inline uint32_t cellIndex(const int& x, const int& y) {
+            return ((x & (CHUNK_SIZE - 1)) << CHUNK_BITS) | (y & (CHUNK_SIZE - 1));
+        }
+        static inline uint64_t rowWord(const Chunk& chunk, const animalconfig::SpeciesId& species, const uint32_t& row) {
+            if (species == animalconfig::NO_SPECIES)
+                return chunk.occupied[row];
+            size_t word = static_cast<size_t>(species) * CHUNK_SIZE + row;
+            return word < chunk.speciesRows.size() ? chunk.speciesRows[word] : 0;
+        }
+
+        // Neighbouring lookups mostly hit the same chunk, so the last hit is kept
+        inline Chunk* findChunk(const int& chunkX, const int& chunkY) const {
+            const uint64_t key = chunkKey(chunkX, chunkY);
+            if (key == lastKey && lastChunk != nullptr)
+                return lastChunk;
+            auto found = chunks.find(key);
+            if (found == chunks.end())
+                return nullptr;
+            lastKey = key;
+            lastChunk = found->second.get();
+            return lastChunk;
+        }
+
+        std::unordered_map<uint64_t, std::unique_ptr<Chunk>> chunks;
+        FreeCellIndex freeCells;        // Blocks line up with chunks
+        mutable uint64_t lastKey = 0;
+        mutable Chunk* lastChunk = nullptr;     // Not thread-safe; chunked worlds tick on one thread
+        uint32_t numRows = 0;
+        uint32_t numCols = 0;
+        uint64_t cellCount = 0;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef DENSITYPYRAMID_H
+#define DENSITYPYRAMID_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "AnimalConfig.h"
+
+// Downsampled views of a grid for drawing it zoomed out. Level 1 sums 2x2
+// cells into a block, level 2 sums 2x2 level-1 blocks, and so on up to the
+// level whose single block covers the map. Each block holds its agents by
+// species and their total energy, so any level can be coloured by species
+// density or by energy without visiting every cell. apply() keeps the levels
+// current as single agents come and go.
+//
+// Levels below FIRST_STORED_LEVEL are summed from the cells when a block is
+// read; the rest are stored with 16-bit counters where they fit, so with a
+// few species the pyramid costs about a byte a cell, less than the cells do.
+class DensityPyramid {
+    public:
+        static constexpr uint32_t FIRST_STORED_LEVEL = 2;
+        // Blocks up to this level hold at most 4^7 agents, which 16 bits count
+        static constexpr uint32_t LAST_NARROW_LEVEL = 7;
+
+        // One block's agents, the total and then each species, and their energy
+        struct Block {
+            std::vector<uint32_t> counts;
+            uint64_t energy = 0;
+        };
+
+        // Empties the pyramid and sizes it for a rows x columns grid
+        void reset(const int& rows, const int& columns, const uint32_t& speciesCount);
+        // Rebuilds every stored level from row-major cells, as in WorldSnapshot
+        void build(const std::vector<animalconfig::SpeciesId>& species, const std::vector<uint32_t>& energy);
+        // Adds (sign 1) or removes (sign -1) an agent at cell (x, y)
+        void apply(const int& x, const int& y, const animalconfig::SpeciesId& species, const uint32_t& energy, const int& sign);
+
+        // Levels 1 to getLevelCount()
+        inline uint32_t getLevelCount() const { return levelCount; }
+        inline uint32_t getSpeciesCount() const { return slots - 1; }
+        inline int getRows(const uint32_t& level) const { return static_cast<int>((rows + (int64_t(1) << level) - 1) >> level); }
+        inline int getColumns(const uint32_t& level) const { return static_cast<int>((columns + (int64_t(1) << level) - 1) >> level); }
+        // Block (x, y) of `level`. Levels below FIRST_STORED_LEVEL are summed
+        // from `species` and `energy`, the cells the pyramid is current with.
+        void getBlock(const uint32_t& level, const int& x, const int& y, const std::vector<animalconfig::SpeciesId>& species, const std::vector<uint32_t>& energy, Block& block) const;
+        // Cells the block covers; blocks on the far edges can be cut short
+        uint32_t getArea(const uint32_t& level, const int& x, const int& y) const;
+
+    private:
+        struct Level {
+            int columns = 0;
+            bool narrow = true;
+            std::vector<uint16_t> narrowCounts;     // `slots` per block: the total, then each species
+            std::vector<uint32_t> counts;           // The same, above LAST_NARROW_LEVEL
+            std::vector<uint64_t> energy;
+
+            inline uint32_t getCount(const size_t& slot) const { return narrow ? narrowCounts[slot] : counts[slot]; }
+            inline void add(const size_t& slot, const int64_t& amount) {
+                if (narrow) {
+                    narrowCounts[slot] = static_cast<uint16_t>(narrowCounts[slot] + amount);
+                } else {
+                    counts[slot] = static_cast<uint32_t>(counts[slot] + amount);
+                }
+            }
+        };
+
+        int rows = 0;
+        int columns = 0;
+        uint32_t slots = 1;
+        uint32_t levelCount = 0;
+        std::vector<Level> levels;                  // From FIRST_STORED_LEVEL up
+};
+
+#endif
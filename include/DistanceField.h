@@ -0,0 +1,42 @@
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "SpatialIndex.h"
+#include "WorkerPool.h"
+
+// Distance from every cell to the nearest cell holding one of a set of
+// species, up to a radius, plus the first step of a shortest path there.
+// Built once per tick so each agent reads its answer instead of searching.
+class DistanceField {
+    public:
+        static constexpr uint8_t FAR = UINT8_MAX;   // Nothing within the radius
+        static constexpr uint8_t NO_STEP = 4;       // On a source cell, or FAR
+        static constexpr uint32_t MAX_RADIUS = FAR - 1;
+        static_assert(MAX_RADIUS == animalconfig::MAX_VISION_RANGE, "a field must reach the farthest vision");
+
+        // Grid distance (4-neighbour steps) from the cells set in any of the
+        // species planes. Steps index {up, left, right, down}; the first one
+        // that gets closer wins. Rows and columns are split across `workers`
+        // when given.
+        void build(const SpatialIndex& index, const animalconfig::SpeciesId* species, const size_t& count,
+                   const uint32_t& radius, WorkerPool* workers);
+
+        inline uint8_t getDistance(const uint32_t& cellId) const { return distances[cellId]; }
+        // A source lies within `range` steps of the cell
+        inline bool reaches(const uint32_t& cellId, const uint32_t& range) const { return distances[cellId] <= radius && distances[cellId] <= range; }
+        inline uint8_t getStep(const uint32_t& cellId) const { return steps[cellId]; }
+        inline uint32_t getRadius() const { return radius; }
+
+    private:
+        std::vector<uint8_t> distances;
+        std::vector<uint8_t> steps;
+        uint32_t numRows = 0;
+        uint32_t numCols = 0;
+        uint32_t radius = 0;
+};
+
+#endif
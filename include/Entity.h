@@ -11,8 +11,11 @@ class Entity: public kinematics::Body {
         World &world;
         
     public:
-        bool isUpdated = false;
-        animalconfig::config entityConfig;
+        // Per-entity state only; species parameters live in the SpeciesRegistry
+        uint32_t energy;
+        uint64_t id;                    // Keys this entity's random draws
+        animalconfig::SpeciesId speciesId;
+        uint32_t updatedGeneration = 0; // World generation of the tick it last acted in
         
         // For production code (uses singleton)
         Entity(animalconfig::config config, int posX, int posY, int velX, int velY);
@@ -23,8 +26,12 @@ class Entity: public kinematics::Body {
         Entity(animalconfig::config config, World& testWorld, int posX, int posY, int velX, int velY);
         Entity(animalconfig::config config, World& testWorld, int posX, int posY);
         Entity(animalconfig::config config, World& testWorld, kinematics::Vector2D pos);
+        Entity(animalconfig::SpeciesId species, World& world, kinematics::Vector2D pos);
+        Entity(animalconfig::SpeciesId species, World& world, kinematics::Vector2D pos, uint64_t id);
 
         void update();
+        // Moves from `from` by the current velocity, displacing any lower-rank occupant
+        void relocate(const kinematics::Vector2D& from);
 
         void moveRandom();
         void moveAwayFromEntity(Entity* entity);
@@ -35,9 +42,10 @@ class Entity: public kinematics::Body {
         kinematics::Vector2D findNearestPredator();
         kinematics::Vector2D findNearestPrey();
 
-        char getSymbol() const { return entityConfig.symbol; }  
+        inline const animalconfig::config& getConfig() const { return animalconfig::SpeciesRegistry::getInstance().get(speciesId); }
+        char getSymbol() const { return getConfig().symbol; }  
 
-        inline void tickEnergy() { entityConfig.energy -= entityConfig.energyCostPerTick; }
+        void tickEnergy();
         bool checkBound(kinematics::Vector2D& pos);
 };
 
@@ -0,0 +1,111 @@
+#ifndef ENTITYSTORE_H
+#define ENTITYSTORE_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Struct-of-arrays entity storage used by the dense storage mode.
+// Entities are addressed by stable slot indices; species 0 marks a free slot.
+// Slots removed during a tick are only reused after recycle(), so births
+// always land behind the current sweep.
+class EntityStore {
+    public:
+        static constexpr uint32_t INVALID = UINT32_MAX;
+        static constexpr uint8_t NO_SPECIES = 0;
+
+        std::vector<int32_t> posX, posY;
+        std::vector<int8_t> velX, velY;
+        std::vector<uint32_t> energy;
+        std::vector<uint8_t> species;
+        std::vector<uint64_t> id;         // Keys the entity's random draws
+        std::vector<uint32_t> updated;    // World generation of the tick it last acted in; striped ticks only
+
+        uint32_t add(const uint8_t& speciesId, const int& x, const int& y, const uint32_t& initialEnergy) {
+            uint32_t index;
+            if (!freeSlots.empty()) {
+                index = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                index = species.size();
+                posX.push_back(0);
+                posY.push_back(0);
+                velX.push_back(0);
+                velY.push_back(0);
+                energy.push_back(0);
+                species.push_back(NO_SPECIES);
+                id.push_back(0);
+                updated.push_back(0);
+            }
+
+            posX[index] = x;
+            posY[index] = y;
+            velX[index] = 0;
+            velY[index] = 0;
+            energy[index] = initialEnergy;
+            species[index] = speciesId;
+            id[index] = index;
+            updated[index] = 0;
+            ++liveCount;
+            return index;
+        }
+
+        void remove(const uint32_t& index) {
+            species[index] = NO_SPECIES;
+            retiredSlots.push_back(index);
+            --liveCount;
+        }
+
+        // Makes slots removed since the last call available to add()
+        void recycle() {
+            freeSlots.insert(freeSlots.end(), retiredSlots.begin(), retiredSlots.end());
+            retiredSlots.clear();
+        }
+
+        void clear() {
+            posX.clear();
+            posY.clear();
+            velX.clear();
+            velY.clear();
+            energy.clear();
+            species.clear();
+            id.clear();
+            updated.clear();
+            freeSlots.clear();
+            retiredSlots.clear();
+            liveCount = 0;
+        }
+
+        void reserve(const size_t& count) {
+            posX.reserve(count);
+            posY.reserve(count);
+            velX.reserve(count);
+            velY.reserve(count);
+            energy.reserve(count);
+            species.reserve(count);
+            id.reserve(count);
+            updated.reserve(count);
+        }
+
+        // Free and retired slot lists, for checkpoints
+        inline const std::vector<uint32_t>& getFreeSlots() const { return freeSlots; }
+        inline const std::vector<uint32_t>& getRetiredSlots() const { return retiredSlots; }
+        // Takes over the slot lists once the arrays have been filled directly
+        void restore(const std::vector<uint32_t>& free, const std::vector<uint32_t>& retired) {
+            freeSlots = free;
+            retiredSlots = retired;
+            liveCount = species.size() - std::count(species.begin(), species.end(), NO_SPECIES);
+        }
+
+        inline bool isAlive(const uint32_t& index) const { return index < species.size() && species[index] != NO_SPECIES; }
+        inline uint32_t getSlotCount() const { return species.size(); }
+        inline uint32_t getLiveCount() const { return liveCount; }
+        inline size_t getCapacity() const { return species.capacity(); }
+
+    private:
+        std::vector<uint32_t> freeSlots;
+        std::vector<uint32_t> retiredSlots;
+        uint32_t liveCount = 0;
+};
+
+#endif
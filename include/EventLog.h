@@ -0,0 +1,172 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+#include "AnimalConfig.h"
+
+// Recording of what happens in every tick, for offline analysis. The tick
+// code appends fixed-size Events to per-thread buffers; at the end of a tick
+// they are handed to the log as one batch and a background thread encodes,
+// compresses and writes them, so the simulation only pays for the appends.
+//
+// File layout. Headers, index and footer are the host's structs as is, so
+// logs move between little-endian machines only; ids are written
+// little-endian byte by byte and the rest of a chunk is varints:
+//   FileHeader
+//   chunks: ChunkHeader, then storedBytes of (possibly deflated) ticks
+//   IndexEntry[chunkCount], Footer
+// Inside a chunk each tick is varint(tick - previous tick), varint(events),
+// then per event: a byte of type and step, the species, zigzag varint deltas
+// of x and y against the previous event of the chunk, the entity id and, for
+// births and kills, the other id. Chunks decode on their own and carry a
+// checksum, so a reader seeks through the index; a log whose writer died
+// before the footer is read by walking the chunk headers instead.
+class EventLog {
+    public:
+        enum class Type : uint8_t { Move, Birth, Kill, Starve };
+
+        // `entity` acted at (x, y). Moves go one step to (x + dx, y + dy),
+        // births and kills put the child or the victim (`other`) there.
+        struct Event {
+            int32_t x, y;
+            uint64_t entity;
+            uint64_t other;
+            Type type;
+            animalconfig::SpeciesId species;
+            int8_t dx, dy;
+        };
+
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t headerBytes;
+        };
+        struct ChunkHeader {
+            char magic[4];
+            uint32_t compression;       // NONE or DEFLATE
+            uint64_t firstTick;
+            uint64_t lastTick;
+            uint32_t eventCount;
+            uint32_t rawBytes;
+            uint32_t storedBytes;
+            uint32_t checksum;          // Of the stored bytes, see checkpoint::checksum
+        };
+        struct IndexEntry {
+            uint64_t firstTick;
+            uint64_t lastTick;
+            uint64_t offset;
+        };
+        struct Footer {
+            uint64_t indexOffset;
+            uint64_t chunkCount;
+            char magic[8];
+        };
+
+        static constexpr char MAGIC[8] = {'E', 'C', 'O', 'S', 'I', 'M', 'E', 'V'};
+        static constexpr char CHUNK_MAGIC[4] = {'E', 'V', 'C', 'K'};
+        static constexpr char INDEX_MAGIC[8] = {'E', 'C', 'O', 'S', 'I', 'M', 'I', 'X'};
+        static constexpr uint32_t VERSION = 2;
+        static constexpr uint32_t NONE = 0;
+        static constexpr uint32_t DEFLATE = 1;
+        // Encoded bytes gathered before a chunk is compressed and written
+        static constexpr size_t CHUNK_BYTES = 1 << 20;
+        // Ticks the writer may fall behind before endTick() waits for it
+        static constexpr size_t MAX_PENDING_TICKS = 64;
+
+        // Creates `path` and starts the writer; throws std::runtime_error
+        explicit EventLog(const std::string& path);
+        // Closes the log, dropping any writer error
+        ~EventLog();
+
+        EventLog(const EventLog&) = delete;
+        EventLog& operator=(const EventLog&) = delete;
+
+        // Adds `events` to the current tick's batch and empties it
+        void append(std::vector<Event>& events);
+        void append(const Event* events, const size_t& count);
+        // Queues the batch as tick `tick`
+        void endTick(const uint64_t& tick);
+        // Writes what is queued, the index and the footer; rethrows a writer error
+        void close();
+
+        // Events in the chunks written so far; updated by the writer, and
+        // complete once close() has returned. Dropped events never count.
+        inline uint64_t getEventCount() const { return eventCount.load(std::memory_order_relaxed); }
+        // Bytes on disk so far; updated by the writer
+        inline uint64_t getBytesWritten() const { return bytesWritten.load(std::memory_order_relaxed); }
+        // True when built with zlib, otherwise chunks are stored encoded only
+        static bool isCompressed();
+
+    private:
+        struct Batch {
+            uint64_t tick;
+            std::vector<Event> events;
+        };
+
+        void writerLoop();
+        void encodeTick(const Batch& batch);
+        void flushChunk();
+
+        std::FILE* file = nullptr;
+        std::thread writer;
+        std::mutex mutex;
+        std::condition_variable queued;
+        std::condition_variable drained;
+        std::deque<Batch> pending;
+        std::vector<std::vector<Event>> spare;  // Emptied batches, reused to keep the tick free of allocations
+        std::vector<Event> current;
+        bool closing = false;
+        bool closed = false;
+        std::exception_ptr writerError;
+        std::atomic<uint64_t> eventCount{0};
+        std::atomic<uint64_t> bytesWritten{0};
+
+        // Writer thread only
+        std::vector<unsigned char> raw;
+        std::vector<unsigned char> stored;
+        std::vector<IndexEntry> index;
+        ChunkHeader chunk{};
+        int32_t lastX = 0, lastY = 0;
+        uint64_t lastTick = 0;
+};
+
+// Reads a log written by EventLog
+class EventLogReader {
+    public:
+        struct Record {
+            uint64_t tick;
+            EventLog::Event event;
+        };
+
+        // Throws std::runtime_error if the file is missing or not an event log
+        explicit EventLogReader(const std::string& path);
+
+        inline size_t getChunkCount() const { return index.size(); }
+        // False when the footer was missing and the chunks were found by scanning
+        inline bool hasIndex() const { return indexed; }
+        uint64_t getFirstTick() const;
+        uint64_t getLastTick() const;
+
+        // Events of ticks [firstTick, endTick) in recorded order; only the
+        // chunks overlapping the range are read
+        std::vector<Record> read(const uint64_t& firstTick, const uint64_t& endTick) const;
+
+    private:
+        void decodeChunk(const size_t& chunk, const uint64_t& firstTick, const uint64_t& endTick, std::vector<Record>& records) const;
+
+        std::string path;
+        std::vector<EventLog::IndexEntry> index;
+        bool indexed = false;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef FRAMEEXPORTER_H
+#define FRAMEEXPORTER_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+#include "Snapshot.h"
+
+class World;
+
+// Writes a run as a numbered image sequence (prefix_000000.png, ...) without
+// a window or GL context, for assembling into video offline, e.g.
+//   ffmpeg -i frames/frame_%06d.png run.mp4
+// capture() queues a copy of a snapshot's cells; a pool of encoder threads
+// colours every cell as a square of cellPixels x cellPixels pixels, encodes
+// the frame and writes it, so the simulation pays for the copy only. The
+// snapshot is one SimulationThread already publishes, or one the exporter
+// keeps patched with the cells a world changed since the last frame.
+class FrameExporter {
+    public:
+        enum class Format { PPM, PNG };
+
+        struct Options {
+            std::string directory = ".";    // Must exist
+            std::string prefix = "frame";
+            Format format = Format::PNG;
+            uint32_t every = 1;             // Capture one call in `every`
+            uint32_t cellPixels = 4;
+            uint32_t encoders = 0;          // 0 picks the hardware concurrency less one, at least one
+        };
+
+        // Frames the encoders may fall behind before capture() waits for them
+        static constexpr size_t MAX_PENDING_FRAMES = 16;
+        // Widest and tallest frame in pixels, the most a PNG header can hold
+        static constexpr uint32_t MAX_FRAME_SIDE = 0x7FFFFFFF;
+        // Most data one PNG chunk may carry; larger images span several IDAT chunks
+        static constexpr size_t MAX_CHUNK_DATA = 0x7FFFFFFF;
+
+        // Throws std::runtime_error for bad options
+        explicit FrameExporter(const Options& options);
+        // Closes the exporter, dropping any encoder error
+        ~FrameExporter();
+
+        FrameExporter(const FrameExporter&) = delete;
+        FrameExporter& operator=(const FrameExporter&) = delete;
+
+        // Call once per tick; queues a frame of `world` every `every` calls.
+        // Turns on the world's change tracking and takes its changed cells, so
+        // nothing else may take them. Throws std::runtime_error for a frame
+        // larger than MAX_FRAME_SIDE either way.
+        void capture(World& world);
+        // The same for a published snapshot, e.g. SimulationThread::getLatestSnapshot()
+        void capture(const WorldSnapshot& snapshot);
+        // Waits for every queued frame to be written; rethrows an encoder error
+        void close();
+
+        inline uint64_t getFramesQueued() const { return framesQueued; }
+        inline uint64_t getFramesWritten() const { return framesWritten.load(std::memory_order_relaxed); }
+        // Path of frame `index`
+        std::string getFramePath(const uint64_t& index) const;
+
+        // Row-major RGB, 3 bytes a pixel, (columns x rows) * cellPixels in size,
+        // in the colours of palette::getCellColor
+        static void rasterise(const WorldSnapshot& snapshot, const uint32_t& cellPixels, std::vector<uint8_t>& rgb);
+        // Throw std::runtime_error when the file cannot be written
+        static void writePpm(const std::string& path, const uint32_t& width, const uint32_t& height, const std::vector<uint8_t>& rgb);
+        // Deflated with zlib when the build has it, stored otherwise, in IDAT
+        // chunks of at most maxChunk bytes
+        static void writePng(const std::string& path, const uint32_t& width, const uint32_t& height, const std::vector<uint8_t>& rgb,
+                             const size_t& maxChunk = MAX_CHUNK_DATA);
+
+    private:
+        struct Frame {
+            uint64_t index;
+            WorldSnapshot snapshot;
+        };
+
+        void encoderLoop();
+
+        Options options;
+        std::vector<std::thread> encoders;
+        std::mutex mutex;
+        std::condition_variable queued;
+        std::condition_variable drained;
+        std::deque<Frame> pending;
+        std::vector<WorldSnapshot> spare;       // Written snapshots, reused to keep their memory
+        WorldSnapshot latest;                   // Patched by capture(World&), sim thread only
+        std::vector<uint32_t> changed;
+        bool closing = false;
+        bool closed = false;
+        std::exception_ptr encoderError;
+        uint64_t calls = 0;
+        uint64_t framesQueued = 0;
+        std::atomic<uint64_t> framesWritten{0};
+};
+
+#endif
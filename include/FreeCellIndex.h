@@ -0,0 +1,112 @@
+#ifndef FREECELLINDEX_H
+#define FREECELLINDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#include "BitGrid.h"
+
+// Free cells of a rows x cols grid counted per 64x64 block in a Fenwick tree,
+// so the rank-th free cell is found in O(log blocks) plus a scan of one block,
+// however full the grid is. The tree holds occupied counts, which fit 32 bits
+// on any map. Cells that pad the edge blocks out to 64x64 count as occupied,
+// so every block holds 4096 cells and free counts need no grid geometry.
+class FreeCellIndex {
+    public:
+        static constexpr uint32_t BLOCK_BITS = 6;
+        static constexpr uint32_t BLOCK_SIZE = 1u << BLOCK_BITS;
+
+        void resize(const uint32_t& rows, const uint32_t& cols);
+        // Marks every cell free
+        void clear();
+
+        inline void occupy(const uint32_t& row, const uint32_t& col) {
+            add(blockIndex(row, col), 1);
+            ++occupiedCount;
+        }
+        inline void vacate(const uint32_t& row, const uint32_t& col) {
+            add(blockIndex(row, col), -1);
+            --occupiedCount;
+        }
+
+        // Recomputes the counts from occupied(blockRow, blockCol), the number
+        // of occupied cells in that block, in O(blocks)
+        template <typename Occupied>
+        void rebuild(Occupied occupied) {
+            occupiedCount = 0;
+            for (size_t block = 0; block < blockCount; ++block) {
+                const uint32_t blockRow = static_cast<uint32_t>(block / blocksPerRow);
+                const uint32_t blockCol = static_cast<uint32_t>(block % blocksPerRow);
+                const uint32_t count = occupied(blockRow, blockCol);
+                occupiedCount += count;
+                tree[block + 1] = count + getPadding(blockRow, blockCol);
+            }
+            for (size_t node = 1; node <= blockCount; ++node) {
+                size_t parent = node + (node & (0 - node));
+                if (parent <= blockCount) {
+                    tree[parent] += tree[node];
+                }
+            }
+        }
+
+        inline uint64_t getFreeCount() const { return cellCount - occupiedCount; }
+
+        // Cell id (row * cols + col) of the rank-th free cell, counting blocks
+        // in row-major order and cells row-major inside a block. rowWord(row,
+        // blockCol) returns the occupancy bits of cells [64 * blockCol,
+        // 64 * blockCol + 64) of a row. rank must be below getFreeCount().
+        template <typename RowWord>
+        uint64_t select(uint64_t rank, RowWord rowWord) const {
+            const size_t block = findBlock(rank);
+            const uint32_t blockCol = static_cast<uint32_t>(block % blocksPerRow);
+            const uint32_t firstRow = static_cast<uint32_t>(block / blocksPerRow) << BLOCK_BITS;
+            const uint32_t endRow = std::min(numRows, firstRow + BLOCK_SIZE);
+            const uint32_t width = std::min(BLOCK_SIZE, numCols - (blockCol << BLOCK_BITS));
+            const uint64_t valid = width == 64 ? ~0ULL : (1ULL << width) - 1;
+
+            for (uint32_t row = firstRow; row < endRow; ++row) {
+                uint64_t free = ~rowWord(row, blockCol) & valid;
+                const uint32_t count = BitGrid::popcount(free);
+                if (rank < count) {
+                    for (; rank > 0; --rank) {
+                        free &= free - 1;
+                    }
+                    return static_cast<uint64_t>(row) * numCols + (blockCol << BLOCK_BITS) + BitGrid::lowestBit(free);
+                }
+                rank -= count;
+            }
+            return cellCount;   // Only when the counts disagree with rowWord
+        }
+
+        inline size_t getMemoryBytes() const { return tree.capacity() * sizeof(uint32_t); }
+
+    private:
+        inline size_t blockIndex(const uint32_t& row, const uint32_t& col) const {
+            return static_cast<size_t>(row >> BLOCK_BITS) * blocksPerRow + (col >> BLOCK_BITS);
+        }
+        inline void add(const size_t& block, const int32_t& delta) {
+            for (size_t node = block + 1; node <= blockCount; node += node & (0 - node)) {
+                tree[node] += static_cast<uint32_t>(delta);
+            }
+        }
+        // Cells of the block outside the grid
+        inline uint32_t getPadding(const uint32_t& blockRow, const uint32_t& blockCol) const {
+            const uint32_t height = std::min(BLOCK_SIZE, numRows - (blockRow << BLOCK_BITS));
+            const uint32_t width = std::min(BLOCK_SIZE, numCols - (blockCol << BLOCK_BITS));
+            return BLOCK_SIZE * BLOCK_SIZE - height * width;
+        }
+        // Block holding the rank-th free cell; rank becomes the rank inside it
+        size_t findBlock(uint64_t& rank) const;
+
+        std::vector<uint32_t> tree;     // 1-based Fenwick tree of occupied counts, padding included
+        uint32_t numRows = 0;
+        uint32_t numCols = 0;
+        size_t blocksPerRow = 0;
+        size_t blockCount = 0;
+        uint64_t cellCount = 0;
+        uint64_t occupiedCount = 0;
+};
+
+#endif
@@ -2,6 +2,8 @@
 #define KINEMATICS_H
 
 #include <iostream>
+#include <cstdint>
+#include <cstdlib>
 
 namespace kinematics{
     
@@ -42,6 +44,17 @@ namespace kinematics{
         return Vector2D(vec.x * scalar, vec.y * scalar);
     }
 
+    // Manhattan distance, the number of 4-neighbour steps between two cells
+    inline uint32_t findDistance(const Vector2D& pos1, const Vector2D& pos2) {
+        return std::abs(pos1.x - pos2.x) + std::abs(pos1.y - pos2.y);
+    }
+
+    // The 4-neighbour steps in the order agents try them when moving: up,
+    // left, right, down. DistanceField step indices follow the same order.
+    const Vector2D STEPS[4] = {{-1, 0}, {0, -1}, {0, 1}, {1, 0}};
+    // The order a parent tries the cells around it for a newborn
+    const Vector2D BIRTH_STEPS[4] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
     struct State{
         public:
             State(int posX, int posY, int velX, int velY)
@@ -0,0 +1,195 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+
+// Lowest level compiled in: 0 debug, 1 info, 2 warning, 3 error, 4 none.
+// Calls below it expand to nothing, arguments included.
+#ifndef ECOSIM_LOG_LEVEL
+    #define ECOSIM_LOG_LEVEL 1
+#endif
+
+namespace logging {
+    enum class Level : uint8_t { Debug, Info, Warning, Error, Off };
+
+    // Asynchronous log. A call copies its format string pointer and arguments
+    // into a slot of a lock-free multi-producer ring and returns; a background
+    // thread formats the ready slots and writes them with one write and one
+    // flush per batch. When the ring is full the message is dropped and
+    // counted rather than making the caller wait.
+    //
+    // Formats use "{}" for each argument in order. The format must be a string
+    // literal; string arguments are copied, up to TEXT_BYTES per message.
+    class Logger {
+        public:
+            static constexpr size_t CAPACITY = 4096;        // Slots in the ring, a power of two
+            static constexpr size_t MAX_ARGS = 6;
+            static constexpr size_t TEXT_BYTES = 96;
+            // How long the writer sleeps when the ring is empty
+            static constexpr std::chrono::milliseconds FLUSH_INTERVAL{20};
+
+            static Logger& getInstance() {
+                static Logger instance;
+                return instance;
+            }
+
+            Logger(const Logger&) = delete;
+            Logger& operator=(const Logger&) = delete;
+
+            template <typename... Args>
+            void log(const Level& level, const char* format, const Args&... args) {
+                static_assert(sizeof...(Args) <= MAX_ARGS, "Too many log arguments");
+                if (level < minimumLevel.load(std::memory_order_relaxed))
+                    return;
+                uint64_t position;
+                Slot* slot = claim(position);
+                if (slot == nullptr) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                Message& message = slot->message;
+                message.time = std::chrono::steady_clock::now();
+                message.format = format;
+                message.level = level;
+                message.argCount = 0;
+                message.textUsed = 0;
+                int expand[] = {0, (capture(message, args), 0)...};
+                (void)expand;
+                slot->sequence.store(position + 1, std::memory_order_release);
+            }
+
+            // Messages below `level` are skipped at run time
+            inline void setLevel(const Level& level) { minimumLevel.store(level, std::memory_order_relaxed); }
+            inline Level getLevel() const { return minimumLevel.load(std::memory_order_relaxed); }
+            // Where formatted lines go, stderr by default; flushes what is queued first
+            void setOutput(std::FILE* output);
+            // Returns once every message logged before the call is written
+            void flush();
+            inline uint64_t getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+            static const char* getLevelName(const Level& level);
+
+        private:
+            struct Arg {
+                enum class Type : uint8_t { Signed, Unsigned, Double, Char, Bool, Text };
+                Type type;
+                uint8_t offset;     // Text: bytes into Message::text
+                uint8_t length;
+                union {
+                    int64_t i;
+                    uint64_t u;
+                    double d;
+                };
+            };
+            struct Message {
+                std::chrono::steady_clock::time_point time;
+                const char* format;
+                Level level;
+                uint8_t argCount;
+                uint8_t textUsed;
+                Arg args[MAX_ARGS];
+                char text[TEXT_BYTES];
+            };
+            // Ready for the writer when sequence == position + 1, free for
+            // the producer claiming `position` when sequence == position
+            struct Slot {
+                std::atomic<uint64_t> sequence;
+                Message message;
+            };
+
+            Logger();
+            ~Logger();
+
+            Slot* claim(uint64_t& position);
+            void writerLoop();
+            // Formats every ready message into `batch`; returns how many
+            size_t drain();
+            void format(const Message& message);
+
+            template <typename T>
+            static typename std::enable_if<std::is_integral<T>::value>::type capture(Message& message, const T& value) {
+                Arg& arg = message.args[message.argCount++];
+                if (std::is_same<T, bool>::value) {
+                    arg.type = Arg::Type::Bool;
+                    arg.u = value ? 1 : 0;
+                } else if (std::is_same<T, char>::value) {
+                    arg.type = Arg::Type::Char;
+                    arg.u = static_cast<unsigned char>(value);
+                } else if (std::is_signed<T>::value) {
+                    arg.type = Arg::Type::Signed;
+                    arg.i = static_cast<int64_t>(value);
+                } else {
+                    arg.type = Arg::Type::Unsigned;
+                    arg.u = static_cast<uint64_t>(value);
+                }
+            }
+            template <typename T>
+            static typename std::enable_if<std::is_floating_point<T>::value>::type capture(Message& message, const T& value) {
+                Arg& arg = message.args[message.argCount++];
+                arg.type = Arg::Type::Double;
+                arg.d = static_cast<double>(value);
+            }
+            template <typename T>
+            static typename std::enable_if<std::is_enum<T>::value>::type capture(Message& message, const T& value) {
+                capture(message, static_cast<typename std::underlying_type<T>::type>(value));
+            }
+            static void capture(Message& message, const char* value) { captureText(message, value, value ? std::strlen(value) : 0); }
+            static void capture(Message& message, const std::string& value) { captureText(message, value.data(), value.size()); }
+            static void captureText(Message& message, const char* value, const size_t& length);
+
+            std::unique_ptr<Slot[]> slots;
+            std::atomic<uint64_t> enqueuePosition{0};
+            std::atomic<Level> minimumLevel{Level::Debug};
+            std::atomic<uint64_t> dropped{0};
+
+            std::thread writer;
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::condition_variable written;
+            std::FILE* output = stderr;
+            bool stopping = false;
+            bool flushRequested = false;
+            uint64_t writtenPosition = 0;
+
+            // Writer thread only
+            uint64_t dequeuePosition = 0;
+            uint64_t droppedReported = 0;
+            std::chrono::steady_clock::time_point start;
+            std::string batch;
+    };
+}
+
+#define ECOSIM_LOG(level, ...) ::logging::Logger::getInstance().log(level, __VA_ARGS__)
+
+#if ECOSIM_LOG_LEVEL <= 0
+    #define ECOSIM_LOG_DEBUG(...) ECOSIM_LOG(::logging::Level::Debug, __VA_ARGS__)
+#else
+    #define ECOSIM_LOG_DEBUG(...) ((void)0)
+#endif
+#if ECOSIM_LOG_LEVEL <= 1
+    #define ECOSIM_LOG_INFO(...) ECOSIM_LOG(::logging::Level::Info, __VA_ARGS__)
+#else
+    #define ECOSIM_LOG_INFO(...) ((void)0)
+#endif
+#if ECOSIM_LOG_LEVEL <= 2
+    #define ECOSIM_LOG_WARNING(...) ECOSIM_LOG(::logging::Level::Warning, __VA_ARGS__)
+#else
+    #define ECOSIM_LOG_WARNING(...) ((void)0)
+#endif
+#if ECOSIM_LOG_LEVEL <= 3
+    #define ECOSIM_LOG_ERROR(...) ECOSIM_LOG(::logging::Level::Error, __VA_ARGS__)
+#else
+    #define ECOSIM_LOG_ERROR(...) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Slab allocator with an intrusive free list. acquire/release are O(1),
+// reset() rewinds every slab at once and keeps the memory for the next run.
+template <typename T, size_t SlabSize = 4096>
+class ObjectPool {
+    public:
+        ObjectPool() = default;
+        ObjectPool(const ObjectPool&) = delete;
+        ObjectPool& operator=(const ObjectPool&) = delete;
+
+        template <typename... Args>
+        T* acquire(Args&&... args) {
+            Slot* slot = freeList;
+            if (slot != nullptr) {
+                freeList = slot->next;
+            } else {
+                if (slabCursor == slabs.size()) {
+                    allocateSlab();
+                }
+                slot = &slabs[slabCursor][slotCursor];
+                if (++slotCursor == SlabSize) {
+                    ++slabCursor;
+                    slotCursor = 0;
+                }
+            }
+
+            T* object = new (slot->storage) T(std::forward<Args>(args)...);
+            ++liveCount;
+            highWaterMark = std::max(highWaterMark, liveCount);
+            return object;
+        }
+
+        void release(T* object) {
+            object->~T();
+            Slot* slot = reinterpret_cast<Slot*>(object);
+            slot->next = freeList;
+            freeList = slot;
+            --liveCount;
+        }
+
+        // Forgets every live object without walking them; slabs are kept
+        void reset() {
+            static_assert(std::is_trivially_destructible<T>::value, "reset() rewinds the pool without running destructors");
+            slabCursor = 0;
+            slotCursor = 0;
+            freeList = nullptr;
+            liveCount = 0;
+        }
+
+        // True if the object lives in one of this pool's slabs, O(log slabs)
+        bool owns(const T* object) const {
+            const Slot* slot = reinterpret_cast<const Slot*>(object);
+            auto it = std::upper_bound(slabsByAddress.begin(), slabsByAddress.end(), slot, std::less<const Slot*>());
+            if (it == slabsByAddress.begin())
+                return false;
+            --it;
+            return std::less<const Slot*>()(slot, *it + SlabSize);
+        }
+
+        inline size_t getLiveCount() const { return liveCount; }
+        inline size_t getHighWaterMark() const { return highWaterMark; }
+        inline size_t getSlabCount() const { return slabs.size(); }
+        inline size_t getCapacity() const { return slabs.size() * SlabSize; }
+        inline size_t getMemoryBytes() const { return getCapacity() * sizeof(Slot); }
+
+    private:
+        union Slot {
+            Slot* next;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        void allocateSlab() {
+            slabs.emplace_back(new Slot[SlabSize]);
+
+            const Slot* base = slabs.back().get();
+            slabsByAddress.insert(std::upper_bound(slabsByAddress.begin(), slabsByAddress.end(), base, std::less<const Slot*>()), base);
+        }
+
+        std::vector<std::unique_ptr<Slot[]>> slabs;
+        std::vector<const Slot*> slabsByAddress;
+        size_t slabCursor = 0;
+        size_t slotCursor = 0;
+        Slot* freeList = nullptr;
+        size_t liveCount = 0;
+        size_t highWaterMark = 0;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef OCCUPANCYGRID_H
+#define OCCUPANCYGRID_H
+
+#include <cstdint>
+#include <algorithm>
+
+#include "BitGrid.h"
+#include "FreeCellIndex.h"
+
+// The world's occupancy bitplane. Next to the bits it keeps a FreeCellIndex,
+// so picking a uniformly random empty cell costs O(log n) at any density.
+class OccupancyGrid : public BitGrid {
+    public:
+        void resize(const uint32_t& rows, const uint32_t& cols) {
+            BitGrid::resize(rows, cols);
+            freeCells.resize(rows, cols);
+        }
+
+        void clear() {
+            BitGrid::clear();
+            freeCells.clear();
+        }
+
+        inline bool set(const uint32_t& row, const uint32_t& col) {
+            if (!BitGrid::set(row, col))
+                return false;
+            if (tracking)
+                freeCells.occupy(row, col);
+            return true;
+        }
+
+        inline bool reset(const uint32_t& row, const uint32_t& col) {
+            if (!BitGrid::reset(row, col))
+                return false;
+            if (tracking)
+                freeCells.vacate(row, col);
+            return true;
+        }
+
+        // The free-cell counts pause and resume along with the bit count
+        void pauseCount() {
+            BitGrid::pauseCount();
+            tracking = false;
+        }
+        void resumeCount() {
+            BitGrid::resumeCount();
+            freeCells.rebuild([this](uint32_t blockRow, uint32_t blockCol) {
+                const uint32_t firstRow = blockRow << FreeCellIndex::BLOCK_BITS;
+                const uint32_t endRow = std::min(getRows(), firstRow + FreeCellIndex::BLOCK_SIZE);
+                uint32_t count = 0;
+                for (uint32_t row = firstRow; row < endRow; ++row) {
+                    count += popcount(getRowWords(row)[blockCol]);
+                }
+                return count;
+            });
+            tracking = true;
+        }
+
+        // Cell id of the rank-th free cell, see FreeCellIndex::select
+        inline uint64_t findFree(const uint64_t& rank) const {
+            return freeCells.select(rank, [this](uint32_t row, uint32_t blockCol) {
+                return getRowWords(row)[blockCol];
+            });
+        }
+        inline uint64_t getFreeCount() const { return freeCells.getFreeCount(); }
+        inline size_t getMemoryBytes() const { return BitGrid::getMemoryBytes() + freeCells.getMemoryBytes(); }
+
+    private:
+        FreeCellIndex freeCells;
+        bool tracking = true;
+};
+
+#endif
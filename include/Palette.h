@@ -0,0 +1,27 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <cstdint>
+
+#include "AnimalConfig.h"
+
+// How cells are coloured, shared by the viewer and the frame exporter
+namespace palette {
+    // Mobile agents at or below this energy fade out in red
+    constexpr uint32_t LOW_ENERGY = 50;
+    // Colour a fading agent is tinted with
+    constexpr uint8_t FADE_TINT[3] = {255, 100, 100};
+
+    inline bool isFading(const animalconfig::SpeciesId& species, const uint32_t& energy) {
+        return species != animalconfig::NO_SPECIES && energy <= LOW_ENERGY && animalconfig::SpeciesRegistry::getInstance().isMobile(species);
+    }
+
+    // Opacity, out of 255, of a fading agent over the ground
+    inline uint32_t getFadeAlpha(const uint32_t& energy) { return 50 + 3 * energy; }
+
+    // Colour of a cell: the ground where empty, else the species' colour,
+    // faded while a mobile agent runs low on energy
+    void getCellColor(const animalconfig::SpeciesId& species, const uint32_t& energy, uint8_t rgb[3]);
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef POPULATIONSTATS_H
+#define POPULATIONSTATS_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "AnimalConfig.h"
+
+// Per-species head counts, energy and birth and death tallies, kept up to
+// date by the World as agents appear, act and die, so reading them never
+// scans the grid. Optionally samples them once per tick into a time series
+// held in memory until it is flushed to CSV or to a binary file.
+class PopulationStats {
+    public:
+        // One slot per possible SpeciesId
+        static constexpr size_t MAX_SPECIES = 256;
+
+        struct Tally {
+            int64_t count = 0;
+            int64_t energy = 0;
+            uint64_t births = 0;    // Born by reproduction; seeding and spawning are not births
+            uint64_t deaths = 0;    // Eaten, displaced or starved
+        };
+
+        // One species at the end of one tick; births and deaths are running totals
+        struct Sample {
+            uint64_t tick;
+            int64_t count;
+            int64_t energy;
+            uint64_t births;
+            uint64_t deaths;
+            uint32_t species;
+            uint32_t reserved;
+        };
+
+        // Binary series: this header, then Sample records as they are laid out here
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t sampleBytes;
+        };
+        static constexpr char MAGIC[8] = {'E', 'C', 'O', 'S', 'I', 'M', 'S', 'T'};
+        static constexpr uint32_t VERSION = 1;
+
+        PopulationStats() : tallies(MAX_SPECIES) {}
+
+        inline const Tally& get(const animalconfig::SpeciesId& species) const { return tallies[species]; }
+        inline std::vector<Tally>& getTallies() { return tallies; }
+        // Sum over all species
+        Tally getTotal() const;
+        // Adds per-thread deltas, see World::StripeContext, and zeroes them
+        void merge(std::vector<Tally>& deltas);
+        // Zeroes every tally; the series is kept
+        void clear();
+
+        inline void setRecording(const bool& enabled) { recording = enabled; }
+        inline bool isRecording() const { return recording; }
+        // Appends a sample per registered species
+        void sample(const uint64_t& tick);
+        inline const std::vector<Sample>& getSamples() const { return samples; }
+
+        // Append the buffered samples to `path` and empty the buffer; a new or
+        // empty file gets a header first. Throw std::runtime_error on failure.
+        void flushCsv(const std::string& path);
+        void flushBinary(const std::string& path);
+        // Every sample of a binary series
+        static std::vector<Sample> readBinary(const std::string& path);
+
+    private:
+        std::vector<Tally> tallies;
+        std::vector<Sample> samples;
+        bool recording = false;
+};
+
+#endif
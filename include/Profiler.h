@@ -0,0 +1,172 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+// 1 builds the ECOSIM_PROFILE_SCOPE timers in, 0 removes them
+#ifndef ECOSIM_PROFILE
+    #define ECOSIM_PROFILE 1
+#endif
+
+namespace profiler {
+    // What a timer measures. Times are inclusive: a Hunt contains its Feed,
+    // a pass contains every agent update in it.
+    enum class Phase : uint8_t {
+        Tick,               // World::run
+        HerbivorePass,      // The sweep's first pass, herbivores only
+        AgentPass,          // The sweep's second pass, everyone else
+        Merge,              // Deferred work of striped passes
+        IntentPlanes,       // Intent engine: freezing the species and rank planes
+        IntentFields,
+        IntentPlan,
+        IntentCommit,
+        Record,             // Event log and statistics at the end of a tick
+        FindPredator,
+        FindPrey,
+        Flee,
+        Reproduce,
+        Hunt,
+        Feed,
+        Wander,
+        Count
+    };
+    constexpr size_t PHASE_COUNT = static_cast<size_t>(Phase::Count);
+    const char* getPhaseName(const Phase& phase);
+
+    // Durations in nanoseconds, counted exactly below 16 and in 8 buckets per
+    // power of two above, so percentiles are within about 6%
+    class Histogram {
+        public:
+            static constexpr uint32_t SUB_BUCKETS = 8;
+            static constexpr uint32_t BUCKET_COUNT = 16 + (64 - 4) * SUB_BUCKETS;
+
+            void add(const uint64_t& nanoseconds);
+            void merge(const Histogram& other);
+            inline uint64_t getCount() const { return count; }
+            inline uint64_t getTotal() const { return total; }
+            inline uint64_t getMax() const { return max; }
+            // The middle of the bucket holding the `fraction` quantile, 0 when empty
+            uint64_t getPercentile(const double& fraction) const;
+
+            static uint32_t getBucket(const uint64_t& nanoseconds);
+            static uint64_t getBucketMiddle(const uint32_t& bucket);
+
+        private:
+            std::array<uint64_t, BUCKET_COUNT> buckets{};
+            uint64_t count = 0;
+            uint64_t total = 0;
+            uint64_t max = 0;
+    };
+
+    struct PhaseSummary {
+        Phase phase;
+        uint64_t count;
+        uint64_t totalNanoseconds;
+        uint64_t p50Nanoseconds;
+        uint64_t p99Nanoseconds;
+        uint64_t maxNanoseconds;
+    };
+
+    // Collects the ECOSIM_PROFILE_SCOPE timers. Off until setEnabled(true);
+    // while off a timer costs one relaxed load. Each thread records into a
+    // log of its own, so timers never lock or share cache lines; readers
+    // (getSummary, writeChromeTrace, reset) merge the logs and must run
+    // between ticks.
+    class Profiler {
+        public:
+            // Trace events kept per thread; later ones are counted and dropped
+            static constexpr size_t MAX_TRACE_EVENTS = 1 << 21;
+
+            static Profiler& getInstance() {
+                static Profiler instance;
+                return instance;
+            }
+
+            Profiler(const Profiler&) = delete;
+            Profiler& operator=(const Profiler&) = delete;
+
+            static inline bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+            void setEnabled(const bool& enable);
+            // Also keeps every timed scope of the next `ticks` ticks (ended by
+            // Phase::Tick) for writeChromeTrace; enables the profiler
+            void startTrace(const uint32_t& ticks);
+            inline bool isTracing() const { return tracing.load(std::memory_order_relaxed); }
+
+            // Histograms merged over all threads, phases that never ran left out
+            std::vector<PhaseSummary> getSummary() const;
+            void printSummary(std::ostream& out) const;
+            // Chrome trace_event JSON, for chrome://tracing or ui.perfetto.dev.
+            // Throws std::runtime_error when the file cannot be written.
+            void writeChromeTrace(const std::string& path) const;
+            uint64_t getDroppedTraceEvents() const;
+            // Forgets every timing and trace event
+            void reset();
+
+            // Called by ScopedTimer; times are steady_clock nanoseconds
+            void record(const Phase& phase, const uint64_t& start, const uint64_t& end);
+
+            static inline uint64_t now() {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+
+        private:
+            struct TraceEvent {
+                uint64_t start;
+                uint64_t duration;
+                Phase phase;
+            };
+            struct ThreadLog {
+                uint32_t thread = 0;
+                std::array<Histogram, PHASE_COUNT> histograms;
+                std::vector<TraceEvent> trace;
+                uint64_t droppedEvents = 0;
+            };
+
+            Profiler() = default;
+            ThreadLog& getThreadLog();
+
+            static std::atomic<bool> enabled;
+            std::atomic<bool> tracing{false};
+            std::atomic<uint32_t> traceTicksLeft{0};
+            uint64_t traceOrigin = 0;
+            mutable std::mutex mutex;                       // Guards `logs`; timers only take it once per thread
+            std::vector<std::unique_ptr<ThreadLog>> logs;   // Outlive their threads
+    };
+
+    // Times its scope into the profiler, when it is enabled at construction
+    class ScopedTimer {
+        public:
+            explicit ScopedTimer(const Phase& phase) : phase(phase), start(Profiler::isEnabled() ? Profiler::now() : 0) {}
+            ~ScopedTimer() {
+                if (start != 0)
+                    Profiler::getInstance().record(phase, start, Profiler::now());
+            }
+
+            ScopedTimer(const ScopedTimer&) = delete;
+            ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        private:
+            Phase phase;
+            uint64_t start;
+    };
+}
+
+#define ECOSIM_PROFILE_CONCAT_INNER(a, b) a##b
+#define ECOSIM_PROFILE_CONCAT(a, b) ECOSIM_PROFILE_CONCAT_INNER(a, b)
+
+#if ECOSIM_PROFILE
+    #define ECOSIM_PROFILE_SCOPE(phase) ::profiler::ScopedTimer ECOSIM_PROFILE_CONCAT(profileScope, __LINE__)(phase)
+#else
+    #define ECOSIM_PROFILE_SCOPE(phase) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <map>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <SFML/Graphics.hpp>
+
+struct WorldSnapshot;
+
+namespace renderer {
+    // Draws world snapshots with a level of detail picked from the target's
+    // view. Close up, the visible cells are tileSize x tileSize tiles: the
+    // sprites are packed into one atlas texture and every visible cell is a
+    // quad of one vertex array, so a frame is a single draw call. The quads
+    // stay put while the view does, and between frames only those whose
+    // cell looks different are rewritten. Zoomed out below
+    // DETAIL_PIXELS a cell, the visible blocks of the snapshot's density
+    // pyramid as one texture, at the finest level whose blocks are still
+    // BLOCK_PIXELS wide. Either way a frame costs about what the window
+    // can show, however large the world is.
+    class TileRenderer {
+        public:
+            // What zoomed-out blocks show: species colours mixed by head
+            // count, or the energy held per cell as a heatmap
+            enum class Overlay { Species, Energy };
+
+            static constexpr float DETAIL_PIXELS = 6.0f;
+            static constexpr float BLOCK_PIXELS = 2.0f;
+
+            // Sprites by cell symbol; ' ' is the empty tile and stands in for
+            // symbols without a sprite. Throws std::runtime_error when it is
+            // missing or the sprites do not fit in one texture.
+            TileRenderer(const std::map<char, sf::Texture>& textures, const uint32_t& tileSize);
+
+            // Draws the part of a snapshot the target's view can see, see
+            // SimulationThread
+            void render(const WorldSnapshot& snapshot, sf::RenderTarget& target);
+
+            inline void setOverlay(const Overlay& shown) { overlay = shown; }
+            inline Overlay getOverlay() const { return overlay; }
+            // Screen pixels across one cell under the target's view
+            float getCellPixels(const sf::RenderTarget& target) const;
+            inline const sf::Texture& getAtlas() const { return atlas; }
+
+        private:
+            // Half-open ranges of rows and columns, `side` view units apart,
+            // that the target's (unrotated) view can see
+            struct Visible {
+                int firstRow, endRow, firstColumn, endColumn;
+            };
+            Visible getVisible(const sf::RenderTarget& target, const float& side, const int& rows, const int& columns) const;
+
+            // Lays out a quad for every cell of `visible`, none of them painted yet
+            void place(const Visible& visible, const int& rows, const int& columns);
+            void paintQuad(sf::Vertex* quad, const uint32_t& look) const;
+            void drawTiles(const WorldSnapshot& snapshot, sf::RenderTarget& target);
+            void drawDensity(const WorldSnapshot& snapshot, sf::RenderTarget& target);
+
+            sf::Texture atlas;
+            std::array<sf::FloatRect, 256> regions;     // Atlas area of each symbol's sprite
+            uint32_t tileSize;
+            Overlay overlay = Overlay::Species;
+            int rows = 0;                               // Snapshot size the quads were placed for
+            int columns = 0;
+            Visible placed = {0, 0, 0, 0};              // Cells the quads cover
+            sf::VertexArray quads;                      // Four vertices per cell of `placed`, row-major
+            std::vector<uint32_t> drawn;                // What each quad shows, see appearance()
+            sf::Texture blocks;                         // Snapshot density of the current frame, a pixel a block
+            std::vector<sf::Uint8> blockPixels;
+    };
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Counter-based random numbers. A draw is a pure function of
+// (seed, tick, key, stream, counter), so any draw can be computed on any
+// thread, in any order, one at a time or in blocks, and seeded runs repeat.
+namespace rng {
+    // Streams used by the simulation, so different decisions never share draws
+    enum Stream : uint32_t {
+        FLEE_STREAM = 1,
+        WANDER_STREAM,
+        PRIORITY_STREAM,
+        ENTITY_ID_STREAM,
+        WORLD_STREAM,
+        POPULATE_STREAM,
+        BIRTH_STREAM
+    };
+
+    // SplitMix64 finalizer
+    inline uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // SplitMix64: advances state and returns the next draw
+    inline uint64_t splitMix(uint64_t& state) {
+        return mix(state += 0x9E3779B97F4A7C15ULL);
+    }
+
+    // Per-tick part of a draw, shared by every key in that tick
+    inline uint64_t tickKey(const uint64_t& seed, const uint64_t& tick) {
+        return mix(seed + (tick + 1) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    inline uint64_t draw(const uint64_t& tickKey, const uint64_t& key, const uint32_t& stream, const uint32_t& counter) {
+        uint64_t z = mix(tickKey ^ (key * 0xD6E8FEB86659FD93ULL));
+        return mix(z + ((static_cast<uint64_t>(stream) << 32) | counter) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    // The counter-th draw of `stream` for `key` (an entity id, a cell, ...) at `tick`
+    inline uint64_t draw(const uint64_t& seed, const uint64_t& tick, const uint64_t& key, const uint32_t& stream, const uint32_t& counter = 0) {
+        return draw(tickKey(seed, tick), key, stream, counter);
+    }
+
+    // out[i] = draw(tickKey, keys[i], stream, counter); a plain loop the compiler can vectorise
+    inline void drawBlock(const uint64_t& tickKey, const uint64_t* keys, const size_t& count,
+                          const uint32_t& stream, const uint32_t& counter, uint64_t* out) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = draw(tickKey, keys[i], stream, counter);
+        }
+    }
+
+    inline void drawBlock(const uint64_t& seed, const uint64_t& tick, const uint64_t* keys, const size_t& count,
+                          const uint32_t& stream, const uint32_t& counter, uint64_t* out) {
+        drawBlock(tickKey(seed, tick), keys, count, stream, counter, out);
+    }
+
+    // Uniform double in [0, 1)
+    inline double uniform(const uint64_t& bits) {
+        return (bits >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Uniform integer in [0, bound)
+    inline uint32_t below(const uint64_t& bits, const uint32_t& bound) {
+        return static_cast<uint32_t>(((bits >> 32) * bound) >> 32);
+    }
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include <vector>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <exception>
+
+#include "Snapshot.h"
+
+class World;
+
+// Runs a world's ticks on a thread of its own, either flat out or at a tick
+// rate, and publishes a WorldSnapshot after every tick through a
+// TripleBuffer. A viewer draws the latest snapshot whenever it is ready for
+// a frame, so slow frames never hold the simulation back and a fast
+// simulation never waits for the screen.
+//
+// Snapshots are kept up to date incrementally: each of the three copies is
+// patched with the cells that changed since it was last written, from the
+// world's change tracking, and copied whole only when that is unknown.
+class SimulationThread {
+    public:
+        // Called on the simulation thread before each tick, e.g. to spawn plants
+        typedef std::function<void(World&)> TickHook;
+
+        // Starts ticking `world`, which belongs to the thread until stop().
+        // Starts paused if `paused`; the first snapshot is published before any tick.
+        SimulationThread(World& world, const TickHook& beforeTick = TickHook(), const bool& paused = false);
+        // Stops the thread, dropping any error it hit
+        ~SimulationThread();
+
+        SimulationThread(const SimulationThread&) = delete;
+        SimulationThread& operator=(const SimulationThread&) = delete;
+
+        // Joins the thread; rethrows the exception that stopped it, if any
+        void stop();
+        // False once stopped, or after a tick threw
+        inline bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+        // Ticks per second at speed 1; 0 runs as fast as possible
+        void setTickRate(const double& ticksPerSecond);
+        inline double getTickRate() const { return tickRate.load(std::memory_order_relaxed); }
+        // Multiplies the tick rate, for fast-forward and slow motion
+        void setSpeed(const double& multiplier);
+        inline double getSpeed() const { return speed.load(std::memory_order_relaxed); }
+        void setPaused(const bool& pause);
+        inline bool isPaused() const { return paused.load(std::memory_order_relaxed); }
+        // While paused, runs `ticks` more ticks as fast as possible
+        void step(const uint32_t& ticks = 1);
+
+        // Reader side: the latest snapshot, valid until the next call. Call it
+        // from one thread only.
+        inline const WorldSnapshot* getLatestSnapshot() { return snapshots.getLatest(); }
+        inline uint64_t getTicksRun() const { return ticksRun.load(std::memory_order_relaxed); }
+
+    private:
+        void loop();
+        void publish();
+        // How long to wait after a tick; zero when uncapped, paused or stepping
+        std::chrono::duration<double> getTickPeriod() const;
+
+        World& world;
+        TickHook beforeTick;
+        TripleBuffer<WorldSnapshot> snapshots;
+        // Cells changed since each copy was last written; stale copies are rewritten whole
+        std::vector<uint32_t> pending[3];
+        bool stale[3] = {true, true, true};
+        std::vector<uint32_t> changed;
+
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable control;
+        bool stopping = false;
+        uint32_t steps = 0;
+        std::atomic<bool> paused{false};
+        std::atomic<bool> running{true};
+        std::atomic<double> tickRate{0.0};
+        std::atomic<double> speed{1.0};
+        std::atomic<uint64_t> ticksRun{0};
+        std::exception_ptr error;
+};
+
+#endif
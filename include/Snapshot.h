@@ -0,0 +1,67 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "AnimalConfig.h"
+#include "DensityPyramid.h"
+
+// Read-only picture of the world after a tick, for drawing it on another
+// thread while the simulation runs on. See World::updateSnapshot.
+struct WorldSnapshot {
+    uint64_t tick = 0;
+    int rows = 0;
+    int columns = 0;
+    std::vector<animalconfig::SpeciesId> species;   // Row-major, NO_SPECIES where empty
+    std::vector<uint32_t> energy;                   // Row-major, 0 where empty
+    std::vector<int64_t> counts;                    // Agents by species id
+    uint64_t occupied = 0;
+    DensityPyramid density;                         // The cells above, downsampled for zoomed-out views
+
+    inline uint32_t getCellId(const int& x, const int& y) const { return x * columns + y; }
+};
+
+// Three copies of a T shared by one writer and one reader. The writer fills
+// the back copy and publishes it; the reader takes the most recently
+// published copy. Publishing and taking swap indices with one atomic
+// exchange, so neither side ever waits for the other, and a copy the reader
+// holds is never written until the reader takes a newer one.
+template <typename T>
+class TripleBuffer {
+    public:
+        TripleBuffer() = default;
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        // Writer side
+        inline T& getBack() { return buffers[back]; }
+        inline size_t getBackIndex() const { return back; }
+        void publish() {
+            back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+        }
+
+        // Reader side: the latest published copy, or nullptr before the first
+        // publish. Stays untouched until the next call.
+        const T* getLatest() {
+            if (middle.load(std::memory_order_relaxed) & FRESH) {
+                front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+                published = true;
+            }
+            return published ? &buffers[front] : nullptr;
+        }
+
+    private:
+        static constexpr uint8_t INDEX = 3;
+        static constexpr uint8_t FRESH = 4;     // The middle copy was published after the reader's last take
+
+        T buffers[3];
+        uint8_t back = 0;                       // Writer only
+        std::atomic<uint8_t> middle{1};
+        uint8_t front = 2;                      // Reader only
+        bool published = false;                 // Reader only
+};
+
+#endif
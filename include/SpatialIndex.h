@@ -0,0 +1,154 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Kinematics.h"
+#include "BitGrid.h"
+#include "AnimalConfig.h"
+
+// One occupancy bitplane per species, for nearest-neighbour queries.
+// Planes share the BitGrid row padding, so different rows can be updated
+// from different threads.
+class SpatialIndex {
+    public:
+        void resize(const uint32_t& rows, const uint32_t& cols);
+        void clear();
+
+        inline void set(const animalconfig::SpeciesId& species, const uint32_t& row, const uint32_t& col) {
+            if (species >= planes.size()) {
+                addPlanes(species);
+            }
+            planes[species].set(row, col);
+        }
+        inline void reset(const animalconfig::SpeciesId& species, const uint32_t& row, const uint32_t& col) {
+            if (species < planes.size()) {
+                planes[species].reset(row, col);
+            }
+        }
+        inline bool test(const animalconfig::SpeciesId& species, const uint32_t& row, const uint32_t& col) const {
+            return species < planes.size() && planes[species].test(row, col);
+        }
+
+        // Nearest cell (Manhattan distance) holding any of `species` inside the
+        // (2 * range + 1)^2 window around pos, not counting pos itself. Ties go
+        // to the first cell in row-major order; (-1, -1) when there is none.
+        kinematics::Vector2D findNearest(const kinematics::Vector2D& pos, const int& range,
+                                         const animalconfig::SpeciesId* species, const size_t& count) const;
+
+        // The search behind findNearest, over any bit layout: rowAt(x)[w] must
+        // give the 64 cells of row x starting at column 64 * w.
+        template <typename RowAt>
+        static kinematics::Vector2D findNearestBit(const kinematics::Vector2D& size, const kinematics::Vector2D& pos,
+                                                   const int& range, RowAt rowAt);
+
+        void pauseCount();
+        void resumeCount();
+        // Creates the planes up to `species` so set() never grows the index,
+        // for writers on several threads
+        inline void reserve(const animalconfig::SpeciesId& species) {
+            if (species >= planes.size()) {
+                addPlanes(species);
+            }
+        }
+
+        // nullptr until the species has been placed once
+        inline const BitGrid* getPlane(const animalconfig::SpeciesId& species) const { return species < planes.size() ? &planes[species] : nullptr; }
+        inline uint32_t getCount(const animalconfig::SpeciesId& species) const { return species < planes.size() ? planes[species].getCount() : 0; }
+        inline uint32_t getRows() const { return numRows; }
+        inline uint32_t getCols() const { return numCols; }
+        inline size_t getMemoryBytes() const { return planes.size() * (planes.empty() ? 0 : planes[0].getMemoryBytes()); }
+
+    private:
+        void addPlanes(const animalconfig::SpeciesId& species);
+
+        std::vector<BitGrid> planes;
+        uint32_t numRows = 0;
+        uint32_t numCols = 0;
+        bool counting = true;
+};
+
+// Rows are visited outward from pos (|dx| = 0, 1, 2, ...). In each row the
+// nearest set column on either side of pos is found a word at a time, and the
+// search stops once |dx| alone is further than the best hit so far.
+template <typename RowAt>
+kinematics::Vector2D SpatialIndex::findNearestBit(const kinematics::Vector2D& size, const kinematics::Vector2D& pos,
+                                                  const int& range, RowAt rowAt) {
+    kinematics::Vector2D nearest(-1, -1);
+    const int minRow = std::max(0, pos.x - range);
+    const int maxRow = std::min(size.x - 1, pos.x + range);
+    const int minCol = std::max(0, pos.y - range);
+    const int maxCol = std::min(size.y - 1, pos.y + range);
+
+    int best = INT32_MAX;
+    for (int dx = 0; dx <= range && dx <= best; ++dx) {
+        for (int side = 0; side < 2; ++side) {
+            if (dx == 0 && side == 1)
+                break;
+            int x = side == 0 ? pos.x - dx : pos.x + dx;
+            if (x < minRow || x > maxRow)
+                continue;
+
+            const auto row = rowAt(x);
+
+            // Columns further than best - dx cannot win
+            int reach = best == INT32_MAX ? range : best - dx;
+            int lo = std::max(minCol, pos.y - reach);
+            int hi = std::min(maxCol, pos.y + reach);
+            int center = dx == 0 ? 1 : 0;   // pos itself is not a candidate
+
+            // Last set column in [lo, pos.y - center]
+            int left = -1;
+            int from = pos.y - center;
+            if (from >= lo) {
+                int word = from >> 6;
+                uint64_t bits = row[word] & (~0ULL >> (63 - (from & 63)));
+                while (true) {
+                    if (bits != 0) {
+                        int col = (word << 6) + BitGrid::highestBit(bits);
+                        left = col >= lo ? col : -1;
+                        break;
+                    }
+                    if (--word < (lo >> 6))
+                        break;
+                    bits = row[word];
+                }
+            }
+
+            // First set column in [pos.y + center, hi]
+            int right = -1;
+            from = pos.y + center;
+            if (from <= hi) {
+                int word = from >> 6;
+                uint64_t bits = row[word] & (~0ULL << (from & 63));
+                while (true) {
+                    if (bits != 0) {
+                        int col = (word << 6) + BitGrid::lowestBit(bits);
+                        right = col <= hi ? col : -1;
+                        break;
+                    }
+                    if (++word > (hi >> 6))
+                        break;
+                    bits = row[word];
+                }
+            }
+
+            int col = (left != -1 && (right == -1 || pos.y - left <= right - pos.y)) ? left : right;
+            if (col == -1)
+                continue;
+
+            int dist = dx + abs(col - pos.y);
+            if (dist < best || (dist == best && (x < nearest.x || (x == nearest.x && col < nearest.y)))) {
+                best = dist;
+                nearest = kinematics::Vector2D(x, col);
+            }
+        }
+    }
+    return nearest;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef VISIONKERNEL_H
+#define VISIONKERNEL_H
+
+#include <cstdint>
+
+#include "Kinematics.h"
+
+// Window searches over byte-per-cell planes (species ids or ranks), 64 cells
+// per step. The compare runs on AVX2, SSE4.1 or plain C++, picked at startup
+// from what the CPU supports.
+namespace vision {
+    // Kernels read whole 64-byte blocks, so planes need this many readable
+    // bytes past their last cell
+    const uint32_t PLANE_PADDING = 64;
+
+    // Cells whose value lies in [lo, hi]
+    struct Match {
+        uint8_t lo;
+        uint8_t hi;
+    };
+
+    enum class Kernel { Scalar, SSE41, AVX2 };
+
+    // Widest kernel this CPU runs
+    Kernel getBestKernel();
+    Kernel getKernel();
+    // Falls back to the best supported kernel if `kernel` is not
+    void setKernel(Kernel kernel);
+    const char* getKernelName(Kernel kernel);
+
+    // Bit i is set when cells[i] matches, for the 64 cells from `cells`
+    uint64_t matchBlock(const uint8_t* cells, const Match& match);
+
+    // Nearest matching cell (Manhattan distance) inside the (2 * range + 1)^2
+    // window around pos, not counting pos itself. Ties go to the first cell in
+    // row-major order; (-1, -1) when there is none. Same answers as
+    // SpatialIndex::findNearest.
+    kinematics::Vector2D findNearest(const uint8_t* plane, const kinematics::Vector2D& size,
+                                     const kinematics::Vector2D& pos, const int& range, const Match& match);
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <vector>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of threads that run batches of indexed tasks. The calling thread
+// takes part as worker 0, so a pool of n threads starts n - 1 of its own.
+class WorkerPool {
+    public:
+        // task(index, worker) with index in [0, count) and worker in [0, getThreadCount())
+        typedef std::function<void(uint32_t, uint32_t)> Task;
+
+        explicit WorkerPool(uint32_t threadCount);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        // Runs every task index once and returns when all of them are done
+        void run(const uint32_t& count, const Task& task);
+        // The same on `pool`, or in index order on the calling thread, as
+        // worker 0, when there is no pool
+        static void run(WorkerPool* pool, const uint32_t& count, const Task& task);
+
+        inline uint32_t getThreadCount() const { return threads.size() + 1; }
+
+    private:
+        void workerLoop(uint32_t worker);
+        void drain(uint32_t worker);
+
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable finished;
+
+        const Task* task = nullptr;
+        uint32_t taskCount = 0;
+        std::atomic<uint32_t> nextIndex{0};
+        uint32_t generation = 0;
+        uint32_t running = 0;
+        bool stopping = false;
+};
+
+#endif
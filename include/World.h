@@ -2,26 +2,245 @@
 #define WORLD_H
 
 #include <vector>
-#include <unordered_set>
 #include <cstdint>
 #include <memory>
 #include <iostream>
-#include <SFML/Graphics.hpp>
-#include <map>
+#include <climits>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <exception>
 
-#include "kinematics.h"
-class Entity;
+#include "Kinematics.h"
+#include "BitGrid.h"
+#include "OccupancyGrid.h"
+#include "SpatialIndex.h"
+#include "DistanceField.h"
+#include "VisionKernel.h"
+#include "ChunkedGrid.h"
+#include "ObjectPool.h"
+#include "EntityStore.h"
+#include "WorkerPool.h"
+#include "EventLog.h"
+#include "PopulationStats.h"
+#include "Logger.h"
+#include "Snapshot.h"
+#include "Rng.h"
+#include "Entity.h"
 
 class World {
+    public:
+        // Objects: one pooled Entity per agent (default).
+        // Dense: struct-of-arrays EntityStore addressed by slot index.
+        enum class StorageMode { Objects, Dense };
+        // Sweep: agents act one after another on the live grid.
+        // Intent: agents plan against the frozen grid, then one commit pass
+        // resolves conflicts, so results do not depend on sweep order or threads.
+        enum class TickEngine { Sweep, Intent };
+        // How the intent engine finds prey and predators.
+        // Scan: search the species index around every agent.
+        // Field: build one distance field per target once per tick and read it;
+        // vision then counts steps (a diamond) rather than a square window.
+        enum class NearestSearch { Scan, Field };
+        // One species for populate(). Uniform: any empty cell. Clustered:
+        // Gaussian blobs `spread` cells wide around `clusters` random centres.
+        // PoissonDisk: no two agents of the species within `spacing` cells of
+        // each other (per axis); fewer than asked are placed once none fit.
+        struct Population {
+            enum class Pattern { Uniform, Clustered, PoissonDisk };
+            animalconfig::SpeciesId species = animalconfig::NO_SPECIES;
+            uint64_t count = 0;         // Agents to place; 0 uses density
+            double density = 0.0;       // Fraction of all cells
+            Pattern pattern = Pattern::Uniform;
+            uint32_t clusters = 1;
+            double spread = 4.0;
+            uint32_t spacing = 2;
+        };
+        // Flat: every cell allocated up front (default).
+        // Chunked: 64x64 chunks allocated as they fill, for huge sparse maps.
+        // Objects storage, the sweep engine and a single thread only.
+        enum class GridLayout { Flat, Chunked };
+
     private:
-        std::vector<std::vector<Entity*>> grid;
-        std::unordered_set<uint32_t> gridOccupied;
+        // Row-major cells, indexed by getCellId(x, y)
+        std::vector<Entity*> grid;
+        OccupancyGrid gridOccupied;
+        SpatialIndex speciesIndex;      // Per-species occupancy, for nearest searches
+        ObjectPool<Entity> entityPool;
         static World* instancePtr;
+
+        // Dense storage mode, see DenseWorld.cpp
+        StorageMode storageMode = StorageMode::Objects;
+        EntityStore denseStore;
+        std::vector<uint32_t> denseGrid;
+        std::vector<animalconfig::SpeciesId> denseCellSpecies;    // NO_SPECIES when empty
+
+        // Chunked layout, replaces grid, gridOccupied and speciesIndex
+        GridLayout gridLayout = GridLayout::Flat;
+        ChunkedGrid chunkedGrid;
+        void runChunked();
+
+        void updateDense(const uint32_t& index);
+        bool reproduceDense(const uint32_t& index);
+        void feedDense(const uint32_t& index, uint32_t prey);
+        void moveRandomDense(const uint32_t& index);
+        void moveAwayDense(const uint32_t& index, const kinematics::Vector2D& threat);
+        void moveTowardsDense(const uint32_t& index, const kinematics::Vector2D& target);
+        void relocateDense(const uint32_t& index, const kinematics::Vector2D& from);
+        kinematics::Vector2D findNearestPreyDense(const uint32_t& index) const;
+        kinematics::Vector2D findNearestPredatorDense(const uint32_t& index) const;
+        inline animalconfig::SpeciesId getDenseSpecies(const int& x, const int& y) const { return denseCellSpecies[x * size.y + y]; }
+        inline void placeDense(const uint32_t& index, const int& x, const int& y) {
+            uint32_t cellId = x * size.y + y;
+            denseGrid[cellId] = index;
+            denseCellSpecies[cellId] = denseStore.species[index];
+            gridOccupied.set(x, y);
+            speciesIndex.set(denseStore.species[index], x, y);
+            markChanged(cellId);
+        }
+        inline void vacateDense(const int& x, const int& y) {
+            uint32_t cellId = x * size.y + y;
+            denseGrid[cellId] = EntityStore::INVALID;
+            speciesIndex.reset(denseCellSpecies[cellId], x, y);
+            denseCellSpecies[cellId] = animalconfig::NO_SPECIES;
+            gridOccupied.reset(x, y);
+            markChanged(cellId);
+        }
+
+        // Striped parallel ticks, see ParallelWorld.cpp
+        struct StripeContext {
+            std::vector<Entity*> retiredEntities;   // Released to the pool after the phase
+            std::vector<uint32_t> retiredSlots;     // Removed from the store after the phase
+            std::vector<EventLog::Event> events;    // Recorded by this worker, see EventLog.h
+            std::vector<std::pair<uint32_t, size_t>> eventStripes;   // (stripe, its first event) per stripe updated
+            std::vector<PopulationStats::Tally> tallies = std::vector<PopulationStats::Tally>(PopulationStats::MAX_SPECIES);
+            std::vector<uint32_t> changedCells;     // Merged into World::changedCells
+        };
+        // Set while the current thread updates a stripe
+        static thread_local StripeContext* stripeContext;
+        std::unique_ptr<WorkerPool> workers;
+        std::vector<StripeContext> stripeContexts = std::vector<StripeContext>(1);
+        std::mutex spawnMutex;
+
+        // Population statistics; stripes count into their own tallies,
+        // merged by retireDeferred()
+        PopulationStats stats;
+        inline PopulationStats::Tally& tallyFor(const animalconfig::SpeciesId& species) {
+            return stripeContext != nullptr ? stripeContext->tallies[species] : stats.getTallies()[species];
+        }
+        inline void noteArrival(const animalconfig::SpeciesId& species, const uint32_t& energy) {
+            PopulationStats::Tally& tally = tallyFor(species);
+            ++tally.count;
+            tally.energy += energy;
+        }
+        inline void noteDeath(const animalconfig::SpeciesId& species, const uint32_t& energy) {
+            PopulationStats::Tally& tally = tallyFor(species);
+            --tally.count;
+            tally.energy -= energy;
+            ++tally.deaths;
+        }
+        inline void setDenseEnergy(const uint32_t& index, const uint32_t& energy) {
+            noteEnergy(denseStore.posX[index] * size.y + denseStore.posY[index], denseStore.species[index], denseStore.energy[index], energy);
+            denseStore.energy[index] = energy;
+        }
+
+        // Cells whose agent arrived, left or changed energy since the last
+        // takeChangedCells(); stripes collect their own, merged by retireDeferred()
+        bool trackChanges = false;
+        bool changesOverflowed = true;      // Too many, or not tracked: treat every cell as changed
+        std::vector<uint32_t> changedCells;
+        // Only tracked on worlds whose cell ids fit 32 bits, see setChangeTracking
+        inline void markChanged(const uint64_t& cellId) {
+            if (!trackChanges)
+                return;
+            if (stripeContext != nullptr) {
+                stripeContext->changedCells.push_back(cellId);
+            } else if (changedCells.size() < getCellCount()) {
+                changedCells.push_back(cellId);
+            } else {
+                changesOverflowed = true;
+            }
+        }
+
+        // Random draws, see Rng.h
+        uint64_t seed = 0;
+        uint64_t tick = 0;
+        uint64_t tickKey = rng::tickKey(0, 0);
+        uint64_t worldDraws = 0;
+        // Bumped every sweep tick; agents stamp it when they act
+        uint32_t generation = 0;
+
+        void runStriped();
+        void updateStripe(const uint32_t& firstRow, const uint32_t& endRow, const bool& herbivoresOnly, const animalconfig::SpeciesId& herbivore);
+        void updateStripeDense(const uint32_t& firstRow, const uint32_t& endRow, const bool& herbivoresOnly, const animalconfig::SpeciesId& herbivore);
+        void retireDeferred();
+
+        // Bulk seeding, see Populate.cpp
+        void spawnSpecies(const animalconfig::SpeciesId& species, const kinematics::Vector2D& pos);
+        uint64_t placePoissonDisk(const animalconfig::SpeciesId& species, const uint64_t& count, const uint32_t& spacing);
+        void placeClustered(const animalconfig::SpeciesId& species, const uint64_t& count, const uint32_t& clusters, const double& spread);
+        std::vector<kinematics::Vector2D> pickEmptyCellsDense(const uint64_t& count);
+        void placeBatch(const std::vector<kinematics::Vector2D>& cells, const std::vector<animalconfig::SpeciesId>& species);
+
+        // Cell id of the rank-th empty cell, see FreeCellIndex::select
+        inline uint64_t findFreeCell(const uint64_t& rank) const {
+            return gridLayout == GridLayout::Chunked ? chunkedGrid.findFree(rank) : gridOccupied.findFree(rank);
+        }
+
+        // Intent engine, see IntentWorld.cpp
+        struct Intent {
+            enum class Action : uint8_t { Die, Stay, Move, Displace, Reproduce };
+            uint32_t source;        // Cell of the acting agent
+            uint32_t target;        // Destination, prey or birth cell
+            uint32_t energy;        // Energy after the action succeeds
+            uint32_t priority;      // Random tie-break between equal ranks
+            uint8_t rank;
+            Action action;
+            bool eats;              // Displace gains energy from the occupant
+        };
+        TickEngine tickEngine = TickEngine::Sweep;
+        std::vector<std::vector<Intent>> intentBuffers;     // One per worker
+        std::vector<animalconfig::SpeciesId> intentPlane;   // Frozen species plane (objects storage)
+        std::vector<uint8_t> intentRanks;                   // Frozen rank plane
+        std::vector<uint8_t> intentDead;                    // Cells whose agent dies this tick
+        NearestSearch nearestSearch = NearestSearch::Scan;
+        std::vector<DistanceField> preyFields;              // By hunted species
+        std::vector<DistanceField> predatorFields;          // By threatened species
+
+        void runIntent();
+        void buildFields();
+        void planRows(const uint32_t& firstRow, const uint32_t& endRow, const animalconfig::SpeciesId* plane, const uint8_t* ranks, std::vector<Intent>& intents) const;
+        void commitIntents();
+        uint32_t getEnergyAt(const uint32_t& cellId) const;
+        uint64_t getIdAt(const uint32_t& cellId) const;
+        void setEnergyAt(const uint32_t& cellId, const uint32_t& energy);
+        void killAt(const uint32_t& cellId);
+        void moveAt(const uint32_t& from, const uint32_t& to);
+        void recordAt(const EventLog::Type& type, const uint32_t& from, const uint32_t& to);
+
+        // Checkpoints, see Checkpoint.cpp
+        std::thread checkpointThread;
+        std::exception_ptr checkpointError;
+        std::vector<char> captureCheckpoint() const;
+
+        // Event recording, see EventLog.cpp
+        std::unique_ptr<EventLog> eventLog;
+        std::vector<EventLog::Event> serialEvents;  // Recorded outside parallel stripes
+        struct StripeEvents {
+            uint32_t stripe;
+            const EventLog::Event* first;
+            size_t count;
+        };
+        std::vector<StripeEvents> phaseEvents;      // Scratch for appendPhaseEvents
+        void appendPhaseEvents();
+        void flushEvents();
     
     public:
         // Protected constructor for testing
         World();
         World(int width, int height);
+        // Waits for a background checkpoint write
+        ~World();
         kinematics::Vector2D size;
         
         // For production code
@@ -38,50 +257,245 @@ class World {
 
         void initialize(int width, int height) {
             size = kinematics::Vector2D(width, height);
-            grid.resize(height, std::vector<Entity*>(width, nullptr));
+            changesOverflowed = true;
+            size_t cellCount = static_cast<size_t>(width) * height;
+            if (gridLayout == GridLayout::Chunked) {
+                grid.clear();
+                gridOccupied.resize(0, 0);
+                speciesIndex.resize(0, 0);
+                chunkedGrid.resize(width, height);
+                return;
+            }
+            chunkedGrid.resize(0, 0);
+            if (storageMode == StorageMode::Dense) {
+                grid.clear();
+                denseGrid.assign(cellCount, EntityStore::INVALID);
+                // Padded so vision kernels can read whole blocks at the last row
+                denseCellSpecies.assign(cellCount + vision::PLANE_PADDING, animalconfig::NO_SPECIES);
+            } else {
+                grid.assign(cellCount, nullptr);
+                denseGrid.clear();
+                denseCellSpecies.clear();
+            }
+            gridOccupied.resize(width, height);
+            speciesIndex.resize(width, height);
         }
 
+        // Must be called while the world is empty
+        void setStorageMode(StorageMode mode);
+        inline StorageMode getStorageMode() const { return storageMode; }
+        // Must be called while the world is empty, before initialize() for maps
+        // too big to allocate flat
+        void setGridLayout(GridLayout layout);
+        inline GridLayout getGridLayout() const { return gridLayout; }
+        inline const ChunkedGrid& getChunkedGrid() const { return chunkedGrid; }
+        uint32_t spawnDense(char symbol, const kinematics::Vector2D& pos);
+        uint32_t spawnDense(const animalconfig::SpeciesId& species, const kinematics::Vector2D& pos);
+        uint32_t spawnDense(const animalconfig::SpeciesId& species, const kinematics::Vector2D& pos, const uint64_t& id);
+        void killDense(uint32_t index);
+        inline const EntityStore& getEntityStore() const { return denseStore; }
+        inline uint32_t getSlotAt(const int& x, const int& y) const {
+            return (storageMode == StorageMode::Dense && isInside(x, y)) ? denseGrid[getCellId(x, y)] : EntityStore::INVALID;
+        }
+
+        // Threads used by run(); 0 picks the hardware concurrency. The sweep
+        // runs the same stripes on any number of threads, so the count only
+        // changes how fast a tick is, never its outcome.
+        void setThreadCount(uint32_t count);
+        inline uint32_t getThreadCount() const { return workers ? workers->getThreadCount() : 1; }
+        // Height of the row stripes updated in parallel: more than any species can see
+        uint32_t getStripeRows() const;
+
+        // Seeds every random draw and restarts the tick counter
+        void setSeed(const uint64_t& newSeed) {
+            seed = newSeed;
+            tick = 0;
+            tickKey = rng::tickKey(seed, tick);
+            worldDraws = 0;
+        }
+        inline uint64_t getSeed() const { return seed; }
+        inline uint64_t getTick() const { return tick; }
+        // The counter-th draw of `stream` for one entity in the current tick
+        inline uint64_t drawFor(const uint64_t& entityId, const uint32_t& stream, const uint32_t& counter = 0) const {
+            return rng::draw(tickKey, entityId, stream, counter);
+        }
+        // drawFor over a block of entities: out[i] = drawFor(entityIds[i], stream, counter)
+        inline void drawBlockFor(const uint64_t* entityIds, const size_t& count, const uint32_t& stream, uint64_t* out, const uint32_t& counter = 0) const {
+            rng::drawBlock(tickKey, entityIds, count, stream, counter, out);
+        }
+        // Next draw of the world's own stream, for seeding and spawning between ticks
+        inline uint64_t drawRandom() { return rng::draw(tickKey, worldDraws++, rng::WORLD_STREAM, 0); }
+        // Id for an entity seeded or spawned between ticks, the next draw of
+        // the world's own counter
+        inline uint64_t newEntityId() { return rng::draw(tickKey, worldDraws++, rng::ENTITY_ID_STREAM, 0); }
+        // Id for a child born this tick. A parent reproduces at most once a
+        // tick, so ids only repeat on a 64-bit hash collision.
+        inline uint64_t childEntityId(const uint64_t& parentId) const {
+            return rng::draw(tickKey, parentId, rng::BIRTH_STREAM, 0);
+        }
+
+        // Binary snapshot of the whole simulation, random state and species
+        // table included, see Checkpoint.h. saveCheckpointAsync copies the state
+        // and writes it on a background thread; waitForCheckpoint joins that
+        // thread and rethrows its error, if any.
+        void saveCheckpoint(const std::string& path) const;
+        void saveCheckpointAsync(const std::string& path);
+        void waitForCheckpoint();
+        // Replaces the world and the species registry with a snapshot, ready
+        // to run on; throws std::runtime_error on a missing, foreign or corrupt
+        // file, leaving both as they were
+        void loadCheckpoint(const std::string& path);
+
+        // Records every move, birth, kill and starvation to `path` from the next
+        // tick on, see EventLog.h; throws if the file cannot be created
+        void startEventLog(const std::string& path);
+        // Writes out what is queued and closes the log; returns the number of
+        // events written and rethrows a write error
+        uint64_t stopEventLog();
+        inline const EventLog* getEventLog() const { return eventLog.get(); }
+        // Hook for the tick code, only a branch while no log is open. `to` is
+        // where the agent moves, or where the child or the victim is.
+        inline void recordEvent(const EventLog::Type& type, const animalconfig::SpeciesId& species, const uint64_t& entity,
+                                const uint64_t& other, const kinematics::Vector2D& at, const kinematics::Vector2D& to) {
+            if (!eventLog)
+                return;
+            EventLog::Event event = {at.x, at.y, entity, other, type, species,
+                                     static_cast<int8_t>(to.x - at.x), static_cast<int8_t>(to.y - at.y)};
+            (stripeContext != nullptr ? stripeContext->events : serialEvents).push_back(event);
+        }
+
+        // Kept current by every spawn, birth, death and energy change
+        inline const PopulationStats& getStats() const { return stats; }
+        // For sampling the time series and flushing it
+        inline PopulationStats& getStats() { return stats; }
+        // Stats hooks for the tick code; `cellId` holds the agent whose energy changed
+        inline void noteEnergy(const uint64_t& cellId, const animalconfig::SpeciesId& species, const uint32_t& before, const uint32_t& after) {
+            tallyFor(species).energy += static_cast<int64_t>(after) - static_cast<int64_t>(before);
+            markChanged(cellId);
+        }
+
+        // Change tracking for renderers that redraw only what changed. While
+        // enabled the world notes every cell whose agent arrives, leaves or
+        // gains or loses energy. takeChangedCells moves those cell ids into
+        // `cells`, possibly repeated, and returns false instead when every
+        // cell must be treated as changed: tracking was just enabled, the world
+        // was cleared or resized, or more changes piled up than there are cells.
+        // Throws std::runtime_error for worlds of more than 2^32 cells.
+        void setChangeTracking(const bool& enabled);
+        inline bool isTrackingChanges() const { return trackChanges; }
+        bool takeChangedCells(std::vector<uint32_t>& cells);
+
+        // Copies the grid, the tick and the head counts into `snapshot`, see
+        // Snapshot.cpp. With `cells` only those cells are copied, as long as
+        // the snapshot already has the world's size. The snapshot's density
+        // pyramid is patched along with those cells, or rebuilt.
+        void updateSnapshot(WorldSnapshot& snapshot, const std::vector<uint32_t>* cells = nullptr) const;
+        inline void noteBirth(const animalconfig::SpeciesId& species) { ++tallyFor(species).births; }
+
+        // Throws std::runtime_error for the intent engine on a chunked layout
+        void setTickEngine(TickEngine engine);
+        inline TickEngine getTickEngine() const { return tickEngine; }
+        inline void setNearestSearch(NearestSearch search) { nearestSearch = search; }
+        inline NearestSearch getNearestSearch() const { return nearestSearch; }
+
+        // Empties the world and rewinds the entity pool in one step
+        void clear();
+
         void addEntity(Entity* entity);
         void addEntityType(char symbol);
+        // Seeds many agents at once, see Populate.cpp. Reproducible from the
+        // seed and independent of the thread count; returns how many agents of
+        // each population were placed. Throws if the counts exceed the empty cells.
+        std::vector<uint64_t> populate(const std::vector<Population>& populations);
+        // Allocates an entity from the world's pool and places it on the grid.
+        // Births pass childEntityId(parent) as the id; without one it comes
+        // from newEntityId(), which must not be called from a stripe.
+        Entity* spawnEntity(const animalconfig::config& config, const kinematics::Vector2D& pos);
+        Entity* spawnEntity(const animalconfig::SpeciesId& species, const kinematics::Vector2D& pos);
+        Entity* spawnEntity(const animalconfig::SpeciesId& species, const kinematics::Vector2D& pos, const uint64_t& id);
         void killEntity(Entity* &entity);
+        inline const ObjectPool<Entity>& getEntityPool() const { return entityPool; }
+        // Uniformly random empty cell; throws when the world is full
         kinematics::Vector2D getNewEmptyCell();
+        // `count` distinct empty cells drawn uniformly, for mass spawning;
+        // throws when fewer are free
+        std::vector<kinematics::Vector2D> getNewEmptyCells(const uint64_t& count);
         void run();
-        // Updated render function signature
-        void render(sf::RenderWindow& window, std::map<char, sf::Texture>& textures, const uint32_t& tileSize);
 
-        inline bool isCellOccupied(const int& x, const int& y) const { return gridOccupied.find(getCellId(x, y)) != gridOccupied.end(); }
+        inline bool isInside(const int& x, const int& y) const { return x >= 0 && x < size.x && y >= 0 && y < size.y; }
+        inline bool isCellOccupied(const int& x, const int& y) const {
+            if (!isInside(x, y))
+                return false;
+            return gridLayout == GridLayout::Chunked ? chunkedGrid.test(x, y) : gridOccupied.test(x, y);
+        }
 
-        inline uint32_t getOccupiedCellsCount() const { return gridOccupied.size(); }
-        inline uint32_t getCellId(const int& x, const int& y) const { 
-            if(x >= 0 && x < size.x && y >= 0 && y < size.y)
-               return x * size.y + y;
+        inline uint32_t getOccupiedCellsCount() const {
+            return gridLayout == GridLayout::Chunked ? static_cast<uint32_t>(chunkedGrid.getCount()) : gridOccupied.getCount();
+        }
+        inline uint64_t getCellCount() const { return static_cast<uint64_t>(size.x) * size.y; }
+        inline uint64_t getFreeCellCount() const { return getCellCount() - getOccupiedCellsCount(); }
+        inline bool isFull() const { return getFreeCellCount() == 0; }
+        inline const SpatialIndex& getSpeciesIndex() const { return speciesIndex; }
+        // Nearest cell holding one of `species` within `range` of pos, see SpatialIndex
+        inline kinematics::Vector2D findNearest(const kinematics::Vector2D& pos, const int& range, const animalconfig::SpeciesId* species, const size_t& count) const {
+            if (gridLayout == GridLayout::Chunked)
+                return chunkedGrid.findNearest(pos, range, species, count);
+            return speciesIndex.findNearest(pos, range, species, count);
+        }
+        // 64-bit, so chunked worlds past 2^32 cells never overflow.
+        // INVALID_CELL for a position outside the grid.
+        static constexpr uint64_t INVALID_CELL = UINT64_MAX;
+        inline uint64_t getCellId(const int& x, const int& y) const { 
+            if(isInside(x, y))
+               return static_cast<uint64_t>(x) * size.y + y;
 
-            return INT_MAX; //invalid
+            return INVALID_CELL;
         }
-        inline kinematics::Vector2D getCellCoordinates(const uint32_t& cellId) const {
-            return kinematics::Vector2D(cellId / size.y, cellId % size.y);
+        inline kinematics::Vector2D getCellCoordinates(const uint64_t& cellId) const {
+            return kinematics::Vector2D(static_cast<int>(cellId / size.y), static_cast<int>(cellId % size.y));
         }
 
         char getCellSymbol(const int &x, const int &y) const;
+        animalconfig::SpeciesId getCellSpecies(const int &x, const int &y) const;
+        // Energy of the agent in the cell, 0 when empty
+        uint32_t getCellEnergy(const int &x, const int &y) const;
         Entity *getEntityAt(const int &x, const int &y) const;
         void displayWorld() const;
         void setEntityAt(const int &x, const int &y, Entity* entity) {
-            if (x >= 0 && x < size.x && y >= 0 && y < size.y) {
-                grid[x][y] = entity;
-                gridOccupied.insert(getCellId(x, y));
+            if (isInside(x, y) && gridLayout == GridLayout::Chunked) {
+                chunkedGrid.set(x, y, entity);
+                markChanged(getCellId(x, y));
+            } else if (isInside(x, y)) {
+                Entity*& cell = grid[getCellId(x, y)];
+                if (cell != nullptr && cell != entity) {
+                    speciesIndex.reset(cell->speciesId, x, y);
+                }
+                cell = entity;
+                if (entity != nullptr) {
+                    gridOccupied.set(x, y);
+                    speciesIndex.set(entity->speciesId, x, y);
+                } else {
+                    gridOccupied.reset(x, y);
+                }
+                markChanged(getCellId(x, y));
             } else {
-                std::cerr << "ERROR: Attempt to set entity at invalid position: " << x << ", " << y << std::endl;
+                ECOSIM_LOG_ERROR("Attempt to set entity at invalid position: {}, {}", x, y);
             }
         }
         void clearCell(const int &x, const int &y) {
-            if (x >= 0 && x < size.x && y >= 0 && y < size.y) {
-                grid[x][y] = nullptr;
-                uint32_t cellId = getCellId(x, y);
-                if (gridOccupied.find(cellId) != gridOccupied.end()) {
-                    gridOccupied.erase(cellId);
+            if (isInside(x, y) && gridLayout == GridLayout::Chunked) {
+                chunkedGrid.set(x, y, nullptr);
+                markChanged(getCellId(x, y));
+            } else if (isInside(x, y)) {
+                Entity*& cell = grid[getCellId(x, y)];
+                if (cell != nullptr) {
+                    speciesIndex.reset(cell->speciesId, x, y);
                 }
+                cell = nullptr;
+                gridOccupied.reset(x, y);
+                markChanged(getCellId(x, y));
             } else {
-                std::cerr << "ERROR: Attempt to clear invalid cell: " << x << ", " << y << std::endl;
+                ECOSIM_LOG_ERROR("Attempt to clear invalid cell: {}, {}", x, y);
             }
         }
 };
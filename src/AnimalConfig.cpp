@@ -0,0 +1,373 @@
+#include "../include/AnimalConfig.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstdlib>
+#include <cctype>
+#include <cmath>
+#include <utility>
+#include <algorithm>
+
+namespace {
+    // Just enough JSON for species files
+    struct JsonValue {
+        enum class Type { Null, Bool, Number, String, Array, Object };
+
+        Type type = Type::Null;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<JsonValue> items;
+        std::vector<std::pair<std::string, JsonValue>> members;
+
+        const JsonValue* find(const std::string& key) const {
+            for (const auto& member : members) {
+                if (member.first == key)
+                    return &member.second;
+            }
+            return nullptr;
+        }
+    };
+
+    class JsonParser {
+        public:
+            explicit JsonParser(const std::string& text) : text(text) {}
+
+            JsonValue parse() {
+                JsonValue value = parseValue();
+                skipWhitespace();
+                if (pos != text.size())
+                    fail("unexpected trailing characters");
+                return value;
+            }
+
+        private:
+            const std::string& text;
+            size_t pos = 0;
+
+            [[noreturn]] void fail(const std::string& message) const {
+                throw std::runtime_error("Invalid species config: " + message + " at offset " + std::to_string(pos));
+            }
+
+            void skipWhitespace() {
+                while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+                    ++pos;
+            }
+
+            void expect(char c) {
+                skipWhitespace();
+                if (pos >= text.size() || text[pos] != c)
+                    fail(std::string("expected '") + c + "'");
+                ++pos;
+            }
+
+            bool consumeSeparator() {
+                skipWhitespace();
+                if (pos < text.size() && text[pos] == ',') {
+                    ++pos;
+                    return true;
+                }
+                return false;
+            }
+
+            bool consumeLiteral(const char* literal) {
+                size_t length = std::char_traits<char>::length(literal);
+                if (text.compare(pos, length, literal) != 0)
+                    return false;
+                pos += length;
+                return true;
+            }
+
+            JsonValue parseValue() {
+                skipWhitespace();
+                if (pos >= text.size())
+                    fail("unexpected end of input");
+
+                JsonValue value;
+                char c = text[pos];
+                if (c == '{') {
+                    value.type = JsonValue::Type::Object;
+                    ++pos;
+                    skipWhitespace();
+                    if (pos < text.size() && text[pos] == '}') {
+                        ++pos;
+                        return value;
+                    }
+                    while (true) {
+                        skipWhitespace();
+                        std::string key = parseString();
+                        expect(':');
+                        value.members.emplace_back(key, parseValue());
+                        if (!consumeSeparator())
+                            break;
+                    }
+                    expect('}');
+                } else if (c == '[') {
+                    value.type = JsonValue::Type::Array;
+                    ++pos;
+                    skipWhitespace();
+                    if (pos < text.size() && text[pos] == ']') {
+                        ++pos;
+                        return value;
+                    }
+                    while (true) {
+                        value.items.push_back(parseValue());
+                        if (!consumeSeparator())
+                            break;
+                    }
+                    expect(']');
+                } else if (c == '"') {
+                    value.type = JsonValue::Type::String;
+                    value.string = parseString();
+                } else if (consumeLiteral("true")) {
+                    value.type = JsonValue::Type::Bool;
+                    value.boolean = true;
+                } else if (consumeLiteral("false")) {
+                    value.type = JsonValue::Type::Bool;
+                } else if (consumeLiteral("null")) {
+                    value.type = JsonValue::Type::Null;
+                } else {
+                    const char* begin = text.c_str() + pos;
+                    char* end = nullptr;
+                    value.number = std::strtod(begin, &end);
+                    if (end == begin)
+                        fail("unexpected character");
+                    value.type = JsonValue::Type::Number;
+                    pos += end - begin;
+                }
+                return value;
+            }
+
+            std::string parseString() {
+                if (pos >= text.size() || text[pos] != '"')
+                    fail("expected string");
+                ++pos;
+
+                std::string result;
+                while (pos < text.size() && text[pos] != '"') {
+                    char c = text[pos++];
+                    if (c == '\\') {
+                        if (pos >= text.size())
+                            break;
+                        char escaped = text[pos++];
+                        switch (escaped) {
+                            case 'n': result += '\n'; break;
+                            case 't': result += '\t'; break;
+                            case 'u': fail("unicode escapes are not supported");
+                            default: result += escaped; break;
+                        }
+                    } else {
+                        result += c;
+                    }
+                }
+                if (pos >= text.size())
+                    fail("unterminated string");
+                ++pos;
+                return result;
+            }
+    };
+
+    uint32_t toUnsigned(const JsonValue& value, const std::string& key) {
+        if (value.type != JsonValue::Type::Number || !(value.number >= 0) || value.number > UINT32_MAX
+            || value.number != std::floor(value.number))
+            throw std::runtime_error("Invalid species config: \"" + key + "\" must be a whole number from 0 to " + std::to_string(UINT32_MAX));
+        return static_cast<uint32_t>(value.number);
+    }
+
+    char toSymbol(const JsonValue& value, const std::string& key) {
+        if (value.type != JsonValue::Type::String || value.string.size() > 1)
+            throw std::runtime_error("Invalid species config: \"" + key + "\" must be a single character");
+        return value.string.empty() ? ' ' : value.string[0];
+    }
+}
+
+namespace animalconfig {
+
+SpeciesRegistry::SpeciesRegistry() {
+    reset();
+}
+
+void SpeciesRegistry::reset() {
+    config none = PLANT_CONFIG;
+    none.symbol = '.';
+    none.energy = 0;
+
+    configs.assign(1, none);
+    ranks.assign(1, 0);
+    preys.assign(1, NO_SPECIES);
+    mobile.assign(1, 0);
+    names.assign(1, "none");
+    predators.assign(1, std::vector<SpeciesId>());
+    explicitRank.assign(1, true);
+    for (SpeciesId& id : bySymbol) {
+        id = NO_SPECIES;
+    }
+
+    add("plant", PLANT_CONFIG, 1, false);
+    add("herbivore", HERBIVORE_CONFIG, 2, true);
+    add("carnivore", CARNIVORE_CONFIG, 3, true);
+}
+
+SpeciesId SpeciesRegistry::add(const std::string& name, const config& species, uint8_t rank, bool isMobile) {
+    if (species.symbol == '.' || species.symbol == ' ') {
+        throw std::runtime_error("Species symbol '" + std::string(1, species.symbol) + "' is reserved");
+    }
+    if (species.visionRange > MAX_VISION_RANGE) {
+        throw std::runtime_error("Invalid species config: \"visionRange\" of '" + std::string(1, species.symbol) + "' is above "
+                                 + std::to_string(MAX_VISION_RANGE));
+    }
+
+    SpeciesId id = findBySymbol(species.symbol);
+    if (id == NO_SPECIES) {
+        if (configs.size() > UINT8_MAX) {
+            throw std::runtime_error("Too many species");
+        }
+        id = configs.size();
+        configs.push_back(species);
+        ranks.push_back(rank);
+        preys.push_back(NO_SPECIES);
+        mobile.push_back(isMobile);
+        names.push_back(name);
+        explicitRank.push_back(rank != 0);
+        bySymbol[static_cast<uint8_t>(species.symbol)] = id;
+    } else {
+        configs[id] = species;
+        ranks[id] = rank;
+        mobile[id] = isMobile;
+        names[id] = name;
+        explicitRank[id] = rank != 0;
+    }
+
+    resolveRelations();
+    return id;
+}
+
+// Prey ids from prey symbols; species without an explicit rank sit one above their prey
+void SpeciesRegistry::resolveRelations() {
+    const size_t count = configs.size();
+    for (size_t id = 1; id < count; ++id) {
+        preys[id] = findBySymbol(configs[id].prey);
+        if (!explicitRank[id]) {
+            ranks[id] = 0;
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t id = 1; id < count; ++id) {
+            if (ranks[id] != 0)
+                continue;
+            SpeciesId prey = preys[id];
+            if (prey == NO_SPECIES) {
+                ranks[id] = 1;
+                changed = true;
+            } else if (ranks[prey] != 0) {
+                ranks[id] = ranks[prey] == UINT8_MAX ? UINT8_MAX : ranks[prey] + 1;
+                changed = true;
+            }
+        }
+    }
+
+    // Prey cycles without explicit ranks
+    for (size_t id = 1; id < count; ++id) {
+        if (ranks[id] == 0) {
+            ranks[id] = 1;
+        }
+    }
+
+    predators.assign(count, std::vector<SpeciesId>());
+    for (size_t id = 1; id < count; ++id) {
+        for (size_t other = 1; other < count; ++other) {
+            if (ranks[other] > ranks[id]) {
+                predators[id].push_back(other);
+            }
+        }
+    }
+}
+
+void SpeciesRegistry::loadFromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open species config: " + path);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    loadFromString(buffer.str());
+}
+
+void SpeciesRegistry::loadFromString(const std::string& text) {
+    JsonValue root = JsonParser(text).parse();
+    const JsonValue* list = root.type == JsonValue::Type::Object ? root.find("species") : nullptr;
+    if (list == nullptr || list->type != JsonValue::Type::Array) {
+        throw std::runtime_error("Invalid species config: expected {\"species\": [...]}");
+    }
+
+    // Entries go into a copy, so an entry that fails leaves this registry as it was
+    SpeciesRegistry staged(*this);
+    for (const JsonValue& entry : list->items) {
+        if (entry.type != JsonValue::Type::Object) {
+            throw std::runtime_error("Invalid species config: species entries must be objects");
+        }
+        const JsonValue* symbolValue = entry.find("symbol");
+        if (symbolValue == nullptr) {
+            throw std::runtime_error("Invalid species config: species without \"symbol\"");
+        }
+        char symbol = toSymbol(*symbolValue, "symbol");
+
+        // Overrides start from the existing species, new ones from nothing
+        SpeciesId existing = staged.findBySymbol(symbol);
+        config species = {};
+        species.symbol = symbol;
+        species.prey = ' ';
+        std::string name(1, symbol);
+        uint8_t rank = 0;
+        bool hasMobile = false, isMobile = false;
+        if (existing != NO_SPECIES) {
+            species = staged.configs[existing];
+            name = staged.names[existing];
+            rank = staged.explicitRank[existing] ? staged.ranks[existing] : 0;
+            hasMobile = true;
+            isMobile = staged.mobile[existing] != 0;
+        }
+
+        for (const auto& member : entry.members) {
+            const std::string& key = member.first;
+            const JsonValue& value = member.second;
+
+            if (key == "symbol") continue;
+            else if (key == "name") {
+                if (value.type != JsonValue::Type::String)
+                    throw std::runtime_error("Invalid species config: \"name\" must be a string");
+                name = value.string;
+            }
+            else if (key == "prey") species.prey = toSymbol(value, key);
+            else if (key == "energy") species.energy = toUnsigned(value, key);
+            else if (key == "maxEnergy") species.maxEnergy = toUnsigned(value, key);
+            else if (key == "visionRange") species.visionRange = toUnsigned(value, key);
+            else if (key == "reproductionCost") species.reproductionCost = toUnsigned(value, key);
+            else if (key == "reproductionThreshold") species.reproductionThreshold = toUnsigned(value, key);
+            else if (key == "energyGainFromEating") species.energyGainFromEating = toUnsigned(value, key);
+            else if (key == "energyCostPerTick") species.energyCostPerTick = toUnsigned(value, key);
+            else if (key == "rank") rank = static_cast<uint8_t>(std::min<uint32_t>(toUnsigned(value, key), UINT8_MAX));
+            else if (key == "mobile") {
+                if (value.type != JsonValue::Type::Bool)
+                    throw std::runtime_error("Invalid species config: \"mobile\" must be true or false");
+                hasMobile = true;
+                isMobile = value.boolean;
+            }
+            else throw std::runtime_error("Invalid species config: unknown key \"" + key + "\"");
+        }
+
+        if (species.reproductionCost > species.reproductionThreshold) {
+            throw std::runtime_error("Invalid species config: \"reproductionCost\" of '" + std::string(1, symbol) + "' exceeds its \"reproductionThreshold\"");
+        }
+        if (!hasMobile) {
+            isMobile = species.prey != ' ';
+        }
+        staged.add(name, species, rank, isMobile);
+    }
+    *this = std::move(staged);
+}
+
+}
@@ -0,0 +1,502 @@
+#include "../include/World.h"
+#include "../include/Entity.h"
+#include "../include/Checkpoint.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Checkpoints. Saving copies the state into one contiguous image; the
+// checksum and the file write can then run on a background thread while the
+// simulation goes on. Files are written next to the target and renamed over
+// it, so a crash mid-write never leaves a torn checkpoint behind. Restoring
+// maps the file instead of reading it, verifies the checksum in place and
+// rebuilds the grid straight from the mapped arrays.
+
+namespace {
+    const uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+
+    inline uint64_t rotl(const uint64_t& value, const int& bits) { return (value << bits) | (value >> (64 - bits)); }
+
+    inline uint64_t load64(const unsigned char* bytes) {
+        uint64_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    // Collects the sections of a checkpoint, then copies them behind the
+    // header with a single allocation, each on an 8-byte boundary
+    class ImageWriter {
+        public:
+            void append(const void* data, const size_t& bytes) {
+                sections.emplace_back(static_cast<const char*>(data), bytes);
+                payloadBytes += checkpoint::alignUp(bytes);
+            }
+
+            template <typename T>
+            void append(const std::vector<T>& values) { append(values.data(), values.size() * sizeof(T)); }
+
+            inline size_t getPayloadBytes() const { return payloadBytes; }
+
+            std::vector<char> build(const checkpoint::Header& header) const {
+                std::vector<char> image(sizeof(header) + payloadBytes, 0);
+                std::memcpy(image.data(), &header, sizeof(header));
+                size_t offset = sizeof(header);
+                for (const auto& section : sections) {
+                    if (section.second > 0)
+                        std::memcpy(image.data() + offset, section.first, section.second);
+                    offset += checkpoint::alignUp(section.second);
+                }
+                return image;
+            }
+
+        private:
+            std::vector<std::pair<const char*, size_t>> sections;
+            size_t payloadBytes = 0;
+    };
+
+    // Reads the sections back, refusing to run past the end of the payload
+    class ImageReader {
+        public:
+            ImageReader(const char* data, const size_t& size) : cursor(data), end(data + size) {}
+
+            template <typename T>
+            const T* take(const size_t& count) {
+                const size_t bytes = checkpoint::alignUp(count * sizeof(T));
+                if (static_cast<size_t>(end - cursor) < bytes)
+                    throw std::runtime_error("Checkpoint is truncated");
+                const T* values = reinterpret_cast<const T*>(cursor);
+                cursor += bytes;
+                return values;
+            }
+
+            inline bool atEnd() const { return cursor == end; }
+
+        private:
+            const char* cursor;
+            const char* end;
+    };
+
+    // Read-only view of a whole file
+    class MappedFile {
+        public:
+            explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+                file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+                if (file == INVALID_HANDLE_VALUE)
+                    throw std::runtime_error("Could not open checkpoint " + path);
+                LARGE_INTEGER fileSize;
+                GetFileSizeEx(file, &fileSize);
+                size = static_cast<size_t>(fileSize.QuadPart);
+                if (size > 0) {
+                    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                    if (mapping != nullptr)
+                        bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                    if (bytes == nullptr) {
+                        close();
+                        throw std::runtime_error("Could not map checkpoint " + path);
+                    }
+                }
+#else
+                descriptor = open(path.c_str(), O_RDONLY);
+                if (descriptor < 0)
+                    throw std::runtime_error("Could not open checkpoint " + path);
+                struct stat info;
+                if (fstat(descriptor, &info) != 0) {
+                    close();
+                    throw std::runtime_error("Could not read checkpoint " + path);
+                }
+                size = static_cast<size_t>(info.st_size);
+                if (size > 0) {
+                    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+                    if (mapped == MAP_FAILED) {
+                        close();
+                        throw std::runtime_error("Could not map checkpoint " + path);
+                    }
+                    bytes = static_cast<const char*>(mapped);
+                    madvise(mapped, size, MADV_SEQUENTIAL);
+                }
+#endif
+            }
+            ~MappedFile() { close(); }
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            inline const char* data() const { return bytes; }
+            inline size_t getSize() const { return size; }
+
+        private:
+            void close() {
+#ifdef _WIN32
+                if (bytes != nullptr)
+                    UnmapViewOfFile(bytes);
+                if (mapping != nullptr)
+                    CloseHandle(mapping);
+                if (file != INVALID_HANDLE_VALUE)
+                    CloseHandle(file);
+                mapping = nullptr;
+                file = INVALID_HANDLE_VALUE;
+#else
+                if (bytes != nullptr)
+                    munmap(const_cast<char*>(bytes), size);
+                if (descriptor >= 0)
+                    ::close(descriptor);
+                descriptor = -1;
+#endif
+                bytes = nullptr;
+            }
+
+#ifdef _WIN32
+            HANDLE file = INVALID_HANDLE_VALUE;
+            HANDLE mapping = nullptr;
+#else
+            int descriptor = -1;
+#endif
+            const char* bytes = nullptr;
+            size_t size = 0;
+    };
+
+    uint64_t imageChecksum(const checkpoint::Header& header, const char* payload) {
+        checkpoint::Header blank = header;
+        blank.checksum = 0;
+        return checkpoint::checksum(payload, header.payloadBytes, checkpoint::checksum(&blank, sizeof(blank)));
+    }
+
+    // Stamps the checksum and replaces `path` with the image
+    void writeImage(std::vector<char>& image, const std::string& path) {
+        checkpoint::Header header;
+        std::memcpy(&header, image.data(), sizeof(header));
+        header.checksum = imageChecksum(header, image.data() + sizeof(header));
+        std::memcpy(image.data(), &header, sizeof(header));
+
+        const std::string partial = path + ".tmp";
+        {
+            std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+            if (!file.write(image.data(), image.size()) || !file.flush())
+                throw std::runtime_error("Could not write checkpoint " + partial);
+        }
+#ifdef _WIN32
+        std::remove(path.c_str());
+#endif
+        if (std::rename(partial.c_str(), path.c_str()) != 0) {
+            std::remove(partial.c_str());
+            throw std::runtime_error("Could not replace checkpoint " + path);
+        }
+    }
+}
+
+uint64_t checkpoint::checksum(const void* data, const size_t& size, const uint64_t& seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t lanes[4] = {seed + PRIME_1 + PRIME_2, seed + PRIME_2, seed, seed - PRIME_1};
+
+    size_t offset = 0;
+    for (; offset + 32 <= size; offset += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            lanes[lane] = rotl(lanes[lane] + load64(bytes + offset + 8 * lane) * PRIME_2, 31) * PRIME_1;
+        }
+    }
+
+    uint64_t hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18) + size;
+    for (; offset + 8 <= size; offset += 8) {
+        hash = rotl(hash ^ (rotl(load64(bytes + offset) * PRIME_2, 31) * PRIME_1), 27) * PRIME_1 + PRIME_3;
+    }
+    for (; offset < size; ++offset) {
+        hash = rotl(hash ^ (bytes[offset] * PRIME_3), 11) * PRIME_1;
+    }
+    return rng::mix(hash);
+}
+
+std::vector<char> World::captureCheckpoint() const {
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+
+    checkpoint::Header header{};
+    std::memcpy(header.magic, checkpoint::MAGIC, sizeof(header.magic));
+    header.version = checkpoint::VERSION;
+    header.headerBytes = sizeof(header);
+    header.seed = seed;
+    header.tick = tick;
+    header.worldDraws = worldDraws;
+    header.generation = generation;
+    header.rows = size.x;
+    header.cols = size.y;
+    header.speciesCount = registry.getCount();
+    header.storage = static_cast<uint8_t>(storageMode);
+    header.layout = static_cast<uint8_t>(gridLayout);
+    header.engine = static_cast<uint8_t>(tickEngine);
+    header.search = static_cast<uint8_t>(nearestSearch);
+
+    std::vector<checkpoint::SpeciesRecord> species;
+    std::string names;
+    for (uint32_t id = 1; id <= registry.getCount(); ++id) {
+        const animalconfig::config& config = registry.get(id);
+        checkpoint::SpeciesRecord record;
+        record.symbol = config.symbol;
+        record.prey = config.prey;
+        record.rank = registry.hasExplicitRank(id) ? registry.getRank(id) : 0;
+        record.mobile = registry.isMobile(id) ? 1 : 0;
+        record.energy = config.energy;
+        record.maxEnergy = config.maxEnergy;
+        record.visionRange = config.visionRange;
+        record.reproductionCost = config.reproductionCost;
+        record.reproductionThreshold = config.reproductionThreshold;
+        record.energyGainFromEating = config.energyGainFromEating;
+        record.energyCostPerTick = config.energyCostPerTick;
+        record.nameBytes = registry.getName(id).size();
+        species.push_back(record);
+        names += registry.getName(id);
+    }
+
+    ImageWriter writer;
+    writer.append(species);
+    writer.append(names.data(), names.size());
+
+    if (storageMode == StorageMode::Dense) {
+        header.entityCount = denseStore.getSlotCount();
+        header.freeSlotCount = denseStore.getFreeSlots().size();
+        header.retiredSlotCount = denseStore.getRetiredSlots().size();
+        writer.append(denseStore.posX);
+        writer.append(denseStore.posY);
+        writer.append(denseStore.velX);
+        writer.append(denseStore.velY);
+        writer.append(denseStore.energy);
+        writer.append(denseStore.species);
+        writer.append(denseStore.id);
+        writer.append(denseStore.updated);
+        writer.append(denseStore.getFreeSlots());
+        writer.append(denseStore.getRetiredSlots());
+    } else {
+        std::vector<int32_t> posX, posY;
+        std::vector<int8_t> velX, velY;
+        std::vector<uint32_t> energy, updated;
+        std::vector<uint64_t> id;
+        std::vector<uint8_t> speciesIds;
+        const size_t count = getOccupiedCellsCount();
+        posX.reserve(count);
+        posY.reserve(count);
+        velX.reserve(count);
+        velY.reserve(count);
+        energy.reserve(count);
+        speciesIds.reserve(count);
+        id.reserve(count);
+        updated.reserve(count);
+
+        auto gather = [&](const int& x, const int& y) {
+            const Entity* entity = getEntityAt(x, y);
+            const kinematics::Vector2D velocity = entity->getVelocity();
+            posX.push_back(x);
+            posY.push_back(y);
+            velX.push_back(static_cast<int8_t>(velocity.x));
+            velY.push_back(static_cast<int8_t>(velocity.y));
+            energy.push_back(entity->energy);
+            speciesIds.push_back(entity->speciesId);
+            id.push_back(entity->id);
+            updated.push_back(entity->updatedGeneration);
+        };
+        if (gridLayout == GridLayout::Chunked) {
+            chunkedGrid.forEachSet(animalconfig::NO_SPECIES, gather);
+        } else {
+            gridOccupied.forEachSet(0, size.x, [&](uint32_t x, uint32_t y) { gather(x, y); });
+        }
+
+        header.entityCount = posX.size();
+        writer.append(posX);
+        writer.append(posY);
+        writer.append(velX);
+        writer.append(velY);
+        writer.append(energy);
+        writer.append(speciesIds);
+        writer.append(id);
+        writer.append(updated);
+        // Built here, while the gathered arrays are still alive
+        header.payloadBytes = writer.getPayloadBytes();
+        return writer.build(header);
+    }
+
+    header.payloadBytes = writer.getPayloadBytes();
+    return writer.build(header);
+}
+
+void World::saveCheckpoint(const std::string& path) const {
+    std::vector<char> image = captureCheckpoint();
+    writeImage(image, path);
+}
+
+void World::saveCheckpointAsync(const std::string& path) {
+    waitForCheckpoint();
+    std::vector<char> image = captureCheckpoint();
+    checkpointThread = std::thread([this, path](std::vector<char> image) {
+        try {
+            writeImage(image, path);
+        } catch (...) {
+            checkpointError = std::current_exception();
+        }
+    }, std::move(image));
+}
+
+void World::waitForCheckpoint() {
+    if (checkpointThread.joinable()) {
+        checkpointThread.join();
+    }
+    if (checkpointError) {
+        std::exception_ptr error = checkpointError;
+        checkpointError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void World::loadCheckpoint(const std::string& path) {
+    waitForCheckpoint();
+
+    MappedFile file(path);
+    checkpoint::Header header;
+    if (file.getSize() < sizeof(header))
+        throw std::runtime_error("Not a checkpoint: " + path);
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, checkpoint::MAGIC, sizeof(header.magic)) != 0)
+        throw std::runtime_error("Not a checkpoint: " + path);
+    if (header.version != checkpoint::VERSION || header.headerBytes != sizeof(header))
+        throw std::runtime_error("Unsupported checkpoint version " + std::to_string(header.version) + " in " + path);
+    if (header.payloadBytes != file.getSize() - sizeof(header))
+        throw std::runtime_error("Checkpoint is truncated: " + path);
+    if (imageChecksum(header, file.data() + sizeof(header)) != header.checksum)
+        throw std::runtime_error("Checkpoint is corrupt: " + path);
+
+    const StorageMode storage = static_cast<StorageMode>(header.storage);
+    const GridLayout layout = static_cast<GridLayout>(header.layout);
+    if (header.storage > static_cast<uint8_t>(StorageMode::Dense) || header.layout > static_cast<uint8_t>(GridLayout::Chunked)
+        || header.engine > static_cast<uint8_t>(TickEngine::Intent) || header.search > static_cast<uint8_t>(NearestSearch::Field)
+        || (layout == GridLayout::Chunked && (storage != StorageMode::Objects || header.engine != static_cast<uint8_t>(TickEngine::Sweep))))
+        throw std::runtime_error("Checkpoint has an unknown world setup: " + path);
+    if (layout == GridLayout::Chunked && getThreadCount() > 1)
+        throw std::runtime_error("The chunked grid layout runs the sweep engine on a single thread: " + path);
+
+    ImageReader reader(file.data() + sizeof(header), header.payloadBytes);
+    const checkpoint::SpeciesRecord* species = reader.take<checkpoint::SpeciesRecord>(header.speciesCount);
+    size_t nameBytes = 0;
+    for (uint32_t index = 0; index < header.speciesCount; ++index) {
+        nameBytes += species[index].nameBytes;
+    }
+    const char* names = reader.take<char>(nameBytes);
+
+    const size_t count = header.entityCount;
+    const int32_t* posX = reader.take<int32_t>(count);
+    const int32_t* posY = reader.take<int32_t>(count);
+    const int8_t* velX = reader.take<int8_t>(count);
+    const int8_t* velY = reader.take<int8_t>(count);
+    const uint32_t* energy = reader.take<uint32_t>(count);
+    const uint8_t* speciesIds = reader.take<uint8_t>(count);
+    const uint64_t* ids = reader.take<uint64_t>(count);
+    const uint32_t* updated = reader.take<uint32_t>(count);
+    const uint32_t* freeSlots = reader.take<uint32_t>(header.freeSlotCount);
+    const uint32_t* retiredSlots = reader.take<uint32_t>(header.retiredSlotCount);
+    if (!reader.atEnd())
+        throw std::runtime_error("Checkpoint has trailing bytes: " + path);
+    std::vector<uint64_t> cells;
+    cells.reserve(count);
+    for (size_t index = 0; index < count; ++index) {
+        const bool free = storage == StorageMode::Dense && speciesIds[index] == EntityStore::NO_SPECIES;
+        if (free)
+            continue;
+        if (speciesIds[index] == animalconfig::NO_SPECIES || speciesIds[index] > header.speciesCount
+            || posX[index] < 0 || static_cast<uint32_t>(posX[index]) >= header.rows
+            || posY[index] < 0 || static_cast<uint32_t>(posY[index]) >= header.cols)
+            throw std::runtime_error("Checkpoint has an invalid agent: " + path);
+        cells.push_back(static_cast<uint64_t>(posX[index]) * header.cols + posY[index]);
+    }
+    std::sort(cells.begin(), cells.end());
+    if (std::adjacent_find(cells.begin(), cells.end()) != cells.end())
+        throw std::runtime_error("Checkpoint has two agents in one cell: " + path);
+
+    // Dense slots waiting for reuse must be dead, and listed once, or the
+    // next spawn would write past the store or over a live agent
+    if (storage != StorageMode::Dense && (header.freeSlotCount != 0 || header.retiredSlotCount != 0))
+        throw std::runtime_error("Checkpoint has an invalid slot list: " + path);
+    std::vector<uint32_t> slots(freeSlots, freeSlots + header.freeSlotCount);
+    slots.insert(slots.end(), retiredSlots, retiredSlots + header.retiredSlotCount);
+    for (const uint32_t& slot : slots) {
+        if (slot >= count || speciesIds[slot] != EntityStore::NO_SPECIES)
+            throw std::runtime_error("Checkpoint has an invalid slot list: " + path);
+    }
+    std::sort(slots.begin(), slots.end());
+    if (std::adjacent_find(slots.begin(), slots.end()) != slots.end())
+        throw std::runtime_error("Checkpoint has an invalid slot list: " + path);
+
+    // Species come back under the ids they were saved with. The table is
+    // built aside and only replaces the registry once it checks out.
+    animalconfig::SpeciesRegistry restored;
+    for (uint32_t index = 0; index < header.speciesCount; ++index) {
+        const checkpoint::SpeciesRecord& record = species[index];
+        animalconfig::config config;
+        config.symbol = record.symbol;
+        config.prey = record.prey;
+        config.energy = record.energy;
+        config.maxEnergy = record.maxEnergy;
+        config.visionRange = record.visionRange;
+        config.reproductionCost = record.reproductionCost;
+        config.reproductionThreshold = record.reproductionThreshold;
+        config.energyGainFromEating = record.energyGainFromEating;
+        config.energyCostPerTick = record.energyCostPerTick;
+        if (restored.add(std::string(names, record.nameBytes), config, record.rank, record.mobile != 0) != index + 1)
+            throw std::runtime_error("Checkpoint species table does not match the built-in species: " + path);
+        names += record.nameBytes;
+    }
+    if (restored.getCount() != header.speciesCount)
+        throw std::runtime_error("Checkpoint species table does not match the built-in species: " + path);
+    animalconfig::SpeciesRegistry::getInstance() = restored;
+
+    clear();
+    storageMode = storage;
+    gridLayout = layout;
+    tickEngine = static_cast<TickEngine>(header.engine);
+    nearestSearch = static_cast<NearestSearch>(header.search);
+    initialize(header.rows, header.cols);
+
+    if (storageMode == StorageMode::Dense) {
+        denseStore.posX.assign(posX, posX + count);
+        denseStore.posY.assign(posY, posY + count);
+        denseStore.velX.assign(velX, velX + count);
+        denseStore.velY.assign(velY, velY + count);
+        denseStore.energy.assign(energy, energy + count);
+        denseStore.species.assign(speciesIds, speciesIds + count);
+        denseStore.id.assign(ids, ids + count);
+        denseStore.updated.assign(updated, updated + count);
+        denseStore.restore(std::vector<uint32_t>(freeSlots, freeSlots + header.freeSlotCount),
+                           std::vector<uint32_t>(retiredSlots, retiredSlots + header.retiredSlotCount));
+        for (uint32_t index = 0; index < count; ++index) {
+            if (denseStore.species[index] != EntityStore::NO_SPECIES) {
+                noteArrival(denseStore.species[index], denseStore.energy[index]);
+                placeDense(index, posX[index], posY[index]);
+            }
+        }
+    } else {
+        for (size_t index = 0; index < count; ++index) {
+            Entity* entity = entityPool.acquire(speciesIds[index], *this, kinematics::Vector2D(posX[index], posY[index]), ids[index]);
+            entity->setVelocity(velX[index], velY[index]);
+            entity->energy = energy[index];
+            entity->updatedGeneration = updated[index];
+            addEntity(entity);
+        }
+    }
+
+    seed = header.seed;
+    tick = header.tick;
+    tickKey = rng::tickKey(seed, tick);
+    worldDraws = header.worldDraws;
+    generation = header.generation;
+}
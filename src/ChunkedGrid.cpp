@@ -0,0 +1,115 @@
+#include "../include/ChunkedGrid.h"
+#include "../include/SpatialIndex.h"
+#include "../include/Entity.h"
+
+static_assert(ChunkedGrid::CHUNK_SIZE == FreeCellIndex::BLOCK_SIZE, "Free-cell blocks must line up with chunks");
+
+void ChunkedGrid::resize(const uint32_t& rows, const uint32_t& cols) {
+    numRows = rows;
+    numCols = cols;
+    freeCells.resize(rows, cols);
+    clear();
+}
+
+void ChunkedGrid::clear() {
+    chunks.clear();
+    freeCells.clear();
+    lastChunk = nullptr;
+    cellCount = 0;
+}
+
+void ChunkedGrid::set(const int& x, const int& y, Entity* entity) {
+    Chunk* found = findChunk(x >> CHUNK_BITS, y >> CHUNK_BITS);
+    if (found == nullptr) {
+        if (entity == nullptr)
+            return;
+        found = new Chunk();
+        chunks.emplace(chunkKey(x >> CHUNK_BITS, y >> CHUNK_BITS), std::unique_ptr<Chunk>(found));
+    }
+
+    Chunk& chunk = *found;
+    const uint32_t row = x & (CHUNK_SIZE - 1);
+    const uint64_t mask = 1ULL << (y & (CHUNK_SIZE - 1));
+    Entity*& cell = chunk.cells[cellIndex(x, y)];
+
+    if (cell != nullptr) {
+        chunk.speciesRows[static_cast<size_t>(cell->speciesId) * CHUNK_SIZE + row] &= ~mask;
+        if (entity == nullptr) {
+            chunk.occupied[row] &= ~mask;
+            --chunk.count;
+            --cellCount;
+            freeCells.vacate(x, y);
+        }
+    } else if (entity != nullptr) {
+        chunk.occupied[row] |= mask;
+        ++chunk.count;
+        ++cellCount;
+        freeCells.occupy(x, y);
+    }
+
+    cell = entity;
+    if (entity != nullptr) {
+        size_t word = static_cast<size_t>(entity->speciesId) * CHUNK_SIZE + row;
+        if (word >= chunk.speciesRows.size()) {
+            chunk.speciesRows.resize((static_cast<size_t>(entity->speciesId) + 1) * CHUNK_SIZE, 0);
+        }
+        chunk.speciesRows[word] |= mask;
+    }
+}
+
+void ChunkedGrid::collect() {
+    lastChunk = nullptr;
+    for (auto it = chunks.begin(); it != chunks.end();) {
+        if (it->second->count == 0) {
+            it = chunks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+kinematics::Vector2D ChunkedGrid::findNearest(const kinematics::Vector2D& pos, const int& range,
+                                              const animalconfig::SpeciesId* species, const size_t& count) const {
+    if (count == 0 || numRows == 0 || numCols == 0)
+        return kinematics::Vector2D(-1, -1);
+
+    // One row of the world: a word per chunk column, OR-ed over the species
+    struct Row {
+        const ChunkedGrid* grid;
+        const animalconfig::SpeciesId* species;
+        size_t count;
+        int chunkX;
+        uint32_t row;
+
+        inline uint64_t operator[](const int& word) const {
+            const Chunk* chunk = grid->findChunk(chunkX, word);
+            if (chunk == nullptr)
+                return 0;
+            uint64_t bits = 0;
+            for (size_t i = 0; i < count; ++i) {
+                bits |= rowWord(*chunk, species[i], row);
+            }
+            return bits;
+        }
+    };
+
+    const kinematics::Vector2D size(numRows, numCols);
+    return SpatialIndex::findNearestBit(size, pos, range, [&](const int& x) {
+        return Row{this, species, count, x >> static_cast<int>(CHUNK_BITS), static_cast<uint32_t>(x) & (CHUNK_SIZE - 1)};
+    });
+}
+
+uint64_t ChunkedGrid::findFree(const uint64_t& rank) const {
+    return freeCells.select(rank, [this](uint32_t row, uint32_t chunkY) {
+        const Chunk* chunk = findChunk(row >> CHUNK_BITS, chunkY);
+        return chunk != nullptr ? chunk->occupied[row & (CHUNK_SIZE - 1)] : 0;
+    });
+}
+
+size_t ChunkedGrid::getMemoryBytes() const {
+    size_t bytes = 0;
+    for (const auto& entry : chunks) {
+        bytes += sizeof(Chunk) + entry.second->speciesRows.capacity() * sizeof(uint64_t);
+    }
+    return bytes + chunks.bucket_count() * sizeof(void*) + freeCells.getMemoryBytes();
+}
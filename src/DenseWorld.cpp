@@ -0,0 +1,270 @@
+#include "../include/World.h"
+#include "../include/Profiler.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+// Dense storage mode: the same rules as Entity::update, applied to the
+// struct-of-arrays EntityStore.
+
+void World::setStorageMode(StorageMode mode) {
+    if (getOccupiedCellsCount() != 0) {
+        throw std::runtime_error("Storage mode can only change while the world is empty");
+    }
+    if (mode != StorageMode::Objects && gridLayout == GridLayout::Chunked) {
+        throw std::runtime_error("The chunked grid layout needs objects storage");
+    }
+    storageMode = mode;
+    entityPool.reset();
+    denseStore.clear();
+    initialize(size.x, size.y);
+}
+
+uint32_t World::spawnDense(char symbol, const kinematics::Vector2D& pos) {
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    return spawnDense(registry.findBySymbol(animalconfig::getConfig(symbol).symbol), pos);
+}
+
+uint32_t World::spawnDense(const animalconfig::SpeciesId& species, const kinematics::Vector2D& pos) {
+    return spawnDense(species, pos, newEntityId());
+}
+
+uint32_t World::spawnDense(const animalconfig::SpeciesId& species, const kinematics::Vector2D& pos, const uint64_t& id) {
+    const animalconfig::config& config = animalconfig::SpeciesRegistry::getInstance().get(species);
+    uint32_t index;
+    if (stripeContext != nullptr) {
+        // Capacity was reserved up front, so add() never reallocates under other stripes
+        std::lock_guard<std::mutex> lock(spawnMutex);
+        index = denseStore.add(species, pos.x, pos.y, config.energy);
+        denseStore.updated[index] = generation;
+    } else {
+        index = denseStore.add(species, pos.x, pos.y, config.energy);
+    }
+    denseStore.id[index] = id;
+    noteArrival(species, config.energy);
+    placeDense(index, pos.x, pos.y);
+    return index;
+}
+
+void World::killDense(uint32_t index) {
+    noteDeath(denseStore.species[index], denseStore.energy[index]);
+    vacateDense(denseStore.posX[index], denseStore.posY[index]);
+    if (stripeContext != nullptr) {
+        stripeContext->retiredSlots.push_back(index);
+    } else {
+        denseStore.remove(index);
+    }
+}
+
+
+void World::updateDense(const uint32_t& index) {
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    const animalconfig::config& config = registry.get(denseStore.species[index]);
+    if (!registry.isMobile(denseStore.species[index])) {
+        return;
+    }
+
+    kinematics::Vector2D currentPos(denseStore.posX[index], denseStore.posY[index]);
+    kinematics::Vector2D predatorPos = findNearestPredatorDense(index);
+
+    if (predatorPos.x != -1 && predatorPos.y != -1) {
+        ECOSIM_PROFILE_SCOPE(profiler::Phase::Flee);
+        moveAwayDense(index, predatorPos);
+
+        double probabilityToMove = rng::uniform(drawFor(denseStore.id[index], rng::FLEE_STREAM));
+        if (probabilityToMove >= 0.3) {
+            setDenseEnergy(index, animalconfig::spend(denseStore.energy[index], config.energyCostPerTick));
+        } else {
+            denseStore.velX[index] = 0;
+            denseStore.velY[index] = 0;
+        }
+
+        relocateDense(index, currentPos);
+        return;
+    }
+
+    if (reproduceDense(index)) {
+        return;
+    }
+
+    kinematics::Vector2D preyPos = findNearestPreyDense(index);
+    if (preyPos.x != -1 && preyPos.y != -1) {
+        ECOSIM_PROFILE_SCOPE(profiler::Phase::Hunt);
+        if (kinematics::findDistance(currentPos, preyPos) == 1) {
+            feedDense(index, denseGrid[getCellId(preyPos.x, preyPos.y)]);
+        }
+
+        moveTowardsDense(index, preyPos);
+        relocateDense(index, currentPos);
+        return;
+    }
+
+    ECOSIM_PROFILE_SCOPE(profiler::Phase::Wander);
+    moveRandomDense(index);
+    relocateDense(index, currentPos);
+}
+
+void World::relocateDense(const uint32_t& index, const kinematics::Vector2D& from) {
+    vacateDense(from.x, from.y);
+
+    int x = from.x + denseStore.velX[index];
+    int y = from.y + denseStore.velY[index];
+    denseStore.posX[index] = x;
+    denseStore.posY[index] = y;
+
+    uint32_t occupant = denseGrid[getCellId(x, y)];
+    if (occupant != EntityStore::INVALID && occupant != index) {
+        recordEvent(EventLog::Type::Kill, denseStore.species[index], denseStore.id[index], denseStore.id[occupant], from, kinematics::Vector2D(x, y));
+        killDense(occupant);
+    }
+    if (x != from.x || y != from.y) {
+        recordEvent(EventLog::Type::Move, denseStore.species[index], denseStore.id[index], 0, from, kinematics::Vector2D(x, y));
+    }
+    placeDense(index, x, y);
+}
+
+void World::moveRandomDense(const uint32_t& index) {
+    const animalconfig::config& config = animalconfig::SpeciesRegistry::getInstance().get(denseStore.species[index]);
+    denseStore.velX[index] = 0;
+    denseStore.velY[index] = 0;
+    if (denseStore.energy[index] <= 0 || isFull()) {
+        return;
+    }
+
+    kinematics::Vector2D currentPos(denseStore.posX[index], denseStore.posY[index]);
+    kinematics::Vector2D directions[4] = {kinematics::STEPS[0], kinematics::STEPS[1], kinematics::STEPS[2], kinematics::STEPS[3]};
+    uint32_t remaining = 4;
+    uint32_t attempt = 0;
+
+    while (remaining > 0) {
+        uint32_t rndIdx = rng::below(drawFor(denseStore.id[index], rng::WANDER_STREAM, attempt++), remaining);
+        kinematics::Vector2D step = directions[rndIdx];
+        kinematics::Vector2D newPos = currentPos + step;
+
+        if (!isInside(newPos.x, newPos.y) || getDenseSpecies(newPos.x, newPos.y) != animalconfig::NO_SPECIES) {
+            // Keep the remaining directions in order, like erasing from the std::set in Entity
+            std::copy(directions + rndIdx + 1, directions + remaining, directions + rndIdx);
+            --remaining;
+            continue;
+        }
+
+        denseStore.velX[index] = step.x;
+        denseStore.velY[index] = step.y;
+        setDenseEnergy(index, animalconfig::spend(denseStore.energy[index], config.energyCostPerTick));
+        return;
+    }
+}
+
+void World::moveAwayDense(const uint32_t& index, const kinematics::Vector2D& threat) {
+    denseStore.velX[index] = 0;
+    denseStore.velY[index] = 0;
+    if (denseStore.energy[index] <= 0) {
+        return;
+    }
+
+    const uint8_t* rankOf = animalconfig::SpeciesRegistry::getInstance().getRankTable();
+    kinematics::Vector2D preyPos(denseStore.posX[index], denseStore.posY[index]);
+    uint8_t preyRank = rankOf[denseStore.species[index]];
+    uint32_t curDist = kinematics::findDistance(threat, preyPos);
+
+    for (const kinematics::Vector2D& step : kinematics::STEPS) {
+        kinematics::Vector2D newPos = preyPos + step;
+        if (!isInside(newPos.x, newPos.y))
+            continue;
+        if (preyRank <= rankOf[getDenseSpecies(newPos.x, newPos.y)])
+            continue;
+
+        if (kinematics::findDistance(threat, newPos) > curDist) {
+            denseStore.velX[index] = step.x;
+            denseStore.velY[index] = step.y;
+            return;
+        }
+    }
+}
+
+void World::moveTowardsDense(const uint32_t& index, const kinematics::Vector2D& target) {
+    const animalconfig::config& config = animalconfig::SpeciesRegistry::getInstance().get(denseStore.species[index]);
+    denseStore.velX[index] = 0;
+    denseStore.velY[index] = 0;
+
+    const uint8_t* rankOf = animalconfig::SpeciesRegistry::getInstance().getRankTable();
+    kinematics::Vector2D currentPos(denseStore.posX[index], denseStore.posY[index]);
+    uint8_t currentRank = rankOf[denseStore.species[index]];
+    uint32_t curDist = kinematics::findDistance(target, currentPos);
+
+    for (const kinematics::Vector2D& step : kinematics::STEPS) {
+        kinematics::Vector2D newPos = currentPos + step;
+        if (!isInside(newPos.x, newPos.y))
+            continue;
+        if (currentRank <= rankOf[getDenseSpecies(newPos.x, newPos.y)])
+            continue;
+
+        if (kinematics::findDistance(target, newPos) < curDist) {
+            denseStore.velX[index] = step.x;
+            denseStore.velY[index] = step.y;
+            setDenseEnergy(index, animalconfig::spend(denseStore.energy[index], config.energyCostPerTick));
+            return;
+        }
+    }
+}
+
+void World::feedDense(const uint32_t& index, uint32_t prey) {
+    ECOSIM_PROFILE_SCOPE(profiler::Phase::Feed);
+    if (prey == EntityStore::INVALID || prey == index) {
+        return;
+    }
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    if (denseStore.species[prey] != registry.getPrey(denseStore.species[index])) {
+        return;
+    }
+    const animalconfig::config& config = registry.get(denseStore.species[index]);
+
+    setDenseEnergy(index, std::min(denseStore.energy[index] + config.energyGainFromEating, config.maxEnergy));
+    recordEvent(EventLog::Type::Kill, denseStore.species[index], denseStore.id[index], denseStore.id[prey],
+                kinematics::Vector2D(denseStore.posX[index], denseStore.posY[index]), kinematics::Vector2D(denseStore.posX[prey], denseStore.posY[prey]));
+    killDense(prey);
+}
+
+bool World::reproduceDense(const uint32_t& index) {
+    ECOSIM_PROFILE_SCOPE(profiler::Phase::Reproduce);
+    const animalconfig::config& config = animalconfig::SpeciesRegistry::getInstance().get(denseStore.species[index]);
+    if (denseStore.energy[index] < config.reproductionThreshold) {
+        return false;
+    }
+
+    kinematics::Vector2D currentPos(denseStore.posX[index], denseStore.posY[index]);
+
+    for (const kinematics::Vector2D& dir : kinematics::BIRTH_STEPS) {
+        kinematics::Vector2D newPos = currentPos + dir;
+        if (isInside(newPos.x, newPos.y) && getDenseSpecies(newPos.x, newPos.y) == animalconfig::NO_SPECIES) {
+            setDenseEnergy(index, animalconfig::spend(denseStore.energy[index], config.reproductionCost));
+            uint32_t child = spawnDense(denseStore.species[index], newPos, childEntityId(denseStore.id[index]));
+            noteBirth(denseStore.species[index]);
+            recordEvent(EventLog::Type::Birth, denseStore.species[index], denseStore.id[index], denseStore.id[child], currentPos, newPos);
+            return true;
+        }
+    }
+    return false;
+}
+
+kinematics::Vector2D World::findNearestPreyDense(const uint32_t& index) const {
+    ECOSIM_PROFILE_SCOPE(profiler::Phase::FindPrey);
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    animalconfig::SpeciesId preySpecies = registry.getPrey(denseStore.species[index]);
+    if (preySpecies == animalconfig::NO_SPECIES) {
+        return kinematics::Vector2D(-1, -1);
+    }
+    kinematics::Vector2D pos(denseStore.posX[index], denseStore.posY[index]);
+    return findNearest(pos, registry.get(denseStore.species[index]).visionRange, &preySpecies, 1);
+}
+
+kinematics::Vector2D World::findNearestPredatorDense(const uint32_t& index) const {
+    ECOSIM_PROFILE_SCOPE(profiler::Phase::FindPredator);
+    if (denseStore.energy[index] <= 0) {
+        return kinematics::Vector2D(-1, -1);
+    }
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    const std::vector<animalconfig::SpeciesId>& predators = registry.getPredators(denseStore.species[index]);
+    kinematics::Vector2D pos(denseStore.posX[index], denseStore.posY[index]);
+    return findNearest(pos, registry.get(denseStore.species[index]).visionRange, predators.data(), predators.size());
+}
@@ -0,0 +1,113 @@
+#include "../include/DensityPyramid.h"
+#include <algorithm>
+
+void DensityPyramid::reset(const int& newRows, const int& newColumns, const uint32_t& speciesCount) {
+    rows = newRows;
+    columns = newColumns;
+    slots = speciesCount + 1;
+    levels.clear();
+    levelCount = 0;
+    while (getRows(levelCount) > 1 || getColumns(levelCount) > 1) {
+        ++levelCount;
+        if (levelCount < FIRST_STORED_LEVEL)
+            continue;
+        Level level;
+        level.columns = getColumns(levelCount);
+        level.narrow = levelCount <= LAST_NARROW_LEVEL;
+        const size_t blocks = static_cast<size_t>(getRows(levelCount)) * level.columns;
+        if (level.narrow) {
+            level.narrowCounts.assign(blocks * slots, 0);
+        } else {
+            level.counts.assign(blocks * slots, 0);
+        }
+        level.energy.assign(blocks, 0);
+        levels.push_back(std::move(level));
+    }
+}
+
+void DensityPyramid::build(const std::vector<animalconfig::SpeciesId>& species, const std::vector<uint32_t>& energy) {
+    if (levels.empty())
+        return;
+    for (Level& level : levels) {
+        std::fill(level.narrowCounts.begin(), level.narrowCounts.end(), 0);
+        std::fill(level.counts.begin(), level.counts.end(), 0);
+        std::fill(level.energy.begin(), level.energy.end(), 0);
+    }
+
+    Level& first = levels[0];
+    for (int x = 0; x < rows; ++x) {
+        for (int y = 0; y < columns; ++y) {
+            const size_t cellId = static_cast<size_t>(x) * columns + y;
+            if (species[cellId] == animalconfig::NO_SPECIES)
+                continue;
+            const size_t block = static_cast<size_t>(x >> FIRST_STORED_LEVEL) * first.columns + (y >> FIRST_STORED_LEVEL);
+            first.add(block * slots, 1);
+            first.add(block * slots + species[cellId], 1);
+            first.energy[block] += energy[cellId];
+        }
+    }
+
+    for (size_t index = 1; index < levels.size(); ++index) {
+        const Level& below = levels[index - 1];
+        Level& level = levels[index];
+        const int belowRows = getRows(FIRST_STORED_LEVEL + index - 1);
+        for (int x = 0; x < belowRows; ++x) {
+            for (int y = 0; y < below.columns; ++y) {
+                const size_t child = static_cast<size_t>(x) * below.columns + y;
+                const size_t block = static_cast<size_t>(x / 2) * level.columns + y / 2;
+                for (uint32_t slot = 0; slot < slots; ++slot) {
+                    level.add(block * slots + slot, below.getCount(child * slots + slot));
+                }
+                level.energy[block] += below.energy[child];
+            }
+        }
+    }
+}
+
+void DensityPyramid::apply(const int& x, const int& y, const animalconfig::SpeciesId& species, const uint32_t& energy, const int& sign) {
+    if (species == animalconfig::NO_SPECIES)
+        return;
+    for (size_t index = 0; index < levels.size(); ++index) {
+        Level& level = levels[index];
+        const uint32_t shift = FIRST_STORED_LEVEL + index;
+        const size_t block = static_cast<size_t>(x >> shift) * level.columns + (y >> shift);
+        level.add(block * slots, sign);
+        level.add(block * slots + species, sign);
+        level.energy[block] += static_cast<int64_t>(sign) * energy;
+    }
+}
+
+void DensityPyramid::getBlock(const uint32_t& level, const int& x, const int& y, const std::vector<animalconfig::SpeciesId>& species, const std::vector<uint32_t>& energy, Block& block) const {
+    block.counts.assign(slots, 0);
+    block.energy = 0;
+    if (level >= FIRST_STORED_LEVEL) {
+        const Level& blocks = levels[level - FIRST_STORED_LEVEL];
+        const size_t index = static_cast<size_t>(x) * blocks.columns + y;
+        for (uint32_t slot = 0; slot < slots; ++slot) {
+            block.counts[slot] = blocks.getCount(index * slots + slot);
+        }
+        block.energy = blocks.energy[index];
+        return;
+    }
+
+    // A handful of cells a block
+    const int endRow = std::min(rows, (x + 1) << level);
+    const int endColumn = std::min(columns, (y + 1) << level);
+    for (int cellX = x << level; cellX < endRow; ++cellX) {
+        for (int cellY = y << level; cellY < endColumn; ++cellY) {
+            const size_t cellId = static_cast<size_t>(cellX) * columns + cellY;
+            if (species[cellId] == animalconfig::NO_SPECIES)
+                continue;
+            ++block.counts[0];
+            ++block.counts[species[cellId]];
+            block.energy += energy[cellId];
+        }
+    }
+}
+
+uint32_t DensityPyramid::getArea(const uint32_t& level, const int& x, const int& y) const {
+    const int side = 1 << level;
+    const int height = std::min(side, rows - x * side);
+    const int width = std::min(side, columns - y * side);
+    return static_cast<uint32_t>(height) * width;
+}
@@ -0,0 +1,117 @@
+#include "../include/DistanceField.h"
+#include <algorithm>
+
+// With no obstacles the multi-source BFS distance is the Manhattan distance to
+// the nearest source, which splits into a pass along each row followed by a
+// pass down each column. Rows are independent in the first pass and columns in
+// the second, so both run as parallel tiles.
+
+namespace {
+    const uint32_t ROW_TILE = 16;
+    const uint32_t COL_TILE = 64;
+
+    inline uint8_t nextDistance(const uint8_t& distance) {
+        return distance == DistanceField::FAR ? DistanceField::FAR : distance + 1;
+    }
+}
+
+void DistanceField::build(const SpatialIndex& index, const animalconfig::SpeciesId* species, const size_t& count,
+                          const uint32_t& newRadius, WorkerPool* workers) {
+    std::vector<const BitGrid*> planes;
+    for (size_t i = 0; i < count; ++i) {
+        const BitGrid* plane = index.getPlane(species[i]);
+        if (plane != nullptr) {
+            planes.push_back(plane);
+        }
+    }
+
+    radius = std::min(newRadius, MAX_RADIUS);
+    numRows = index.getRows();
+    numCols = index.getCols();
+    const size_t cellCount = static_cast<size_t>(numRows) * numCols;
+    if (planes.empty()) {
+        distances.assign(cellCount, FAR);
+        steps.assign(cellCount, NO_STEP);
+        return;
+    }
+    distances.resize(cellCount);
+    steps.resize(cellCount);
+    const uint32_t cols = numCols;
+    const uint32_t rows = numRows;
+
+    // Along rows: distance to the nearest source in the same row
+    WorkerPool::run(workers, (rows + ROW_TILE - 1) / ROW_TILE, [&](uint32_t tile, uint32_t) {
+        const uint32_t endRow = std::min(rows, (tile + 1) * ROW_TILE);
+        for (uint32_t x = tile * ROW_TILE; x < endRow; ++x) {
+            uint8_t* row = distances.data() + static_cast<size_t>(x) * cols;
+            uint8_t distance = FAR;
+            for (uint32_t word = 0; word * 64 < cols; ++word) {
+                uint64_t bits = 0;
+                for (const BitGrid* plane : planes) {
+                    bits |= plane->getRowWords(x)[word];
+                }
+                const uint32_t end = std::min(cols, (word + 1) * 64);
+                for (uint32_t y = word * 64; y < end; ++y) {
+                    distance = (bits >> (y & 63)) & 1ULL ? 0 : nextDistance(distance);
+                    row[y] = distance;
+                }
+            }
+            distance = FAR;
+            for (uint32_t y = cols; y-- > 0;) {
+                distance = std::min(row[y], nextDistance(distance));
+                row[y] = distance;
+            }
+        }
+    });
+
+    // Down columns, a tile of columns at a time so rows are read contiguously
+    WorkerPool::run(workers, (cols + COL_TILE - 1) / COL_TILE, [&](uint32_t tile, uint32_t) {
+        const uint32_t firstCol = tile * COL_TILE;
+        const uint32_t endCol = std::min(cols, firstCol + COL_TILE);
+        for (uint32_t x = 1; x < rows; ++x) {
+            const uint8_t* above = distances.data() + static_cast<size_t>(x - 1) * cols;
+            uint8_t* row = distances.data() + static_cast<size_t>(x) * cols;
+            for (uint32_t y = firstCol; y < endCol; ++y) {
+                row[y] = std::min(row[y], nextDistance(above[y]));
+            }
+        }
+        for (uint32_t x = rows - 1; x-- > 0;) {
+            const uint8_t* below = distances.data() + static_cast<size_t>(x + 1) * cols;
+            uint8_t* row = distances.data() + static_cast<size_t>(x) * cols;
+            for (uint32_t y = firstCol; y < endCol; ++y) {
+                row[y] = std::min(row[y], nextDistance(below[y]));
+            }
+        }
+    });
+
+    // Cut at the radius and pick the first step that gets one closer
+    WorkerPool::run(workers, (rows + ROW_TILE - 1) / ROW_TILE, [&](uint32_t tile, uint32_t) {
+        const uint32_t endRow = std::min(rows, (tile + 1) * ROW_TILE);
+        for (uint32_t x = tile * ROW_TILE; x < endRow; ++x) {
+            for (uint32_t y = 0; y < cols; ++y) {
+                const size_t cellId = static_cast<size_t>(x) * cols + y;
+                const uint8_t distance = distances[cellId];
+                uint8_t step = NO_STEP;
+                if (distance != 0 && distance <= radius) {
+                    const uint8_t closer = distance - 1;
+                    if (x > 0 && distances[cellId - cols] == closer) step = 0;
+                    else if (y > 0 && distances[cellId - 1] == closer) step = 1;
+                    else if (y + 1 < cols && distances[cellId + 1] == closer) step = 2;
+                    else step = 3;
+                }
+                steps[cellId] = step;
+            }
+        }
+    });
+
+    // Separate pass: the step pass above reads neighbours in other tiles
+    WorkerPool::run(workers, (rows + ROW_TILE - 1) / ROW_TILE, [&](uint32_t tile, uint32_t) {
+        const size_t begin = static_cast<size_t>(tile) * ROW_TILE * cols;
+        const size_t end = static_cast<size_t>(std::min(rows, (tile + 1) * ROW_TILE)) * cols;
+        for (size_t cellId = begin; cellId < end; ++cellId) {
+            if (distances[cellId] > radius) {
+                distances[cellId] = FAR;
+            }
+        }
+    });
+}
@@ -1,6 +1,6 @@
 #include "../include/Entity.h"
 #include "../include/World.h"
-#include <set>
+#include "../include/Profiler.h"
 #include <utility>
 #include <algorithm>
 #include <iostream>
@@ -9,44 +9,60 @@
 
 using namespace std;
 
+namespace {
+    // Species passed by config are looked up by symbol, registering unknown ones
+    animalconfig::SpeciesId registerSpecies(const animalconfig::config& config) {
+        animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+        animalconfig::SpeciesId id = registry.findBySymbol(config.symbol);
+        if (id == animalconfig::NO_SPECIES) {
+            id = registry.add(std::string(1, config.symbol), config, 0, config.prey != ' ');
+        }
+        return id;
+    }
+}
+
 // Standard constructors using singleton
 Entity::Entity(animalconfig::config config, int posX, int posY, int velX, int velY)
-    : entityConfig(config), kinematics::Body(posX, posY, velX, velY), world(World::getInstance())
+    : kinematics::Body(posX, posY, velX, velY), world(World::getInstance()), energy(config.energy), id(world.newEntityId()), speciesId(registerSpecies(config))
 {}
 
 Entity::Entity(animalconfig::config config, int posX, int posY)
-    : entityConfig(config), kinematics::Body(posX, posY), world(World::getInstance())
+    : kinematics::Body(posX, posY), world(World::getInstance()), energy(config.energy), id(world.newEntityId()), speciesId(registerSpecies(config))
 {}
 
 Entity::Entity(animalconfig::config config, kinematics::Vector2D pos)
-    : entityConfig(config), kinematics::Body(pos), world(World::getInstance())
+    : kinematics::Body(pos), world(World::getInstance()), energy(config.energy), id(world.newEntityId()), speciesId(registerSpecies(config))
 {}
 
 // Test-specific constructors with dependency injection
 Entity::Entity(animalconfig::config config, World& testWorld, int posX, int posY, int velX, int velY)
-    : entityConfig(config), kinematics::Body(posX, posY, velX, velY), world(testWorld)
+    : kinematics::Body(posX, posY, velX, velY), world(testWorld), energy(config.energy), id(world.newEntityId()), speciesId(registerSpecies(config))
 {}
 
 Entity::Entity(animalconfig::config config, World& testWorld, int posX, int posY)
-    : entityConfig(config), kinematics::Body(posX, posY), world(testWorld)
+    : kinematics::Body(posX, posY), world(testWorld), energy(config.energy), id(world.newEntityId()), speciesId(registerSpecies(config))
 {}
 
 Entity::Entity(animalconfig::config config, World& testWorld, kinematics::Vector2D pos)
-    : entityConfig(config), kinematics::Body(pos), world(testWorld)
+    : kinematics::Body(pos), world(testWorld), energy(config.energy), id(world.newEntityId()), speciesId(registerSpecies(config))
+{}
+
+Entity::Entity(animalconfig::SpeciesId species, World& world, kinematics::Vector2D pos)
+    : Entity(species, world, pos, world.newEntityId())
+{}
+
+Entity::Entity(animalconfig::SpeciesId species, World& world, kinematics::Vector2D pos, uint64_t id)
+    : kinematics::Body(pos), world(world), energy(animalconfig::SpeciesRegistry::getInstance().get(species).energy), id(id), speciesId(species)
 {}
 
 bool Entity::checkBound(kinematics::Vector2D& pos){
     return pos.x >= 0 && pos.x < world.size.x && pos.y >= 0 && pos.y < world.size.y;
 }
 
-inline uint32_t findDistance(const kinematics::Vector2D& pos1, const kinematics::Vector2D& pos2) {
-    return abs(pos1.x - pos2.x) + abs(pos1.y - pos2.y);
-}
-// Key fixes for Entity.cpp update() method:
+using kinematics::findDistance;
 
 void Entity::update(){
-    if(entityConfig.symbol != animalconfig::CARNIVORE_CONFIG.symbol && 
-       entityConfig.symbol != animalconfig::HERBIVORE_CONFIG.symbol) {
+    if(!animalconfig::SpeciesRegistry::getInstance().isMobile(speciesId)) {
         return;
     }
 
@@ -54,16 +70,17 @@ void Entity::update(){
     kinematics::Vector2D predatorPos = findNearestPredator();
 
     if(predatorPos.x != -1 && predatorPos.y != -1) {
+        ECOSIM_PROFILE_SCOPE(profiler::Phase::Flee);
         moveAwayFromEntity(world.getEntityAt(predatorPos.x, predatorPos.y));
         
-        world.clearCell(currentPos.x, currentPos.y);
-        float probabilityToMove = static_cast<float>(rand()) / RAND_MAX;
+        double probabilityToMove = rng::uniform(world.drawFor(id, rng::FLEE_STREAM));
         if(probabilityToMove >= 0.3){
-            applyVelocity();
             tickEnergy();
+        } else {
+            setVelocity(0, 0);
         }
 
-        world.setEntityAt(getPosition().x, getPosition().y, this);
+        relocate(currentPos);
         
         // std::cout << "Fleeing from predator" << std::endl;
         return;
@@ -75,6 +92,7 @@ void Entity::update(){
 
     kinematics::Vector2D preyPos = findNearestPrey();
     if(preyPos.x != -1 && preyPos.y != -1){
+        ECOSIM_PROFILE_SCOPE(profiler::Phase::Hunt);
         Entity* prey = world.getEntityAt(preyPos.x, preyPos.y);
         
         if(findDistance(currentPos, preyPos) == 1) {
@@ -82,50 +100,64 @@ void Entity::update(){
         }
         
         moveTowardsPosition(preyPos.x, preyPos.y);
-        
-        world.clearCell(currentPos.x, currentPos.y);
-        applyVelocity();
-        world.setEntityAt(getPosition().x, getPosition().y, this);
+        relocate(currentPos);
 
         // std::cout << "Hunting prey" << std::endl;
         return;
     }
 
+    ECOSIM_PROFILE_SCOPE(profiler::Phase::Wander);
     moveRandom();
-    
-    world.clearCell(currentPos.x, currentPos.y);
+    relocate(currentPos);
+    // std::cout << "en: " << energy << " Random movement: " << getVelocity().x << ", " << getVelocity().y << std::endl;
+}
+
+void Entity::tickEnergy(){
+    uint32_t before = energy;
+    energy = animalconfig::spend(energy, getConfig().energyCostPerTick);
+    world.noteEnergy(world.getCellId(getPosition().x, getPosition().y), speciesId, before, energy);
+}
+
+void Entity::relocate(const kinematics::Vector2D& from){
+    world.clearCell(from.x, from.y);
     applyVelocity();
-    world.setEntityAt(getPosition().x, getPosition().y, this);
-    // std::cout << "en: " << entityConfig.energy << " Random movement: " << getVelocity().x << ", " << getVelocity().y << std::endl;
+
+    kinematics::Vector2D pos = getPosition();
+    Entity* occupant = world.getEntityAt(pos.x, pos.y);
+    if(occupant != nullptr && occupant != this){
+        world.recordEvent(EventLog::Type::Kill, speciesId, id, occupant->id, from, pos);
+        world.killEntity(occupant);
+    }
+    if(pos != from){
+        world.recordEvent(EventLog::Type::Move, speciesId, id, 0, from, pos);
+    }
+    world.setEntityAt(pos.x, pos.y, this);
 }
 
 void Entity::moveRandom(){
-    if(entityConfig.energy <= 0 || world.getOccupiedCellsCount() == world.size.x * world.size.y) {
+    if(energy <= 0 || world.isFull()) {
         setVelocity(0, 0);
         return;
     }
 
-    std::set<std::pair<int, int>> directions = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    // Sorted like the std::set this used to be; a fixed array keeps the
+    // allocator out of the tick, which matters once stripes run in parallel
+    kinematics::Vector2D directions[4] = {kinematics::STEPS[0], kinematics::STEPS[1], kinematics::STEPS[2], kinematics::STEPS[3]};
+    uint32_t remaining = 4;
+    uint32_t attempt = 0;
 
-    while(directions.size() > 0){
-        int rndIdx = rand() % directions.size();
-        auto it = directions.begin();
-        advance(it, rndIdx);
+    while(remaining > 0){
+        uint32_t rndIdx = rng::below(world.drawFor(id, rng::WANDER_STREAM, attempt++), remaining);
+        kinematics::Vector2D step = directions[rndIdx];
+        kinematics::Vector2D newPos = getPosition() + step;
 
-        kinematics::Vector2D newPos = getPosition() + kinematics::Vector2D(it->first, it->second);
-
-        if(!checkBound(newPos)) {
-            directions.erase(it);
-            continue;
-        }
-        
-        char newCellSymbol = world.getCellSymbol(newPos.x, newPos.y);
-        if(newCellSymbol != '.'){
-            directions.erase(it);
+        if(!checkBound(newPos) || world.isCellOccupied(newPos.x, newPos.y)) {
+            std::copy(directions + rndIdx + 1, directions + remaining, directions + rndIdx);
+            --remaining;
             continue;
         }
 
-        setVelocity(it->first, it->second);
+        setVelocity(step.x, step.y);
         tickEnergy();
         return;
     }
@@ -134,14 +166,15 @@ void Entity::moveRandom(){
 }
 
 void Entity::moveAwayFromEntity(Entity* entity){
-    if(entity == nullptr || entityConfig.energy <= 0) {
+    if(entity == nullptr || energy <= 0) {
         setVelocity(0, 0);
         return;
     }
     kinematics::Vector2D predatorPos = entity->getPosition();
     kinematics::Vector2D preyPos = getPosition();
 
-    uint8_t preyRank = animalconfig::getEntityRank(entityConfig.symbol);
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    uint8_t preyRank = registry.getRank(speciesId);
     uint32_t curDist = findDistance(predatorPos, preyPos);
 
     for (int x = -1; x <= 1; x++){
@@ -155,8 +188,7 @@ void Entity::moveAwayFromEntity(Entity* entity){
             if(!checkBound(newPos))
                 continue;
 
-            char newCellSymbol = world.getCellSymbol(newPos.x, newPos.y);
-            if(preyRank <= animalconfig::getEntityRank(newCellSymbol))
+            if(preyRank <= registry.getRank(world.getCellSpecies(newPos.x, newPos.y)))
                 continue;
 
             if(newDist > curDist){
@@ -170,7 +202,7 @@ void Entity::moveAwayFromEntity(Entity* entity){
 }
 
 void Entity::moveTowardsEntity(Entity* entity){
-    if(entityConfig.energy <= 0) {
+    if(energy <= 0) {
         setVelocity(0, 0);
         return;
     }
@@ -185,7 +217,8 @@ void Entity::moveTowardsPosition(int posX, int posY){
     kinematics::Vector2D currentPos = getPosition();
 
     uint32_t curDist = findDistance(targetPos, currentPos);
-    uint8_t currentRank = animalconfig::getEntityRank(entityConfig.symbol);
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    uint8_t currentRank = registry.getRank(speciesId);
 
     for (int x = -1; x <= 1; x++){
         for(int y = -1; y <= 1; y++){
@@ -198,8 +231,7 @@ void Entity::moveTowardsPosition(int posX, int posY){
             if(!checkBound(newPos))
                 continue;
                 
-            char newCellSymbol = world.getCellSymbol(newPos.x, newPos.y);
-            if(currentRank <= animalconfig::getEntityRank(newCellSymbol))
+            if(currentRank <= registry.getRank(world.getCellSpecies(newPos.x, newPos.y)))
                 continue;
 
             if(newDist < curDist){
@@ -214,6 +246,7 @@ void Entity::moveTowardsPosition(int posX, int posY){
 }
 
 void Entity::feed(Entity* &prey){
+    ECOSIM_PROFILE_SCOPE(profiler::Phase::Feed);
     if(prey == nullptr){
         return;
     }
@@ -227,34 +260,32 @@ void Entity::feed(Entity* &prey){
         return;
     }
 
-    char preySymbol = world.getCellSymbol(preyPos.x, preyPos.y);
-    if(preySymbol == '.')
-        return;
-
-    char predatorSymbol = world.getCellSymbol(predatorPos.x, predatorPos.y);
-
-    if((preySymbol == animalconfig::PLANT_CONFIG.symbol && predatorSymbol == animalconfig::CARNIVORE_CONFIG.symbol) || preySymbol == predatorSymbol){
+    animalconfig::SpeciesId preySpecies = world.getCellSpecies(preyPos.x, preyPos.y);
+    if(preySpecies == animalconfig::NO_SPECIES || preySpecies != animalconfig::SpeciesRegistry::getInstance().getPrey(speciesId)){
         return;
     }
 
-    entityConfig.energy += entityConfig.energyGainFromEating;
-    entityConfig.energy = std::min(entityConfig.energy, entityConfig.maxEnergy);
+    const animalconfig::config& config = getConfig();
+    uint32_t before = energy;
+    energy += config.energyGainFromEating;
+    energy = std::min(energy, config.maxEnergy);
+    world.noteEnergy(world.getCellId(predatorPos.x, predatorPos.y), speciesId, before, energy);
+    world.recordEvent(EventLog::Type::Kill, speciesId, id, prey->id, predatorPos, preyPos);
     world.killEntity(prey);
 }
 
 bool Entity::reproduce(){
-    animalconfig::config &config = entityConfig;
+    ECOSIM_PROFILE_SCOPE(profiler::Phase::Reproduce);
+    const animalconfig::config &config = getConfig();
     
-    if(config.energy < config.reproductionThreshold){
+    if(energy < config.reproductionThreshold){
         return false;
     }
     
-    kinematics::Vector2D directions[4] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
-    
     kinematics::Vector2D reproductionPos = {-1, -1};
-    for(auto& dir: directions){
+    for(const kinematics::Vector2D& dir: kinematics::BIRTH_STEPS){
         kinematics::Vector2D newPos = getPosition() + dir;
-        if(newPos.x >= 0 && newPos.x < world.size.x && newPos.y >= 0 && newPos.y < world.size.y){
+        if(checkBound(newPos) && !world.isCellOccupied(newPos.x, newPos.y)){
             reproductionPos = newPos;
             break;
         }
@@ -264,68 +295,31 @@ bool Entity::reproduce(){
         return false;
     }
     
-    entityConfig.energy -= config.reproductionCost;
-    Entity *child = new Entity(animalconfig::getConfig(config.symbol), reproductionPos);
-    world.addEntity(child);
+    uint32_t before = energy;
+    energy = animalconfig::spend(energy, config.reproductionCost);
+    world.noteEnergy(world.getCellId(getPosition().x, getPosition().y), speciesId, before, energy);
+    Entity* child = world.spawnEntity(speciesId, reproductionPos, world.childEntityId(id));
+    world.noteBirth(speciesId);
+    world.recordEvent(EventLog::Type::Birth, speciesId, id, child->id, getPosition(), reproductionPos);
     return true;
 }
 
 kinematics::Vector2D Entity::findNearestPrey(){
-    kinematics::Vector2D currentPos = getPosition();
-
-    int minRow = std::max(0, (int)(currentPos.x - entityConfig.visionRange));
-    int maxRow = std::min(world.size.x - 1, (int)(currentPos.x + entityConfig.visionRange));
-
-    int minCol = std::max(0, (int)(currentPos.y - entityConfig.visionRange));
-    int maxCol = std::min(world.size.y - 1, (int)(currentPos.y + entityConfig.visionRange));
-
-    int preyX(-1), preyY(-1);
-    uint32_t minDist = INT_MAX;
-
-    for(int row = minRow; row <= maxRow; ++row){
-        for(int col = minCol; col <= maxCol; ++col){
-            if(entityConfig.prey == world.getCellSymbol(row, col)){
-                uint32_t currentDist = findDistance(currentPos, kinematics::Vector2D(row, col));
-                if(currentDist < minDist){
-                    minDist = currentDist;
-                    preyX = row;
-                    preyY = col;
-                }
-            }
-        }
+    ECOSIM_PROFILE_SCOPE(profiler::Phase::FindPrey);
+    animalconfig::SpeciesId preySpecies = animalconfig::SpeciesRegistry::getInstance().getPrey(speciesId);
+    if(preySpecies == animalconfig::NO_SPECIES) {
+        return kinematics::Vector2D(-1, -1);
     }
-
-    return kinematics::Vector2D(preyX, preyY);
+    return world.findNearest(getPosition(), getConfig().visionRange, &preySpecies, 1);
 }
 
 kinematics::Vector2D Entity::findNearestPredator(){
-    kinematics::Vector2D currentPos = getPosition();
-    if(entityConfig.energy <= 0) {
+    ECOSIM_PROFILE_SCOPE(profiler::Phase::FindPredator);
+    if(energy <= 0) {
         return kinematics::Vector2D(-1, -1);
     }
 
-    uint8_t preyRank = animalconfig::getEntityRank(entityConfig.symbol);
-    
-    int minRow = std::max(0, (int)(currentPos.x - entityConfig.visionRange));
-    int maxRow = std::min(world.size.x - 1, (int)(currentPos.x + entityConfig.visionRange));
-    int minCol = std::max(0, (int)(currentPos.y - entityConfig.visionRange));
-    int maxCol = std::min(world.size.y - 1, (int)(currentPos.y + entityConfig.visionRange));
-
-    kinematics::Vector2D predatorPos(-1, -1);
-    uint32_t minDist = INT_MAX;
-
-    for(int row = minRow; row <= maxRow; ++row){
-        for(int col = minCol; col <= maxCol; ++col){
-            uint8_t cellEntityRank = animalconfig::getEntityRank(world.getCellSymbol(row, col));
-
-            if(cellEntityRank > preyRank) {
-                uint32_t currentDist = findDistance(currentPos, kinematics::Vector2D(row, col));
-                if(currentDist < minDist){
-                    minDist = currentDist;
-                    predatorPos = kinematics::Vector2D(row, col);
-                }
-            }
-        }
-    }
-    return predatorPos;
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    const std::vector<animalconfig::SpeciesId>& predators = registry.getPredators(speciesId);
+    return world.findNearest(getPosition(), registry.get(speciesId).visionRange, predators.data(), predators.size());
 }
\ No newline at end of file
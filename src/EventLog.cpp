@@ -0,0 +1,414 @@
+#include "../include/EventLog.h"
+#include "../include/World.h"
+#include "../include/Checkpoint.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef ECOSIM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+    inline void putVarint(std::vector<unsigned char>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    inline void put64(std::vector<unsigned char>& out, const uint64_t& value) {
+        for (int shift = 0; shift < 64; shift += 8) {
+            out.push_back(static_cast<unsigned char>(value >> shift));
+        }
+    }
+
+    inline uint64_t zigzag(const int64_t& value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+    inline int64_t unzigzag(const uint64_t& value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+    inline bool hasOther(const EventLog::Type& type) { return type == EventLog::Type::Birth || type == EventLog::Type::Kill; }
+
+    // Bounds-checked reads over a decoded chunk
+    class ChunkCursor {
+        public:
+            ChunkCursor(const unsigned char* data, const size_t& size) : cursor(data), end(data + size) {}
+
+            inline bool atEnd() const { return cursor == end; }
+
+            uint64_t varint() {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7) {
+                    const uint64_t byte = take();
+                    value |= (byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0)
+                        return value;
+                }
+                throw std::runtime_error("Corrupt event log: varint too long");
+            }
+
+            uint64_t u64() {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 8) {
+                    value |= static_cast<uint64_t>(take()) << shift;
+                }
+                return value;
+            }
+
+            inline unsigned char take() {
+                if (cursor == end)
+                    throw std::runtime_error("Corrupt event log: chunk ends early");
+                return *cursor++;
+            }
+
+        private:
+            const unsigned char* cursor;
+            const unsigned char* end;
+    };
+}
+
+constexpr char EventLog::MAGIC[8];
+constexpr char EventLog::CHUNK_MAGIC[4];
+constexpr char EventLog::INDEX_MAGIC[8];
+
+EventLog::EventLog(const std::string& path) {
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        throw std::runtime_error("Could not create event log " + path);
+
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.headerBytes = sizeof(header);
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        std::fclose(file);
+        throw std::runtime_error("Could not write event log " + path);
+    }
+    bytesWritten = sizeof(header);
+    raw.reserve(CHUNK_BYTES + CHUNK_BYTES / 4);
+    writer = std::thread(&EventLog::writerLoop, this);
+}
+
+EventLog::~EventLog() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+bool EventLog::isCompressed() {
+#ifdef ECOSIM_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Copied rather than swapped, so every buffer keeps its capacity
+void EventLog::append(std::vector<Event>& events) {
+    current.insert(current.end(), events.begin(), events.end());
+    events.clear();
+}
+
+void EventLog::append(const Event* events, const size_t& count) {
+    current.insert(current.end(), events, events + count);
+}
+
+// Waits while the writer is MAX_PENDING_TICKS behind. Once it has failed,
+// batches are dropped and close() reports the error.
+void EventLog::endTick(const uint64_t& tick) {
+    std::vector<Event> next;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        drained.wait(lock, [this] { return pending.size() < MAX_PENDING_TICKS || writerError; });
+        if (!spare.empty()) {
+            next.swap(spare.back());
+            spare.pop_back();
+        }
+        if (writerError) {
+            current.clear();
+            current.swap(next);
+            return;
+        }
+        pending.push_back(Batch{tick, std::move(current)});
+    }
+    queued.notify_one();
+    current.swap(next);
+}
+
+void EventLog::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed)
+            return;
+        closing = true;
+    }
+    queued.notify_one();
+    if (writer.joinable())
+        writer.join();
+    std::fclose(file);
+    file = nullptr;
+    closed = true;
+    if (writerError)
+        std::rethrow_exception(writerError);
+}
+
+void EventLog::writerLoop() {
+    try {
+        while (true) {
+            Batch batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                queued.wait(lock, [this] { return closing || !pending.empty(); });
+                if (pending.empty())
+                    break;
+                batch = std::move(pending.front());
+                pending.pop_front();
+            }
+            drained.notify_one();
+
+            encodeTick(batch);
+            if (raw.size() >= CHUNK_BYTES)
+                flushChunk();
+
+            batch.events.clear();
+            std::lock_guard<std::mutex> lock(mutex);
+            spare.push_back(std::move(batch.events));
+        }
+
+        flushChunk();
+        Footer footer;
+        footer.indexOffset = bytesWritten;
+        footer.chunkCount = index.size();
+        std::memcpy(footer.magic, INDEX_MAGIC, sizeof(footer.magic));
+        if ((!index.empty() && std::fwrite(index.data(), sizeof(IndexEntry), index.size(), file) != index.size())
+            || std::fwrite(&footer, sizeof(footer), 1, file) != 1 || std::fflush(file) != 0)
+            throw std::runtime_error("Could not write the event log index");
+        bytesWritten += index.size() * sizeof(IndexEntry) + sizeof(footer);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        writerError = std::current_exception();
+        pending.clear();
+        drained.notify_all();
+    }
+}
+
+void EventLog::encodeTick(const Batch& batch) {
+    if (raw.empty()) {
+        chunk = ChunkHeader{};
+        std::memcpy(chunk.magic, CHUNK_MAGIC, sizeof(chunk.magic));
+        chunk.firstTick = batch.tick;
+        lastTick = batch.tick;
+        lastX = 0;
+        lastY = 0;
+    }
+    putVarint(raw, batch.tick - lastTick);
+    putVarint(raw, batch.events.size());
+    for (const Event& event : batch.events) {
+        raw.push_back(static_cast<unsigned char>(static_cast<uint8_t>(event.type) | (event.dx + 1) << 2 | (event.dy + 1) << 4));
+        raw.push_back(event.species);
+        putVarint(raw, zigzag(static_cast<int64_t>(event.x) - lastX));
+        putVarint(raw, zigzag(static_cast<int64_t>(event.y) - lastY));
+        put64(raw, event.entity);
+        if (hasOther(event.type))
+            put64(raw, event.other);
+        lastX = event.x;
+        lastY = event.y;
+    }
+    lastTick = batch.tick;
+    chunk.lastTick = batch.tick;
+    chunk.eventCount += batch.events.size();
+}
+
+void EventLog::flushChunk() {
+    if (raw.empty())
+        return;
+
+    const unsigned char* data = raw.data();
+    chunk.rawBytes = raw.size();
+    chunk.storedBytes = raw.size();
+    chunk.compression = NONE;
+#ifdef ECOSIM_HAVE_ZLIB
+    uLongf storedBytes = compressBound(raw.size());
+    stored.resize(storedBytes);
+    if (compress2(stored.data(), &storedBytes, raw.data(), raw.size(), Z_BEST_SPEED) == Z_OK && storedBytes < raw.size()) {
+        data = stored.data();
+        chunk.storedBytes = storedBytes;
+        chunk.compression = DEFLATE;
+    }
+#endif
+    chunk.checksum = static_cast<uint32_t>(checkpoint::checksum(data, chunk.storedBytes));
+
+    if (std::fwrite(&chunk, sizeof(chunk), 1, file) != 1 || std::fwrite(data, 1, chunk.storedBytes, file) != chunk.storedBytes)
+        throw std::runtime_error("Could not write an event log chunk");
+    index.push_back(IndexEntry{chunk.firstTick, chunk.lastTick, bytesWritten});
+    bytesWritten += sizeof(chunk) + chunk.storedBytes;
+    eventCount.fetch_add(chunk.eventCount, std::memory_order_relaxed);
+    raw.clear();
+}
+
+EventLogReader::EventLogReader(const std::string& path) : path(path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Could not open event log " + path);
+
+    EventLog::FileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, EventLog::MAGIC, sizeof(header.magic)) != 0)
+        throw std::runtime_error("Not an event log: " + path);
+    if (header.version != EventLog::VERSION || header.headerBytes != sizeof(header))
+        throw std::runtime_error("Unsupported event log version " + std::to_string(header.version) + " in " + path);
+
+    file.seekg(0, std::ios::end);
+    const uint64_t size = file.tellg();
+
+    EventLog::Footer footer;
+    if (size >= sizeof(header) + sizeof(footer)) {
+        file.seekg(size - sizeof(footer));
+        file.read(reinterpret_cast<char*>(&footer), sizeof(footer));
+        if (std::memcmp(footer.magic, EventLog::INDEX_MAGIC, sizeof(footer.magic)) == 0
+            && footer.indexOffset + footer.chunkCount * sizeof(EventLog::IndexEntry) + sizeof(footer) == size) {
+            index.resize(footer.chunkCount);
+            file.seekg(footer.indexOffset);
+            if (!index.empty() && !file.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(EventLog::IndexEntry)))
+                throw std::runtime_error("Could not read the event log index of " + path);
+            indexed = true;
+            return;
+        }
+    }
+
+    // No footer: the writer stopped early, keep every complete chunk
+    file.clear();
+    uint64_t offset = sizeof(header);
+    EventLog::ChunkHeader chunk;
+    while (offset + sizeof(chunk) <= size) {
+        file.seekg(offset);
+        if (!file.read(reinterpret_cast<char*>(&chunk), sizeof(chunk)) || std::memcmp(chunk.magic, EventLog::CHUNK_MAGIC, sizeof(chunk.magic)) != 0
+            || offset + sizeof(chunk) + chunk.storedBytes > size)
+            break;
+        index.push_back(EventLog::IndexEntry{chunk.firstTick, chunk.lastTick, offset});
+        offset += sizeof(chunk) + chunk.storedBytes;
+    }
+}
+
+uint64_t EventLogReader::getFirstTick() const {
+    return index.empty() ? 0 : index.front().firstTick;
+}
+
+uint64_t EventLogReader::getLastTick() const {
+    return index.empty() ? 0 : index.back().lastTick;
+}
+
+std::vector<EventLogReader::Record> EventLogReader::read(const uint64_t& firstTick, const uint64_t& endTick) const {
+    std::vector<Record> records;
+    auto first = std::lower_bound(index.begin(), index.end(), firstTick, [](const EventLog::IndexEntry& entry, const uint64_t& tick) {
+        return entry.lastTick < tick;
+    });
+    for (auto entry = first; entry != index.end() && entry->firstTick < endTick; ++entry) {
+        decodeChunk(entry - index.begin(), firstTick, endTick, records);
+    }
+    return records;
+}
+
+void EventLogReader::decodeChunk(const size_t& chunkIndex, const uint64_t& firstTick, const uint64_t& endTick, std::vector<Record>& records) const {
+    std::ifstream file(path, std::ios::binary);
+    EventLog::ChunkHeader chunk;
+    file.seekg(index[chunkIndex].offset);
+    if (!file.read(reinterpret_cast<char*>(&chunk), sizeof(chunk)) || std::memcmp(chunk.magic, EventLog::CHUNK_MAGIC, sizeof(chunk.magic)) != 0)
+        throw std::runtime_error("Corrupt event log: missing chunk in " + path);
+    std::vector<unsigned char> stored(chunk.storedBytes);
+    if (!file.read(reinterpret_cast<char*>(stored.data()), stored.size()))
+        throw std::runtime_error("Corrupt event log: short chunk in " + path);
+    if (static_cast<uint32_t>(checkpoint::checksum(stored.data(), stored.size())) != chunk.checksum)
+        throw std::runtime_error("Corrupt event log: bad checksum in " + path);
+
+    std::vector<unsigned char> raw;
+    if (chunk.compression == EventLog::DEFLATE) {
+#ifdef ECOSIM_HAVE_ZLIB
+        raw.resize(chunk.rawBytes);
+        uLongf rawBytes = chunk.rawBytes;
+        if (uncompress(raw.data(), &rawBytes, stored.data(), stored.size()) != Z_OK || rawBytes != chunk.rawBytes)
+            throw std::runtime_error("Corrupt event log: bad compressed chunk in " + path);
+#else
+        throw std::runtime_error("Event log " + path + " is compressed, but this build has no zlib");
+#endif
+    } else if (chunk.compression == EventLog::NONE) {
+        raw.swap(stored);
+    } else {
+        throw std::runtime_error("Corrupt event log: unknown compression in " + path);
+    }
+
+    ChunkCursor cursor(raw.data(), raw.size());
+    uint64_t tick = chunk.firstTick;
+    int64_t x = 0, y = 0;
+    while (!cursor.atEnd()) {
+        tick += cursor.varint();
+        const uint64_t count = cursor.varint();
+        const bool wanted = tick >= firstTick && tick < endTick;
+        for (uint64_t i = 0; i < count; ++i) {
+            const unsigned char code = cursor.take();
+            Record record;
+            record.tick = tick;
+            record.event.type = static_cast<EventLog::Type>(code & 3);
+            record.event.dx = static_cast<int8_t>((code >> 2 & 3) - 1);
+            record.event.dy = static_cast<int8_t>((code >> 4 & 3) - 1);
+            record.event.species = cursor.take();
+            x += unzigzag(cursor.varint());
+            y += unzigzag(cursor.varint());
+            record.event.x = static_cast<int32_t>(x);
+            record.event.y = static_cast<int32_t>(y);
+            record.event.entity = cursor.u64();
+            record.event.other = hasOther(record.event.type) ? cursor.u64() : 0;
+            if (wanted)
+                records.push_back(record);
+        }
+    }
+}
+
+void World::startEventLog(const std::string& path) {
+    stopEventLog();
+    eventLog.reset(new EventLog(path));
+    serialEvents.clear();
+    for (StripeContext& context : stripeContexts) {
+        context.events.clear();
+        context.eventStripes.clear();
+    }
+}
+
+uint64_t World::stopEventLog() {
+    if (!eventLog)
+        return 0;
+    std::unique_ptr<EventLog> log = std::move(eventLog);
+    log->close();
+    return log->getEventCount();
+}
+
+// Called after each phase of a striped tick, so a phase's events come before
+// the next phase's. Within a phase stripes never touch each other's cells, so
+// stripe order is an order the phase could have run in, and it does not
+// depend on which worker took which stripe.
+void World::appendPhaseEvents() {
+    phaseEvents.clear();
+    for (StripeContext& context : stripeContexts) {
+        for (size_t i = 0; i < context.eventStripes.size(); ++i) {
+            const size_t first = context.eventStripes[i].second;
+            const size_t end = i + 1 < context.eventStripes.size() ? context.eventStripes[i + 1].second : context.events.size();
+            phaseEvents.push_back(StripeEvents{context.eventStripes[i].first, context.events.data() + first, end - first});
+        }
+    }
+    std::sort(phaseEvents.begin(), phaseEvents.end(), [](const StripeEvents& a, const StripeEvents& b) { return a.stripe < b.stripe; });
+    for (const StripeEvents& stripe : phaseEvents) {
+        eventLog->append(stripe.first, stripe.count);
+    }
+    for (StripeContext& context : stripeContexts) {
+        context.events.clear();
+        context.eventStripes.clear();
+    }
+}
+
+// One batch per tick: phases of a striped tick have already been appended,
+// the serial events follow in the order they happened
+void World::flushEvents() {
+    eventLog->append(serialEvents);
+    eventLog->endTick(tick);
+}
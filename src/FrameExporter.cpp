@@ -0,0 +1,288 @@
+#include "../include/FrameExporter.h"
+#include "../include/World.h"
+#include "../include/Palette.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <cstdint>
+
+#ifdef ECOSIM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+    const unsigned char PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    // Largest stored deflate block
+    const size_t STORED_BLOCK = 65535;
+
+    inline void put32(std::vector<uint8_t>& out, const uint32_t& value) {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    uint32_t crc32(const uint8_t* data, const size_t& size) {
+        static const std::vector<uint32_t> table = [] {
+            std::vector<uint32_t> entries(256);
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                entries[n] = c;
+            }
+            return entries;
+        }();
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    // Length, type, data and a CRC of the type and data
+    void appendChunk(std::vector<uint8_t>& png, const char* type, const uint8_t* data, const size_t& size) {
+        put32(png, static_cast<uint32_t>(size));
+        const size_t typeAt = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data, data + size);
+        put32(png, crc32(png.data() + typeAt, png.size() - typeAt));
+    }
+
+    void appendChunk(std::vector<uint8_t>& png, const char* type, const std::vector<uint8_t>& data) {
+        appendChunk(png, type, data.data(), data.size());
+    }
+
+    // A zlib stream of `raw`
+    std::vector<uint8_t> compressZlib(const std::vector<uint8_t>& raw) {
+#ifdef ECOSIM_HAVE_ZLIB
+        uLongf size = compressBound(raw.size());
+        std::vector<uint8_t> stream(size);
+        if (compress2(stream.data(), &size, raw.data(), raw.size(), Z_BEST_SPEED) != Z_OK)
+            throw std::runtime_error("Could not compress a frame");
+        stream.resize(size);
+        return stream;
+#else
+        // Stored blocks: valid deflate without compressing anything
+        std::vector<uint8_t> stream = {0x78, 0x01};
+        uint32_t a = 1, b = 0;
+        size_t offset = 0;
+        do {
+            const size_t length = std::min(STORED_BLOCK, raw.size() - offset);
+            stream.push_back(offset + length == raw.size() ? 1 : 0);
+            stream.push_back(static_cast<uint8_t>(length));
+            stream.push_back(static_cast<uint8_t>(length >> 8));
+            stream.push_back(static_cast<uint8_t>(~length));
+            stream.push_back(static_cast<uint8_t>(~length >> 8));
+            stream.insert(stream.end(), raw.begin() + offset, raw.begin() + offset + length);
+            for (size_t i = offset; i < offset + length; ++i) {
+                a = (a + raw[i]) % 65521;
+                b = (b + a) % 65521;
+            }
+            offset += length;
+        } while (offset < raw.size());
+        put32(stream, b << 16 | a);
+        return stream;
+#endif
+    }
+
+    void writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size()) || !file.flush())
+            throw std::runtime_error("Could not write frame " + path);
+    }
+}
+
+FrameExporter::FrameExporter(const Options& options) : options(options) {
+    if (options.every == 0 || options.cellPixels == 0 || options.cellPixels > 64)
+        throw std::runtime_error("Frames need every >= 1 and 1 to 64 pixels a cell");
+
+    uint32_t count = options.encoders;
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    }
+    count = std::max(1u, count);
+    for (uint32_t i = 0; i < count; ++i) {
+        encoders.emplace_back(&FrameExporter::encoderLoop, this);
+    }
+}
+
+FrameExporter::~FrameExporter() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+std::string FrameExporter::getFramePath(const uint64_t& index) const {
+    char number[32];
+    std::snprintf(number, sizeof(number), "_%06llu", static_cast<unsigned long long>(index));
+    const bool separated = options.directory.empty() || options.directory.back() == '/';
+    return options.directory + (separated ? "" : "/") + options.prefix + number + (options.format == Format::PNG ? ".png" : ".ppm");
+}
+
+void FrameExporter::rasterise(const WorldSnapshot& snapshot, const uint32_t& cellPixels, std::vector<uint8_t>& rgb) {
+    const size_t width = static_cast<size_t>(snapshot.columns) * cellPixels;
+    rgb.resize(width * snapshot.rows * cellPixels * 3);
+    for (int x = 0; x < snapshot.rows; ++x) {
+        // Build the first pixel row of this grid row, then repeat it
+        uint8_t* row = rgb.data() + static_cast<size_t>(x) * cellPixels * width * 3;
+        for (int y = 0; y < snapshot.columns; ++y) {
+            const uint32_t cellId = snapshot.getCellId(x, y);
+            uint8_t color[3];
+            palette::getCellColor(snapshot.species[cellId], snapshot.energy[cellId], color);
+            uint8_t* pixel = row + static_cast<size_t>(y) * cellPixels * 3;
+            for (uint32_t i = 0; i < cellPixels; ++i) {
+                std::copy(color, color + 3, pixel + i * 3);
+            }
+        }
+        for (uint32_t i = 1; i < cellPixels; ++i) {
+            std::copy(row, row + width * 3, row + i * width * 3);
+        }
+    }
+}
+
+void FrameExporter::writePpm(const std::string& path, const uint32_t& width, const uint32_t& height, const std::vector<uint8_t>& rgb) {
+    const std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    std::vector<uint8_t> bytes(header.begin(), header.end());
+    bytes.insert(bytes.end(), rgb.begin(), rgb.end());
+    writeFile(path, bytes);
+}
+
+void FrameExporter::writePng(const std::string& path, const uint32_t& width, const uint32_t& height, const std::vector<uint8_t>& rgb, const size_t& maxChunk) {
+    if (maxChunk == 0 || maxChunk > MAX_CHUNK_DATA)
+        throw std::runtime_error("PNG chunks hold 1 to 2^31 - 1 bytes");
+
+    // Each scanline starts with filter type 0, none
+    const size_t stride = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> raw;
+    raw.reserve((stride + 1) * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb.begin() + y * stride, rgb.begin() + (y + 1) * stride);
+    }
+
+    std::vector<uint8_t> header;
+    put32(header, width);
+    put32(header, height);
+    // 8 bits a channel, truecolour, deflate, no filtering tricks, no interlace
+    const uint8_t format[5] = {8, 2, 0, 0, 0};
+    header.insert(header.end(), format, format + 5);
+
+    std::vector<uint8_t> png(PNG_SIGNATURE, PNG_SIGNATURE + 8);
+    appendChunk(png, "IHDR", header);
+    // One zlib stream, cut into as many IDAT chunks as it takes
+    const std::vector<uint8_t> stream = compressZlib(raw);
+    size_t offset = 0;
+    do {
+        const size_t length = std::min(maxChunk, stream.size() - offset);
+        appendChunk(png, "IDAT", stream.data() + offset, length);
+        offset += length;
+    } while (offset < stream.size());
+    appendChunk(png, "IEND", std::vector<uint8_t>());
+    writeFile(path, png);
+}
+
+void FrameExporter::capture(World& world) {
+    if (!closed && calls % options.every == 0) {
+        // Only the cells changed since the last frame are copied, as SimulationThread does
+        if (!world.isTrackingChanges() && world.getCellCount() <= UINT32_MAX)
+            world.setChangeTracking(true);
+        world.updateSnapshot(latest, world.takeChangedCells(changed) ? &changed : nullptr);
+    }
+    capture(latest);
+}
+
+// Waits while the encoders are MAX_PENDING_FRAMES behind. Once one has
+// failed, frames are dropped and close() reports the error.
+void FrameExporter::capture(const WorldSnapshot& snapshot) {
+    if (closed)
+        throw std::runtime_error("Frame exporter already closed");
+    if (calls++ % options.every != 0)
+        return;
+    const uint64_t width = static_cast<uint64_t>(snapshot.columns) * options.cellPixels;
+    const uint64_t height = static_cast<uint64_t>(snapshot.rows) * options.cellPixels;
+    if (width > MAX_FRAME_SIDE || height > MAX_FRAME_SIDE || width * height > SIZE_MAX / 3)
+        throw std::runtime_error("A frame of " + std::to_string(width) + " x " + std::to_string(height) + " pixels is too large");
+
+    WorldSnapshot frame;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        drained.wait(lock, [this] { return pending.size() < MAX_PENDING_FRAMES || encoderError; });
+        if (encoderError)
+            return;
+        if (!spare.empty()) {
+            frame = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+    // The encoders need the cells only
+    frame.tick = snapshot.tick;
+    frame.rows = snapshot.rows;
+    frame.columns = snapshot.columns;
+    frame.species = snapshot.species;
+    frame.energy = snapshot.energy;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(Frame{framesQueued++, std::move(frame)});
+    }
+    queued.notify_one();
+}
+
+void FrameExporter::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed)
+            return;
+        closing = true;
+    }
+    queued.notify_all();
+    for (std::thread& encoder : encoders) {
+        if (encoder.joinable())
+            encoder.join();
+    }
+    closed = true;
+    if (encoderError)
+        std::rethrow_exception(encoderError);
+}
+
+void FrameExporter::encoderLoop() {
+    std::vector<uint8_t> rgb;
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queued.wait(lock, [this] { return closing || !pending.empty(); });
+            if (pending.empty())
+                return;
+            frame = std::move(pending.front());
+            pending.pop_front();
+        }
+        drained.notify_one();
+
+        try {
+            rasterise(frame.snapshot, options.cellPixels, rgb);
+            const uint32_t width = frame.snapshot.columns * options.cellPixels;
+            const uint32_t height = frame.snapshot.rows * options.cellPixels;
+            if (options.format == Format::PNG) {
+                writePng(getFramePath(frame.index), width, height, rgb);
+            } else {
+                writePpm(getFramePath(frame.index), width, height, rgb);
+            }
+            framesWritten.fetch_add(1, std::memory_order_relaxed);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!encoderError)
+                encoderError = std::current_exception();
+            pending.clear();
+            drained.notify_all();
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        spare.push_back(std::move(frame.snapshot));
+    }
+}
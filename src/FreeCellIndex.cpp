@@ -0,0 +1,36 @@
+#include "../include/FreeCellIndex.h"
+
+void FreeCellIndex::resize(const uint32_t& rows, const uint32_t& cols) {
+    numRows = rows;
+    numCols = cols;
+    blocksPerRow = (cols + BLOCK_SIZE - 1) >> BLOCK_BITS;
+    blockCount = static_cast<size_t>((rows + BLOCK_SIZE - 1) >> BLOCK_BITS) * blocksPerRow;
+    cellCount = static_cast<uint64_t>(rows) * cols;
+    tree.assign(blockCount + 1, 0);
+    clear();
+}
+
+void FreeCellIndex::clear() {
+    rebuild([](uint32_t, uint32_t) { return 0u; });
+}
+
+size_t FreeCellIndex::findBlock(uint64_t& rank) const {
+    size_t step = 1;
+    while (step * 2 <= blockCount) {
+        step *= 2;
+    }
+
+    // Fenwick descent; node `next` covers `step` whole blocks
+    size_t block = 0;
+    for (; step > 0; step >>= 1) {
+        const size_t next = block + step;
+        if (next > blockCount)
+            continue;
+        const uint64_t free = (static_cast<uint64_t>(step) << (2 * BLOCK_BITS)) - tree[next];
+        // Unpredictable, so written to compile to conditional moves
+        const bool skip = free <= rank;
+        rank -= skip ? free : 0;
+        block = skip ? next : block;
+    }
+    return block;
+}
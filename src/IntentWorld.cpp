@@ -0,0 +1,469 @@
+#include "../include/World.h"
+#include "../include/Entity.h"
+#include "../include/VisionKernel.h"
+#include "../include/Profiler.h"
+#include <algorithm>
+#include <cstdlib>
+
+// Intent engine. A tick runs in three steps:
+//  1. plan: every agent decides what to do from the grid as it stood at the
+//     start of the tick. Nothing is written, so rows are planned on all
+//     workers at once, each filling its own intent buffer.
+//  2. resolve: moves onto occupied cells (eating or trampling) are settled
+//     first, highest rank first. Then moves and births into empty cells: each
+//     cell goes to its highest-rank claimant, equal ranks draw lots.
+//  3. commit: deaths, moves, then births are applied to the storage.
+// Every decision depends only on the frozen grid and on draws keyed by
+// (seed, tick, entity), so the outcome does not depend on the number of threads.
+
+namespace {
+    const uint32_t NO_CELL = UINT32_MAX;
+    const uint32_t PLAN_ROWS = 16;
+}
+
+void World::runIntent() {
+    const uint32_t cellCount = static_cast<uint32_t>(size.x) * size.y;
+    const uint32_t threads = getThreadCount();
+
+    if (intentBuffers.size() != threads) {
+        intentBuffers.resize(threads);
+    }
+    if (intentDead.size() != cellCount) {
+        intentDead.assign(cellCount, 0);
+    }
+
+    const uint32_t bands = (size.x + PLAN_ROWS - 1) / PLAN_ROWS;
+    auto forBands = [&](const WorkerPool::Task& task) {
+        WorkerPool::run(workers.get(), bands, task);
+    };
+
+    // Dense storage keeps a species plane already; objects storage gets one per
+    // tick. Both get a rank plane for predator searches.
+    const bool objects = storageMode == StorageMode::Objects;
+    const uint8_t* rankOf = animalconfig::SpeciesRegistry::getInstance().getRankTable();
+    if (objects) {
+        intentPlane.resize(cellCount + vision::PLANE_PADDING, animalconfig::NO_SPECIES);
+    }
+    intentRanks.resize(cellCount + vision::PLANE_PADDING, 0);
+    const animalconfig::SpeciesId* plane = objects ? intentPlane.data() : denseCellSpecies.data();
+    {
+        ECOSIM_PROFILE_SCOPE(profiler::Phase::IntentPlanes);
+        forBands([&](uint32_t band, uint32_t) {
+            uint32_t end = std::min<uint32_t>(size.x, (band + 1) * PLAN_ROWS) * size.y;
+            for (uint32_t cellId = band * PLAN_ROWS * size.y; cellId < end; ++cellId) {
+                if (objects) {
+                    intentPlane[cellId] = grid[cellId] != nullptr ? grid[cellId]->speciesId : animalconfig::NO_SPECIES;
+                }
+                intentRanks[cellId] = rankOf[plane[cellId]];
+            }
+        });
+    }
+
+    if (nearestSearch == NearestSearch::Field) {
+        ECOSIM_PROFILE_SCOPE(profiler::Phase::IntentFields);
+        buildFields();
+    }
+
+    {
+        ECOSIM_PROFILE_SCOPE(profiler::Phase::IntentPlan);
+        forBands([&](uint32_t band, uint32_t worker) {
+            uint32_t firstRow = band * PLAN_ROWS;
+            planRows(firstRow, std::min<uint32_t>(size.x, firstRow + PLAN_ROWS), plane, intentRanks.data(), intentBuffers[worker]);
+        });
+    }
+
+    ECOSIM_PROFILE_SCOPE(profiler::Phase::IntentCommit);
+    commitIntents();
+}
+
+// One prey field per hunted species, as far as its sharpest-eyed hunter sees,
+// and one predator field per species present that has predators
+void World::buildFields() {
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    const uint32_t speciesCount = registry.getCount() + 1;
+    preyFields.resize(speciesCount);
+    predatorFields.resize(speciesCount);
+
+    std::vector<uint32_t> preyRadius(speciesCount, 0);
+    std::vector<uint8_t> hunted(speciesCount, 0);
+    for (uint32_t species = 1; species < speciesCount; ++species) {
+        if (!registry.isMobile(species) || speciesIndex.getCount(species) == 0)
+            continue;
+        const uint32_t range = registry.get(species).visionRange;
+
+        animalconfig::SpeciesId prey = registry.getPrey(species);
+        if (prey != animalconfig::NO_SPECIES && prey != species) {
+            hunted[prey] = 1;
+            preyRadius[prey] = std::max(preyRadius[prey], range);
+        }
+
+        const std::vector<animalconfig::SpeciesId>& predators = registry.getPredators(species);
+        predatorFields[species].build(speciesIndex, predators.data(), predators.size(), range, workers.get());
+    }
+    for (uint32_t prey = 1; prey < speciesCount; ++prey) {
+        if (hunted[prey]) {
+            animalconfig::SpeciesId target = prey;
+            preyFields[prey].build(speciesIndex, &target, 1, preyRadius[prey], workers.get());
+        }
+    }
+}
+
+void World::planRows(const uint32_t& firstRow, const uint32_t& endRow, const animalconfig::SpeciesId* plane, const uint8_t* ranks, std::vector<Intent>& intents) const {
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    const bool full = isFull();
+    const bool useFields = nearestSearch == NearestSearch::Field;
+
+    // A row's priority draws are made in one block
+    std::vector<uint64_t> rowIds, rowPriorities;
+    rowIds.reserve(size.y);
+    rowPriorities.reserve(size.y);
+
+    for (int x = firstRow; x < static_cast<int>(endRow); ++x) {
+        rowIds.clear();
+        for (uint32_t cellId = x * size.y; cellId < static_cast<uint32_t>(x + 1) * size.y; ++cellId) {
+            if (plane[cellId] != animalconfig::NO_SPECIES)
+                rowIds.push_back(getIdAt(cellId));
+        }
+        rowPriorities.resize(rowIds.size());
+        drawBlockFor(rowIds.data(), rowIds.size(), rng::PRIORITY_STREAM, rowPriorities.data());
+
+        size_t agent = 0;
+        for (int y = 0; y < size.y; ++y) {
+            const uint32_t cellId = x * size.y + y;
+            const animalconfig::SpeciesId species = plane[cellId];
+            if (species == animalconfig::NO_SPECIES)
+                continue;
+
+            const uint32_t energy = getEnergyAt(cellId);
+            const uint64_t id = rowIds[agent];
+            const kinematics::Vector2D pos(x, y);
+
+            Intent intent;
+            intent.source = cellId;
+            intent.target = cellId;
+            intent.energy = energy;
+            intent.priority = static_cast<uint32_t>(rowPriorities[agent++]);
+            intent.rank = ranks[cellId];
+            intent.action = Intent::Action::Stay;
+            intent.eats = false;
+
+            if (energy <= 0) {
+                intent.action = Intent::Action::Die;
+                intents.push_back(intent);
+                continue;
+            }
+            if (!registry.isMobile(species))
+                continue;
+
+            const animalconfig::config& config = registry.get(species);
+            const int visionRange = config.visionRange;
+
+            // First step that is inside, onto a lower rank, and moves the right way from `other`
+            auto pickStep = [&](const kinematics::Vector2D& other, bool away) {
+                uint32_t curDist = kinematics::findDistance(other, pos);
+                for (const kinematics::Vector2D& step : kinematics::STEPS) {
+                    kinematics::Vector2D newPos = pos + step;
+                    if (!isInside(newPos.x, newPos.y))
+                        continue;
+                    uint32_t newCell = newPos.x * size.y + newPos.y;
+                    if (intent.rank <= ranks[newCell])
+                        continue;
+                    uint32_t newDist = kinematics::findDistance(other, newPos);
+                    if (away ? newDist > curDist : newDist < curDist)
+                        return newCell;
+                }
+                return NO_CELL;
+            };
+            // Same, judged by a distance field: away means further from every source
+            auto pickFieldStep = [&](const DistanceField& field, bool away) {
+                const uint8_t curDist = field.getDistance(cellId);
+                if (!away && field.getStep(cellId) != DistanceField::NO_STEP) {
+                    kinematics::Vector2D newPos = pos + kinematics::STEPS[field.getStep(cellId)];
+                    uint32_t newCell = newPos.x * size.y + newPos.y;
+                    if (intent.rank > ranks[newCell])
+                        return newCell;
+                }
+                for (const kinematics::Vector2D& step : kinematics::STEPS) {
+                    kinematics::Vector2D newPos = pos + step;
+                    if (!isInside(newPos.x, newPos.y))
+                        continue;
+                    uint32_t newCell = newPos.x * size.y + newPos.y;
+                    if (intent.rank <= ranks[newCell])
+                        continue;
+                    uint8_t newDist = field.getDistance(newCell);
+                    if (away ? newDist > curDist : newDist < curDist)
+                        return newCell;
+                }
+                return NO_CELL;
+            };
+            auto moveTo = [&](const uint32_t& newCell, const uint32_t& newEnergy) {
+                intent.target = newCell;
+                intent.energy = newEnergy;
+                intent.action = plane[newCell] == animalconfig::NO_SPECIES ? Intent::Action::Move : Intent::Action::Displace;
+            };
+
+            const DistanceField* predatorField = useFields ? &predatorFields[species] : nullptr;
+            kinematics::Vector2D predatorPos(-1, -1);
+            if (predatorField == nullptr && intent.rank < UINT8_MAX) {
+                vision::Match above = {static_cast<uint8_t>(intent.rank + 1), UINT8_MAX};
+                predatorPos = vision::findNearest(ranks, size, pos, visionRange, above);
+            }
+            if (predatorField != nullptr ? predatorField->reaches(cellId, config.visionRange) : predatorPos.x != -1) {
+                // Freezes 30% of the time, like the sweep engine
+                double probabilityToMove = rng::uniform(drawFor(id, rng::FLEE_STREAM));
+                if (probabilityToMove < 0.3)
+                    continue;
+
+                uint32_t newCell = predatorField != nullptr ? pickFieldStep(*predatorField, true) : pickStep(predatorPos, true);
+                if (newCell == NO_CELL) {
+                    intent.energy = animalconfig::spend(energy, config.energyCostPerTick);
+                } else {
+                    moveTo(newCell, animalconfig::spend(energy, config.energyCostPerTick));
+                }
+                intents.push_back(intent);
+                continue;
+            }
+
+            if (energy >= config.reproductionThreshold) {
+                bool planned = false;
+                for (const kinematics::Vector2D& dir : kinematics::BIRTH_STEPS) {
+                    kinematics::Vector2D newPos = pos + dir;
+                    if (isInside(newPos.x, newPos.y) && plane[newPos.x * size.y + newPos.y] == animalconfig::NO_SPECIES) {
+                        intent.action = Intent::Action::Reproduce;
+                        intent.target = newPos.x * size.y + newPos.y;
+                        intent.energy = animalconfig::spend(energy, config.reproductionCost);
+                        intents.push_back(intent);
+                        planned = true;
+                        break;
+                    }
+                }
+                if (planned)
+                    continue;
+            }
+
+            animalconfig::SpeciesId prey = registry.getPrey(species);
+            if (prey != animalconfig::NO_SPECIES) {
+                // A field cannot leave out the searcher's own cell, so cannibals search
+                const DistanceField* preyField = useFields && prey != species ? &preyFields[prey] : nullptr;
+                kinematics::Vector2D preyPos(-1, -1);
+                uint32_t preyDist = 0;
+                if (preyField != nullptr) {
+                    if (preyField->reaches(cellId, config.visionRange)) {
+                        preyDist = preyField->getDistance(cellId);
+                        preyPos = pos + kinematics::STEPS[preyField->getStep(cellId)];   // Only the first step, the prey itself when adjacent
+                    }
+                } else {
+                    vision::Match same = {prey, prey};
+                    preyPos = vision::findNearest(plane, size, pos, visionRange, same);
+                    preyDist = kinematics::findDistance(pos, preyPos);
+                }
+                if (preyPos.x != -1) {
+                    if (preyDist == 1) {
+                        intent.action = Intent::Action::Displace;
+                        intent.eats = true;
+                        intent.target = preyPos.x * size.y + preyPos.y;
+                        intent.energy = animalconfig::spend(std::min(energy + config.energyGainFromEating, config.maxEnergy), config.energyCostPerTick);
+                        intents.push_back(intent);
+                    } else {
+                        uint32_t newCell = preyField != nullptr ? pickFieldStep(*preyField, false) : pickStep(preyPos, false);
+                        if (newCell != NO_CELL) {
+                            moveTo(newCell, animalconfig::spend(energy, config.energyCostPerTick));
+                            intents.push_back(intent);
+                        }
+                    }
+                    continue;
+                }
+            }
+
+            if (full)
+                continue;
+
+            uint32_t openCells[4];
+            uint32_t openCount = 0;
+            for (const kinematics::Vector2D& step : kinematics::STEPS) {
+                kinematics::Vector2D newPos = pos + step;
+                if (isInside(newPos.x, newPos.y) && plane[newPos.x * size.y + newPos.y] == animalconfig::NO_SPECIES) {
+                    openCells[openCount++] = newPos.x * size.y + newPos.y;
+                }
+            }
+            if (openCount > 0) {
+                moveTo(openCells[rng::below(drawFor(id, rng::WANDER_STREAM), openCount)], animalconfig::spend(energy, config.energyCostPerTick));
+                intents.push_back(intent);
+            }
+        }
+    }
+}
+
+void World::commitIntents() {
+    std::vector<Intent> displacements, claims, stays;
+    std::vector<uint32_t> starved, deadCells;
+
+    // Highest rank first, then the lower draw, then the lower cell
+    auto outranks = [](const Intent& a, const Intent& b) {
+        if (a.rank != b.rank)
+            return a.rank > b.rank;
+        if (a.priority != b.priority)
+            return a.priority < b.priority;
+        return a.source < b.source;
+    };
+
+    for (std::vector<Intent>& buffer : intentBuffers) {
+        for (const Intent& intent : buffer) {
+            switch (intent.action) {
+                case Intent::Action::Die:
+                    starved.push_back(intent.source);
+                    break;
+                case Intent::Action::Stay:
+                    stays.push_back(intent);
+                    break;
+                case Intent::Action::Displace:
+                    displacements.push_back(intent);
+                    break;
+                case Intent::Action::Move:
+                case Intent::Action::Reproduce:
+                    claims.push_back(intent);
+                    break;
+            }
+        }
+        buffer.clear();
+    }
+
+    // Workers pick up bands in no fixed order, so deaths are put back in cell
+    // order before they reach the event log or the storage
+    std::sort(starved.begin(), starved.end());
+    for (const uint32_t& cellId : starved) {
+        if (eventLog)
+            recordAt(EventLog::Type::Starve, cellId, cellId);
+        intentDead[cellId] = 1;
+        deadCells.push_back(cellId);
+    }
+
+    // Moves onto occupied cells: each occupant falls to the strongest agent
+    // reaching for it, and an agent that falls first never acts
+    std::sort(displacements.begin(), displacements.end(), outranks);
+    std::vector<Intent> accepted;
+    for (const Intent& intent : displacements) {
+        if (intentDead[intent.source] || intentDead[intent.target])
+            continue;
+        intentDead[intent.target] = 1;
+        deadCells.push_back(intent.target);
+        accepted.push_back(intent);
+        if (eventLog)
+            recordAt(EventLog::Type::Kill, intent.source, intent.target);
+    }
+
+    // Moves and births into empty cells: one winner per cell
+    std::sort(claims.begin(), claims.end(), [&](const Intent& a, const Intent& b) {
+        if (a.target != b.target)
+            return a.target < b.target;
+        return outranks(a, b);
+    });
+    uint32_t claimedCell = NO_CELL;
+    for (const Intent& intent : claims) {
+        if (intent.target == claimedCell || intentDead[intent.source])
+            continue;
+        claimedCell = intent.target;
+        accepted.push_back(intent);
+    }
+
+    for (const uint32_t& cellId : deadCells) {
+        killAt(cellId);
+    }
+
+    for (const Intent& intent : accepted) {
+        if (intent.action == Intent::Action::Reproduce) {
+            kinematics::Vector2D parentPos = getCellCoordinates(intent.source);
+            animalconfig::SpeciesId species = getCellSpecies(parentPos.x, parentPos.y);
+            setEnergyAt(intent.source, intent.energy);
+            const uint64_t childId = childEntityId(getIdAt(intent.source));
+            if (storageMode == StorageMode::Dense) {
+                spawnDense(species, getCellCoordinates(intent.target), childId);
+            } else {
+                spawnEntity(species, getCellCoordinates(intent.target), childId);
+            }
+            noteBirth(species);
+            if (eventLog)
+                recordAt(EventLog::Type::Birth, intent.source, intent.target);
+        } else {
+            if (eventLog)
+                recordAt(EventLog::Type::Move, intent.source, intent.target);
+            moveAt(intent.source, intent.target);
+            setEnergyAt(intent.target, intent.energy);
+        }
+    }
+
+    for (const Intent& intent : stays) {
+        if (!intentDead[intent.source]) {
+            setEnergyAt(intent.source, intent.energy);
+        }
+    }
+
+    for (const uint32_t& cellId : deadCells) {
+        intentDead[cellId] = 0;
+    }
+    if (storageMode == StorageMode::Dense) {
+        denseStore.recycle();
+    }
+}
+
+uint32_t World::getEnergyAt(const uint32_t& cellId) const {
+    if (storageMode == StorageMode::Dense) {
+        return denseStore.energy[denseGrid[cellId]];
+    }
+    return grid[cellId]->energy;
+}
+
+uint64_t World::getIdAt(const uint32_t& cellId) const {
+    if (storageMode == StorageMode::Dense) {
+        return denseStore.id[denseGrid[cellId]];
+    }
+    return grid[cellId]->id;
+}
+
+// Between cells, while both are occupied for kills and births
+void World::recordAt(const EventLog::Type& type, const uint32_t& from, const uint32_t& to) {
+    kinematics::Vector2D pos = getCellCoordinates(from);
+    const bool withOther = type == EventLog::Type::Kill || type == EventLog::Type::Birth;
+    recordEvent(type, getCellSpecies(pos.x, pos.y), getIdAt(from), withOther ? getIdAt(to) : 0, pos, getCellCoordinates(to));
+}
+
+void World::setEnergyAt(const uint32_t& cellId, const uint32_t& energy) {
+    if (storageMode == StorageMode::Dense) {
+        setDenseEnergy(denseGrid[cellId], energy);
+    } else {
+        Entity* entity = grid[cellId];
+        noteEnergy(cellId, entity->speciesId, entity->energy, energy);
+        entity->energy = energy;
+    }
+}
+
+void World::killAt(const uint32_t& cellId) {
+    if (storageMode == StorageMode::Dense) {
+        killDense(denseGrid[cellId]);
+        return;
+    }
+    Entity* entity = grid[cellId];
+    killEntity(entity);
+}
+
+void World::moveAt(const uint32_t& from, const uint32_t& to) {
+    kinematics::Vector2D fromPos = getCellCoordinates(from);
+    kinematics::Vector2D toPos = getCellCoordinates(to);
+
+    if (storageMode == StorageMode::Dense) {
+        uint32_t index = denseGrid[from];
+        vacateDense(fromPos.x, fromPos.y);
+        denseStore.posX[index] = toPos.x;
+        denseStore.posY[index] = toPos.y;
+        denseStore.velX[index] = toPos.x - fromPos.x;
+        denseStore.velY[index] = toPos.y - fromPos.y;
+        placeDense(index, toPos.x, toPos.y);
+        return;
+    }
+
+    Entity* entity = grid[from];
+    clearCell(fromPos.x, fromPos.y);
+    entity->setVelocity(toPos.x - fromPos.x, toPos.y - fromPos.y);
+    entity->setPosition(toPos.x, toPos.y);
+    setEntityAt(toPos.x, toPos.y, entity);
+}
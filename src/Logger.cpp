@@ -0,0 +1,146 @@
+#include "../include/Logger.h"
+#include <algorithm>
+
+namespace logging {
+    Logger::Logger() : slots(new Slot[CAPACITY]), start(std::chrono::steady_clock::now()) {
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Logger capacity must be a power of two");
+        for (size_t i = 0; i < CAPACITY; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        batch.reserve(64 * 1024);
+        writer = std::thread(&Logger::writerLoop, this);
+    }
+
+    Logger::~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (writer.joinable())
+            writer.join();
+    }
+
+    const char* Logger::getLevelName(const Level& level) {
+        switch (level) {
+            case Level::Debug: return "DEBUG";
+            case Level::Info: return "INFO ";
+            case Level::Warning: return "WARN ";
+            case Level::Error: return "ERROR";
+            default: return "     ";
+        }
+    }
+
+    Logger::Slot* Logger::claim(uint64_t& position) {
+        position = enqueuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[position & (CAPACITY - 1)];
+            const int64_t difference = static_cast<int64_t>(slot.sequence.load(std::memory_order_acquire) - position);
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    return &slot;
+            } else if (difference < 0) {
+                // The writer has not freed this slot yet: the ring is full
+                return nullptr;
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void Logger::captureText(Message& message, const char* value, const size_t& length) {
+        Arg& arg = message.args[message.argCount++];
+        arg.type = Arg::Type::Text;
+        const size_t copied = std::min(length, TEXT_BYTES - message.textUsed);
+        arg.offset = message.textUsed;
+        arg.length = static_cast<uint8_t>(copied);
+        std::memcpy(message.text + message.textUsed, value, copied);
+        message.textUsed = static_cast<uint8_t>(message.textUsed + copied);
+    }
+
+    void Logger::format(const Message& message) {
+        char number[32];
+        const double seconds = std::chrono::duration<double>(message.time - start).count();
+        batch.append(number, std::snprintf(number, sizeof(number), "[%10.3f] ", seconds));
+        batch += getLevelName(message.level);
+        batch += ' ';
+
+        size_t next = 0;
+        for (const char* c = message.format; *c != '\0'; ++c) {
+            if (c[0] != '{' || c[1] != '}' || next >= message.argCount) {
+                batch += *c;
+                continue;
+            }
+            const Arg& arg = message.args[next++];
+            switch (arg.type) {
+                case Arg::Type::Signed: batch += std::to_string(arg.i); break;
+                case Arg::Type::Unsigned: batch += std::to_string(arg.u); break;
+                case Arg::Type::Double: batch.append(number, std::snprintf(number, sizeof(number), "%g", arg.d)); break;
+                case Arg::Type::Char: batch += static_cast<char>(arg.u); break;
+                case Arg::Type::Bool: batch += arg.u ? "true" : "false"; break;
+                case Arg::Type::Text: batch.append(message.text + arg.offset, arg.length); break;
+            }
+            ++c;
+        }
+        batch += '\n';
+    }
+
+    size_t Logger::drain() {
+        size_t count = 0;
+        while (true) {
+            Slot& slot = slots[dequeuePosition & (CAPACITY - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+                break;
+            format(slot.message);
+            slot.sequence.store(dequeuePosition + CAPACITY, std::memory_order_release);
+            ++dequeuePosition;
+            ++count;
+        }
+        const uint64_t droppedNow = dropped.load(std::memory_order_relaxed);
+        if (droppedNow != droppedReported) {
+            batch += "[dropped " + std::to_string(droppedNow - droppedReported) + " log messages]\n";
+            droppedReported = droppedNow;
+        }
+        return count;
+    }
+
+    void Logger::writerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            lock.unlock();
+            const size_t count = drain();
+            lock.lock();
+            if (!batch.empty()) {
+                std::fwrite(batch.data(), 1, batch.size(), output);
+                std::fflush(output);
+                batch.clear();
+            }
+            writtenPosition = dequeuePosition;
+            if (flushRequested) {
+                flushRequested = false;
+                written.notify_all();
+            }
+            if (count > 0)
+                continue;
+            if (stopping)
+                return;
+            wake.wait_for(lock, FLUSH_INTERVAL);
+        }
+    }
+
+    void Logger::flush() {
+        const uint64_t target = enqueuePosition.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (writtenPosition < target) {
+            flushRequested = true;
+            wake.notify_one();
+            written.wait_for(lock, FLUSH_INTERVAL);
+        }
+    }
+
+    void Logger::setOutput(std::FILE* output) {
+        flush();
+        std::lock_guard<std::mutex> lock(mutex);
+        this->output = output;
+    }
+}
@@ -0,0 +1,41 @@
+#include "../include/Palette.h"
+#include "../include/Rng.h"
+#include <algorithm>
+
+namespace {
+    // Ground under empty cells and fading agents
+    const uint8_t BACKGROUND[3] = {48, 40, 32};
+}
+
+void palette::getCellColor(const animalconfig::SpeciesId& species, const uint32_t& energy, uint8_t rgb[3]) {
+    std::copy(BACKGROUND, BACKGROUND + 3, rgb);
+    if (species == animalconfig::NO_SPECIES)
+        return;
+
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    const char symbol = registry.get(species).symbol;
+    uint8_t color[3];
+    if (symbol == animalconfig::PLANT_CONFIG.symbol) {
+        color[0] = 64; color[1] = 168; color[2] = 64;
+    } else if (symbol == animalconfig::HERBIVORE_CONFIG.symbol) {
+        color[0] = 236; color[1] = 232; color[2] = 212;
+    } else if (symbol == animalconfig::CARNIVORE_CONFIG.symbol) {
+        color[0] = 112; color[1] = 112; color[2] = 128;
+    } else {
+        // Configured species get a stable colour of their own
+        const uint64_t bits = rng::mix(static_cast<unsigned char>(symbol));
+        for (int channel = 0; channel < 3; ++channel) {
+            color[channel] = static_cast<uint8_t>(96 + (bits >> (channel * 8) & 0x9F));
+        }
+    }
+
+    if (isFading(species, energy)) {
+        // Tinted and blended over the ground, as the viewer draws it
+        const uint32_t alpha = getFadeAlpha(energy);
+        for (int channel = 0; channel < 3; ++channel) {
+            const uint32_t tinted = color[channel] * FADE_TINT[channel] / 255;
+            color[channel] = static_cast<uint8_t>((tinted * alpha + rgb[channel] * (255 - alpha)) / 255);
+        }
+    }
+    std::copy(color, color + 3, rgb);
+}
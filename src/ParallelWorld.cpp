@@ -0,0 +1,173 @@
+#include "../include/World.h"
+#include "../include/Entity.h"
+#include "../include/Profiler.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+// Striped parallel ticks. The grid is cut into bands of getStripeRows() rows.
+// Even stripes are updated concurrently, then odd stripes: two stripes running
+// at the same time are a whole stripe apart, which is more than any agent can
+// see (visionRange) or touch (one cell), so no cell is written by one thread
+// while another reads it.
+//
+// Shared bookkeeping is kept out of the stripes: kills are retired after each
+// phase, births take spawnMutex and the occupancy and species index counts are
+// recounted at the end. Random draws are keyed by entity and tick, and the
+// stripe layout does not depend on the thread count, so neither does the
+// outcome of a tick. A single thread runs the same stripes one after another.
+
+namespace {
+    const uint32_t MIN_STRIPE_ROWS = 16;
+}
+
+void World::setThreadCount(uint32_t count) {
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (count == getThreadCount()) {
+        return;
+    }
+    if (count > 1 && gridLayout == GridLayout::Chunked) {
+        throw std::runtime_error("The chunked grid layout runs the sweep engine on a single thread");
+    }
+    workers.reset(count > 1 ? new WorkerPool(count) : nullptr);
+    stripeContexts.assign(count, StripeContext());
+}
+
+uint32_t World::getStripeRows() const {
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    uint32_t vision = 0;
+    for (uint32_t id = 1; id <= registry.getCount(); ++id) {
+        vision = std::max(vision, registry.get(id).visionRange);
+    }
+    return std::max(MIN_STRIPE_ROWS, vision + 2);
+}
+
+void World::runStriped() {
+    const bool dense = storageMode == StorageMode::Dense;
+    const uint32_t stripeRows = getStripeRows();
+    const uint32_t stripeCount = (size.x + stripeRows - 1) / stripeRows;
+    const uint32_t rowEnd = size.x;
+    const animalconfig::SpeciesId herbivore = animalconfig::SpeciesRegistry::getInstance().findBySymbol(animalconfig::HERBIVORE_CONFIG.symbol);
+
+    if (dense) {
+        // Newborns sit out the tick, so each live agent adds at most one slot
+        size_t needed = static_cast<size_t>(denseStore.getSlotCount()) + denseStore.getLiveCount();
+        if (denseStore.getCapacity() < needed) {
+            denseStore.reserve(needed + needed / 2);
+        }
+    }
+    ++generation;
+
+    gridOccupied.pauseCount();
+    speciesIndex.pauseCount();
+
+    // Herbivores first, as in the serial tick
+    for (uint32_t pass = 0; pass < 2; ++pass) {
+        ECOSIM_PROFILE_SCOPE(pass == 0 ? profiler::Phase::HerbivorePass : profiler::Phase::AgentPass);
+        for (uint32_t parity = 0; parity < 2; ++parity) {
+            const uint32_t tasks = (stripeCount + 1 - parity) / 2;
+
+            const WorkerPool::Task update = [&](uint32_t task, uint32_t worker) {
+                uint32_t stripe = task * 2 + parity;
+                uint32_t firstRow = stripe * stripeRows;
+                uint32_t endRow = std::min(rowEnd, firstRow + stripeRows);
+
+                stripeContext = &stripeContexts[worker];
+                if (eventLog) {
+                    stripeContext->eventStripes.emplace_back(stripe, stripeContext->events.size());
+                }
+                if (dense) {
+                    updateStripeDense(firstRow, endRow, pass == 0, herbivore);
+                } else {
+                    updateStripe(firstRow, endRow, pass == 0, herbivore);
+                }
+                stripeContext = nullptr;
+            };
+            WorkerPool::run(workers.get(), tasks, update);
+            ECOSIM_PROFILE_SCOPE(profiler::Phase::Merge);
+            retireDeferred();
+            if (eventLog) {
+                appendPhaseEvents();
+            }
+        }
+    }
+
+    gridOccupied.resumeCount();
+    speciesIndex.resumeCount();
+    if (dense) {
+        denseStore.recycle();
+    }
+}
+
+// Only occupied cells are visited: the herbivore pass walks the herbivore
+// bitplane, the full pass the occupancy bitplane, both in row-major order.
+void World::updateStripe(const uint32_t& firstRow, const uint32_t& endRow, const bool& herbivoresOnly, const animalconfig::SpeciesId& herbivore) {
+    const BitGrid* cells = herbivoresOnly ? speciesIndex.getPlane(herbivore) : &gridOccupied;
+    if (cells == nullptr)
+        return;
+
+    cells->forEachSet(firstRow, endRow, [&](uint32_t x, uint32_t y) {
+        Entity* entity = grid[x * size.y + y];
+        if (entity->updatedGeneration == generation)
+            return;
+
+        if (entity->energy <= 0) {
+            recordEvent(EventLog::Type::Starve, entity->speciesId, entity->id, 0, kinematics::Vector2D(x, y), kinematics::Vector2D(x, y));
+            killEntity(entity);
+        } else {
+            entity->update();
+        }
+
+        if (entity != nullptr) {
+            entity->updatedGeneration = generation;
+        }
+    });
+}
+
+void World::updateStripeDense(const uint32_t& firstRow, const uint32_t& endRow, const bool& herbivoresOnly, const animalconfig::SpeciesId& herbivore) {
+    const BitGrid* cells = herbivoresOnly ? speciesIndex.getPlane(herbivore) : &gridOccupied;
+    if (cells == nullptr)
+        return;
+
+    cells->forEachSet(firstRow, endRow, [&](uint32_t x, uint32_t y) {
+        uint32_t index = denseGrid[x * size.y + y];
+        if (denseStore.updated[index] == generation)
+            return;
+
+        if (denseStore.energy[index] <= 0) {
+            recordEvent(EventLog::Type::Starve, denseStore.species[index], denseStore.id[index], 0, kinematics::Vector2D(x, y), kinematics::Vector2D(x, y));
+            killDense(index);
+        } else {
+            updateDense(index);
+        }
+        denseStore.updated[index] = generation;
+    });
+}
+
+void World::retireDeferred() {
+    for (StripeContext& context : stripeContexts) {
+        for (Entity* entity : context.retiredEntities) {
+            if (entityPool.owns(entity)) {
+                entityPool.release(entity);
+            } else {
+                delete entity;
+            }
+        }
+        context.retiredEntities.clear();
+
+        for (const uint32_t& index : context.retiredSlots) {
+            denseStore.remove(index);
+        }
+        context.retiredSlots.clear();
+        stats.merge(context.tallies);
+
+        if (changedCells.size() + context.changedCells.size() <= getCellCount()) {
+            changedCells.insert(changedCells.end(), context.changedCells.begin(), context.changedCells.end());
+        } else if (trackChanges) {
+            changesOverflowed = true;
+        }
+        context.changedCells.clear();
+    }
+}
@@ -0,0 +1,278 @@
+#include "../include/World.h"
+#include "../include/Entity.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Bulk seeding. Poisson-disk populations are placed first, as their darts
+// need the most room, then clustered ones, then every uniform population in a
+// single batch: one set of empty cells is picked for all of them and the
+// species are dealt to it by a shuffle. Large batches on flat grids pick their
+// cells with parallel passes over the occupancy words and write the grid from
+// row tiles on the world's workers. Every draw comes from the world's own
+// stream or is keyed by cell, so the result depends on the seed alone.
+
+namespace {
+    const uint32_t TILE_ROWS = 64;
+    const uint32_t KEY_BUCKET_BITS = 12;
+    const uint32_t DENSE_BATCH = 8;         // Grid passes once a batch fills 1/8 of the free cells
+    const uint32_t POISSON_TRIES = 30;      // Darts per agent before giving up
+    const uint32_t CLUSTER_TRIES = 8;       // Gaussian draws per agent before any empty cell will do
+    const double TWO_PI = 6.283185307179586;
+
+    inline bool rowMajorLess(const kinematics::Vector2D& a, const kinematics::Vector2D& b) {
+        return a.x != b.x ? a.x < b.x : a.y < b.y;
+    }
+}
+
+std::vector<uint64_t> World::populate(const std::vector<Population>& populations) {
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    std::vector<uint64_t> targets(populations.size()), placed(populations.size(), 0);
+    uint64_t total = 0;
+    for (size_t i = 0; i < populations.size(); ++i) {
+        const Population& population = populations[i];
+        if (population.species == animalconfig::NO_SPECIES || population.species > registry.getCount()) {
+            throw std::runtime_error("Cannot populate an unknown species");
+        }
+        targets[i] = population.count != 0 ? population.count : static_cast<uint64_t>(std::llround(population.density * getCellCount()));
+        total += targets[i];
+    }
+    if (total > getFreeCellCount()) {
+        throw std::runtime_error("Not enough empty cells to populate");
+    }
+
+    for (size_t i = 0; i < populations.size(); ++i) {
+        const Population& population = populations[i];
+        if (population.pattern == Population::Pattern::PoissonDisk) {
+            placed[i] = placePoissonDisk(population.species, targets[i], population.spacing);
+        }
+    }
+    for (size_t i = 0; i < populations.size(); ++i) {
+        const Population& population = populations[i];
+        if (population.pattern == Population::Pattern::Clustered) {
+            placeClustered(population.species, targets[i], population.clusters, population.spread);
+            placed[i] = targets[i];
+        }
+    }
+
+    std::vector<animalconfig::SpeciesId> species;
+    uint32_t uniformCount = 0;
+    for (size_t i = 0; i < populations.size(); ++i) {
+        if (populations[i].pattern == Population::Pattern::Uniform && targets[i] != 0) {
+            species.insert(species.end(), targets[i], populations[i].species);
+            placed[i] = targets[i];
+            ++uniformCount;
+        }
+    }
+    if (species.empty()) {
+        return placed;
+    }
+
+    std::vector<kinematics::Vector2D> cells;
+    if (gridLayout == GridLayout::Flat && species.size() * DENSE_BATCH >= getFreeCellCount()) {
+        cells = pickEmptyCellsDense(species.size());
+    } else {
+        cells = getNewEmptyCells(species.size());
+        std::sort(cells.begin(), cells.end(), rowMajorLess);
+    }
+
+    // Mixed batches: a Fisher-Yates shuffle deals the species to the cells
+    if (uniformCount > 1) {
+        for (size_t i = species.size() - 1; i > 0; --i) {
+            std::swap(species[i], species[drawRandom() % (i + 1)]);
+        }
+    }
+    placeBatch(cells, species);
+    return placed;
+}
+
+// Dart throwing: random empty cells are kept unless the species already has
+// an agent within spacing - 1 cells on both axes
+uint64_t World::placePoissonDisk(const animalconfig::SpeciesId& species, const uint64_t& count, const uint32_t& spacing) {
+    const int range = spacing > 0 ? static_cast<int>(spacing) - 1 : 0;
+    uint64_t placed = 0;
+    for (uint64_t dart = 0; placed < count && dart < count * POISSON_TRIES && !isFull(); ++dart) {
+        kinematics::Vector2D pos = getNewEmptyCell();
+        if (range > 0 && findNearest(pos, range, &species, 1).x != -1)
+            continue;
+        spawnSpecies(species, pos);
+        ++placed;
+    }
+    return placed;
+}
+
+void World::placeClustered(const animalconfig::SpeciesId& species, const uint64_t& count, const uint32_t& clusters, const double& spread) {
+    const uint64_t cellCount = getCellCount();
+    std::vector<kinematics::Vector2D> centres(std::max(1u, clusters));
+    for (kinematics::Vector2D& centre : centres) {
+        uint64_t cellId = drawRandom() % cellCount;
+        centre = kinematics::Vector2D(cellId / size.y, cellId % size.y);
+    }
+
+    for (uint64_t agent = 0; agent < count; ++agent) {
+        kinematics::Vector2D pos(-1, -1);
+        for (uint32_t attempt = 0; attempt < CLUSTER_TRIES; ++attempt) {
+            const kinematics::Vector2D& centre = centres[drawRandom() % centres.size()];
+            // Box-Muller offset; the blob widens on every second miss so full clusters grow outwards
+            double radius = spread * (1u << (attempt / 2)) * std::sqrt(-2.0 * std::log(1.0 - rng::uniform(drawRandom())));
+            double angle = TWO_PI * rng::uniform(drawRandom());
+            kinematics::Vector2D candidate(centre.x + static_cast<int>(std::lround(radius * std::cos(angle))),
+                                           centre.y + static_cast<int>(std::lround(radius * std::sin(angle))));
+            if (isInside(candidate.x, candidate.y) && !isCellOccupied(candidate.x, candidate.y)) {
+                pos = candidate;
+                break;
+            }
+        }
+        if (pos.x == -1) {
+            pos = getNewEmptyCell();
+        }
+        spawnSpecies(species, pos);
+    }
+}
+
+// The `count` free cells with the smallest keys, key = draw(cell), form a
+// uniform sample. The first pass buckets the keys by their top bits, the
+// second sorts out the boundary bucket and the third collects the winners
+// tile by tile, so the cells come back in row-major order.
+std::vector<kinematics::Vector2D> World::pickEmptyCellsDense(const uint64_t& count) {
+    std::vector<kinematics::Vector2D> cells;
+    if (count == 0) {
+        return cells;
+    }
+
+    const uint64_t batchKey = drawRandom();
+    const uint32_t rows = size.x;
+    const uint32_t cols = size.y;
+    const uint32_t tiles = (rows + TILE_ROWS - 1) / TILE_ROWS;
+    const uint32_t wordsPerRow = gridOccupied.getWordsPerRow();
+    const uint64_t lastWordMask = (cols & 63) == 0 ? ~0ULL : (1ULL << (cols & 63)) - 1;
+
+    // visit(row, col, key) for every free cell of a tile
+    auto forFreeCells = [&](const uint32_t& tile, auto visit) {
+        const uint32_t endRow = std::min(rows, (tile + 1) * TILE_ROWS);
+        for (uint32_t row = tile * TILE_ROWS; row < endRow; ++row) {
+            const uint64_t* words = gridOccupied.getRowWords(row);
+            for (uint32_t word = 0; word < wordsPerRow; ++word) {
+                uint64_t free = ~words[word] & (word + 1 == wordsPerRow ? lastWordMask : ~0ULL);
+                while (free != 0) {
+                    const uint32_t col = (word << 6) + BitGrid::lowestBit(free);
+                    visit(row, col, rng::draw(batchKey, static_cast<uint64_t>(row) * cols + col, rng::POPULATE_STREAM, 0));
+                    free &= free - 1;
+                }
+            }
+        }
+    };
+
+    const uint32_t threads = getThreadCount();
+    const uint32_t bucketShift = 64 - KEY_BUCKET_BITS;
+    std::vector<std::vector<uint64_t>> histograms(threads, std::vector<uint64_t>(1u << KEY_BUCKET_BITS, 0));
+    WorkerPool::run(workers.get(), tiles, [&](uint32_t tile, uint32_t worker) {
+        std::vector<uint64_t>& histogram = histograms[worker];
+        forFreeCells(tile, [&](const uint32_t&, const uint32_t&, const uint64_t& key) {
+            ++histogram[key >> bucketShift];
+        });
+    });
+
+    uint64_t below = 0;
+    uint32_t boundary = 0;
+    for (;; ++boundary) {
+        uint64_t inBucket = 0;
+        for (const std::vector<uint64_t>& histogram : histograms) {
+            inBucket += histogram[boundary];
+        }
+        if (below + inBucket >= count)
+            break;
+        below += inBucket;
+    }
+
+    // (key, cell) pairs are unique, so the count-th smallest is an exact cut
+    typedef std::pair<uint64_t, uint64_t> Ranked;
+    std::vector<std::vector<Ranked>> candidates(threads);
+    WorkerPool::run(workers.get(), tiles, [&](uint32_t tile, uint32_t worker) {
+        forFreeCells(tile, [&](const uint32_t& row, const uint32_t& col, const uint64_t& key) {
+            if ((key >> bucketShift) == boundary) {
+                candidates[worker].emplace_back(key, static_cast<uint64_t>(row) * cols + col);
+            }
+        });
+    });
+    std::vector<Ranked> boundaryCells;
+    for (const std::vector<Ranked>& found : candidates) {
+        boundaryCells.insert(boundaryCells.end(), found.begin(), found.end());
+    }
+    std::nth_element(boundaryCells.begin(), boundaryCells.begin() + (count - below - 1), boundaryCells.end());
+    const Ranked cut = boundaryCells[count - below - 1];
+
+    // Expected share of each tile, plus slack, so the lists rarely grow
+    const double share = static_cast<double>(count) / getFreeCellCount();
+    std::vector<std::vector<kinematics::Vector2D>> picked(tiles);
+    WorkerPool::run(workers.get(), tiles, [&](uint32_t tile, uint32_t) {
+        picked[tile].reserve(static_cast<size_t>(share * TILE_ROWS * cols * 1.1) + 64);
+        forFreeCells(tile, [&](const uint32_t& row, const uint32_t& col, const uint64_t& key) {
+            if (key < cut.first || (key == cut.first && static_cast<uint64_t>(row) * cols + col <= cut.second)) {
+                picked[tile].emplace_back(row, col);
+            }
+        });
+    });
+    cells.reserve(count);
+    for (const std::vector<kinematics::Vector2D>& tileCells : picked) {
+        cells.insert(cells.end(), tileCells.begin(), tileCells.end());
+    }
+    return cells;
+}
+
+// Agents are created on this thread in cell order, exactly as one-by-one
+// spawns would create them; only the grid and index writes are spread over
+// row tiles. cells must be in row-major order.
+void World::placeBatch(const std::vector<kinematics::Vector2D>& cells, const std::vector<animalconfig::SpeciesId>& species) {
+    if (!workers || gridLayout == GridLayout::Chunked) {
+        for (size_t i = 0; i < cells.size(); ++i) {
+            spawnSpecies(species[i], cells[i]);
+        }
+        return;
+    }
+
+    const bool dense = storageMode == StorageMode::Dense;
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    std::vector<Entity*> entities;
+    std::vector<uint32_t> slots;
+    if (dense) {
+        denseStore.reserve(static_cast<size_t>(denseStore.getSlotCount()) + cells.size());
+        slots.resize(cells.size());
+        for (size_t i = 0; i < cells.size(); ++i) {
+            slots[i] = denseStore.add(species[i], cells[i].x, cells[i].y, registry.get(species[i]).energy);
+            denseStore.id[slots[i]] = newEntityId();
+            noteArrival(species[i], denseStore.energy[slots[i]]);
+        }
+    } else {
+        entities.resize(cells.size());
+        for (size_t i = 0; i < cells.size(); ++i) {
+            entities[i] = entityPool.acquire(species[i], *this, cells[i]);
+        }
+    }
+    speciesIndex.reserve(*std::max_element(species.begin(), species.end()));
+
+    const uint32_t tiles = (size.x + TILE_ROWS - 1) / TILE_ROWS;
+    std::vector<size_t> tileStart(tiles + 1, cells.size());
+    for (uint32_t tile = 0; tile < tiles; ++tile) {
+        kinematics::Vector2D first(tile * TILE_ROWS, 0);
+        tileStart[tile] = std::lower_bound(cells.begin(), cells.end(), first, rowMajorLess) - cells.begin();
+    }
+
+    gridOccupied.pauseCount();
+    speciesIndex.pauseCount();
+    WorkerPool::run(workers.get(), tiles, [&](uint32_t tile, uint32_t worker) {
+        // Each worker counts its agents into its own stats
+        stripeContext = &stripeContexts[worker];
+        for (size_t i = tileStart[tile]; i < tileStart[tile + 1]; ++i) {
+            if (dense) {
+                placeDense(slots[i], cells[i].x, cells[i].y);
+            } else {
+                addEntity(entities[i]);
+            }
+        }
+        stripeContext = nullptr;
+    });
+    gridOccupied.resumeCount();
+    speciesIndex.resumeCount();
+    retireDeferred();
+}
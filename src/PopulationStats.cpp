@@ -0,0 +1,93 @@
+#include "../include/PopulationStats.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+constexpr char PopulationStats::MAGIC[8];
+
+PopulationStats::Tally PopulationStats::getTotal() const {
+    Tally total;
+    for (const Tally& tally : tallies) {
+        total.count += tally.count;
+        total.energy += tally.energy;
+        total.births += tally.births;
+        total.deaths += tally.deaths;
+    }
+    return total;
+}
+
+void PopulationStats::merge(std::vector<Tally>& deltas) {
+    for (size_t species = 0; species < deltas.size(); ++species) {
+        Tally& delta = deltas[species];
+        tallies[species].count += delta.count;
+        tallies[species].energy += delta.energy;
+        tallies[species].births += delta.births;
+        tallies[species].deaths += delta.deaths;
+        delta = Tally();
+    }
+}
+
+void PopulationStats::clear() {
+    tallies.assign(MAX_SPECIES, Tally());
+}
+
+void PopulationStats::sample(const uint64_t& tick) {
+    const uint32_t speciesCount = animalconfig::SpeciesRegistry::getInstance().getCount();
+    for (uint32_t species = 1; species <= speciesCount; ++species) {
+        const Tally& tally = tallies[species];
+        samples.push_back(Sample{tick, tally.count, tally.energy, tally.births, tally.deaths, species, 0});
+    }
+}
+
+void PopulationStats::flushCsv(const std::string& path) {
+    std::ofstream file(path, std::ios::app);
+    if (!file)
+        throw std::runtime_error("Could not open statistics file " + path);
+    file.seekp(0, std::ios::end);
+    if (file.tellp() == 0)
+        file << "tick,species,name,count,energy,births,deaths\n";
+
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    for (const Sample& sample : samples) {
+        const std::string name = sample.species <= registry.getCount() ? registry.getName(sample.species) : std::string();
+        file << sample.tick << ',' << sample.species << ',' << name << ',' << sample.count << ','
+             << sample.energy << ',' << sample.births << ',' << sample.deaths << '\n';
+    }
+    if (!file.flush())
+        throw std::runtime_error("Could not write statistics file " + path);
+    samples.clear();
+}
+
+void PopulationStats::flushBinary(const std::string& path) {
+    std::ofstream file(path, std::ios::app | std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Could not open statistics file " + path);
+    file.seekp(0, std::ios::end);
+    if (file.tellp() == 0) {
+        FileHeader header;
+        std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.sampleBytes = sizeof(Sample);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    file.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(Sample));
+    if (!file.flush())
+        throw std::runtime_error("Could not write statistics file " + path);
+    samples.clear();
+}
+
+std::vector<PopulationStats::Sample> PopulationStats::readBinary(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    FileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0)
+        throw std::runtime_error("Not a statistics file: " + path);
+    if (header.version != VERSION || header.sampleBytes != sizeof(Sample))
+        throw std::runtime_error("Unsupported statistics file version " + std::to_string(header.version) + " in " + path);
+
+    std::vector<Sample> result;
+    Sample sample;
+    while (file.read(reinterpret_cast<char*>(&sample), sizeof(sample))) {
+        result.push_back(sample);
+    }
+    return result;
+}
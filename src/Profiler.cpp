@@ -0,0 +1,189 @@
+#include "../include/Profiler.h"
+#include "../include/BitGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    const char* PHASE_NAMES[profiler::PHASE_COUNT] = {
+        "Tick", "HerbivorePass", "AgentPass", "Merge",
+        "IntentPlanes", "IntentFields", "IntentPlan", "IntentCommit", "Record",
+        "FindPredator", "FindPrey", "Flee", "Reproduce", "Hunt", "Feed", "Wander"
+    };
+}
+
+std::atomic<bool> profiler::Profiler::enabled{false};
+
+const char* profiler::getPhaseName(const Phase& phase) {
+    return phase < Phase::Count ? PHASE_NAMES[static_cast<size_t>(phase)] : "Unknown";
+}
+
+uint32_t profiler::Histogram::getBucket(const uint64_t& nanoseconds) {
+    if (nanoseconds < 16)
+        return static_cast<uint32_t>(nanoseconds);
+    const uint32_t exponent = BitGrid::highestBit(nanoseconds);
+    const uint32_t sub = (nanoseconds >> (exponent - 3)) & (SUB_BUCKETS - 1);
+    return 16 + (exponent - 4) * SUB_BUCKETS + sub;
+}
+
+uint64_t profiler::Histogram::getBucketMiddle(const uint32_t& bucket) {
+    if (bucket < 16)
+        return bucket;
+    const uint32_t exponent = (bucket - 16) / SUB_BUCKETS + 4;
+    const uint64_t sub = (bucket - 16) % SUB_BUCKETS;
+    const uint64_t width = uint64_t(1) << (exponent - 3);
+    return (SUB_BUCKETS + sub) * width + width / 2;
+}
+
+void profiler::Histogram::add(const uint64_t& nanoseconds) {
+    ++buckets[getBucket(nanoseconds)];
+    ++count;
+    total += nanoseconds;
+    max = std::max(max, nanoseconds);
+}
+
+void profiler::Histogram::merge(const Histogram& other) {
+    for (uint32_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        buckets[bucket] += other.buckets[bucket];
+    }
+    count += other.count;
+    total += other.total;
+    max = std::max(max, other.max);
+}
+
+uint64_t profiler::Histogram::getPercentile(const double& fraction) const {
+    if (count == 0)
+        return 0;
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * count)));
+    if (rank >= count)
+        return max;
+    uint64_t seen = 0;
+    for (uint32_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += buckets[bucket];
+        if (seen >= rank)
+            return std::min(getBucketMiddle(bucket), max);
+    }
+    return max;
+}
+
+profiler::Profiler::ThreadLog& profiler::Profiler::getThreadLog() {
+    thread_local ThreadLog* log = nullptr;
+    if (log == nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        logs.push_back(std::make_unique<ThreadLog>());
+        log = logs.back().get();
+        log->thread = static_cast<uint32_t>(logs.size() - 1);
+    }
+    return *log;
+}
+
+void profiler::Profiler::setEnabled(const bool& enable) {
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+void profiler::Profiler::startTrace(const uint32_t& ticks) {
+    traceOrigin = now();
+    traceTicksLeft.store(ticks, std::memory_order_relaxed);
+    tracing.store(ticks > 0, std::memory_order_release);
+    setEnabled(true);
+}
+
+void profiler::Profiler::record(const Phase& phase, const uint64_t& start, const uint64_t& end) {
+    ThreadLog& log = getThreadLog();
+    log.histograms[static_cast<size_t>(phase)].add(end - start);
+    if (!tracing.load(std::memory_order_acquire))
+        return;
+
+    if (log.trace.size() < MAX_TRACE_EVENTS) {
+        log.trace.push_back(TraceEvent{start > traceOrigin ? start - traceOrigin : 0, end - start, phase});
+    } else {
+        ++log.droppedEvents;
+    }
+    if (phase == Phase::Tick && traceTicksLeft.fetch_sub(1, std::memory_order_relaxed) == 1) {
+        tracing.store(false, std::memory_order_relaxed);
+    }
+}
+
+std::vector<profiler::PhaseSummary> profiler::Profiler::getSummary() const {
+    std::array<Histogram, PHASE_COUNT> merged;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const std::unique_ptr<ThreadLog>& log : logs) {
+            for (size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+                merged[phase].merge(log->histograms[phase]);
+            }
+        }
+    }
+
+    std::vector<PhaseSummary> summary;
+    for (size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+        const Histogram& histogram = merged[phase];
+        if (histogram.getCount() == 0)
+            continue;
+        summary.push_back(PhaseSummary{static_cast<Phase>(phase), histogram.getCount(), histogram.getTotal(),
+                                       histogram.getPercentile(0.5), histogram.getPercentile(0.99), histogram.getMax()});
+    }
+    return summary;
+}
+
+void profiler::Profiler::printSummary(std::ostream& out) const {
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-14s %12s %12s %12s %12s %12s\n", "Phase", "Count", "Total ms", "p50 us", "p99 us", "Max us");
+    out << line;
+    for (const PhaseSummary& phase : getSummary()) {
+        std::snprintf(line, sizeof(line), "%-14s %12llu %12.3f %12.3f %12.3f %12.3f\n", getPhaseName(phase.phase),
+                      static_cast<unsigned long long>(phase.count), phase.totalNanoseconds / 1e6,
+                      phase.p50Nanoseconds / 1e3, phase.p99Nanoseconds / 1e3, phase.maxNanoseconds / 1e3);
+        out << line;
+    }
+}
+
+void profiler::Profiler::writeChromeTrace(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+        throw std::runtime_error("Could not write trace " + path);
+
+    // Complete ("X") events in microseconds, one track per recording thread
+    std::lock_guard<std::mutex> lock(mutex);
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    char event[256];
+    bool first = true;
+    uint64_t dropped = 0;
+    for (const std::unique_ptr<ThreadLog>& log : logs) {
+        dropped += log->droppedEvents;
+        std::snprintf(event, sizeof(event), "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+                      first ? "" : ",", log->thread, log->thread);
+        file << event;
+        first = false;
+        for (const TraceEvent& traced : log->trace) {
+            std::snprintf(event, sizeof(event), ",\n{\"name\":\"%s\",\"cat\":\"ecosim\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                          getPhaseName(traced.phase), traced.start / 1e3, traced.duration / 1e3, log->thread);
+            file << event;
+        }
+    }
+    file << "\n],\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+    if (!file.flush())
+        throw std::runtime_error("Could not write trace " + path);
+}
+
+uint64_t profiler::Profiler::getDroppedTraceEvents() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t dropped = 0;
+    for (const std::unique_ptr<ThreadLog>& log : logs) {
+        dropped += log->droppedEvents;
+    }
+    return dropped;
+}
+
+void profiler::Profiler::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const std::unique_ptr<ThreadLog>& log : logs) {
+        log->histograms = std::array<Histogram, PHASE_COUNT>();
+        log->trace.clear();
+        log->droppedEvents = 0;
+    }
+    tracing.store(false, std::memory_order_relaxed);
+    traceTicksLeft.store(0, std::memory_order_relaxed);
+}
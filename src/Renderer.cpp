@@ -0,0 +1,235 @@
+#include "../include/Renderer.h"
+#include "../include/Snapshot.h"
+#include "../include/Palette.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    // Quads written by place() and not yet given a look
+    const uint32_t UNDRAWN = UINT32_MAX;
+
+    // Everything a cell's quad depends on: the species, and the energy while tinted
+    uint32_t appearance(const animalconfig::SpeciesId& species, const uint32_t& energy) {
+        if (palette::isFading(species, energy)) {
+            return species | (energy + 1) << 8;
+        }
+        return species;
+    }
+
+    // Black through red and yellow to white as `heat` goes from 0 to 1
+    sf::Color getHeatColor(const float& heat) {
+        const float level = std::min(std::max(heat, 0.0f), 1.0f) * 3;
+        auto ramp = [level](const float& start) {
+            return static_cast<sf::Uint8>(std::min(std::max(level - start, 0.0f), 1.0f) * 255);
+        };
+        return sf::Color(ramp(0), ramp(1), ramp(2));
+    }
+}
+
+renderer::TileRenderer::TileRenderer(const std::map<char, sf::Texture>& textures, const uint32_t& tileSize)
+    : tileSize(tileSize), quads(sf::Quads) {
+    if (textures.find(' ') == textures.end()) {
+        throw std::runtime_error("The renderer needs a texture for empty tiles (' ')");
+    }
+
+    // One row of sprites, a pixel apart so smoothing never bleeds between them
+    unsigned int width = 0, height = 0;
+    for (const auto& entry : textures) {
+        width += entry.second.getSize().x + 1;
+        height = std::max(height, entry.second.getSize().y);
+    }
+    if (width > sf::Texture::getMaximumSize() || height > sf::Texture::getMaximumSize()) {
+        throw std::runtime_error("The sprites do not fit in one texture");
+    }
+
+    sf::Image image;
+    image.create(width, height, sf::Color::Transparent);
+    std::map<char, sf::FloatRect> placed;
+    unsigned int left = 0;
+    for (const auto& entry : textures) {
+        sf::Vector2u size = entry.second.getSize();
+        image.copy(entry.second.copyToImage(), left, 0);
+        placed[entry.first] = sf::FloatRect(left, 0, size.x, size.y);
+        left += size.x + 1;
+    }
+    if (!atlas.loadFromImage(image)) {
+        throw std::runtime_error("Could not create the sprite atlas");
+    }
+
+    regions.fill(placed[' ']);
+    for (const auto& entry : placed) {
+        regions[static_cast<unsigned char>(entry.first)] = entry.second;
+    }
+}
+
+void renderer::TileRenderer::paintQuad(sf::Vertex* quad, const uint32_t& look) const {
+    const animalconfig::SpeciesId species = look & 0xFF;
+    const sf::FloatRect& region = regions[static_cast<unsigned char>(animalconfig::SpeciesRegistry::getInstance().get(species).symbol)];
+    sf::Color color = sf::Color::White;
+    if (look >> 8 != 0) {
+        const uint32_t energy = (look >> 8) - 1;
+        color = sf::Color(palette::FADE_TINT[0], palette::FADE_TINT[1], palette::FADE_TINT[2], palette::getFadeAlpha(energy));
+    }
+
+    quad[0].texCoords = sf::Vector2f(region.left, region.top);
+    quad[1].texCoords = sf::Vector2f(region.left + region.width, region.top);
+    quad[2].texCoords = sf::Vector2f(region.left + region.width, region.top + region.height);
+    quad[3].texCoords = sf::Vector2f(region.left, region.top + region.height);
+    for (int corner = 0; corner < 4; ++corner) {
+        quad[corner].color = color;
+    }
+}
+
+void renderer::TileRenderer::render(const WorldSnapshot& snapshot, sf::RenderTarget& target) {
+    if (getCellPixels(target) >= DETAIL_PIXELS) {
+        drawTiles(snapshot, target);
+    } else {
+        drawDensity(snapshot, target);
+    }
+}
+
+float renderer::TileRenderer::getCellPixels(const sf::RenderTarget& target) const {
+    const sf::View& view = target.getView();
+    return tileSize * target.getSize().x * view.getViewport().width / view.getSize().x;
+}
+
+renderer::TileRenderer::Visible renderer::TileRenderer::getVisible(const sf::RenderTarget& target, const float& side, const int& rows, const int& columns) const {
+    const sf::View& view = target.getView();
+    const float left = view.getCenter().x - view.getSize().x / 2;
+    const float top = view.getCenter().y - view.getSize().y / 2;
+    Visible visible;
+    visible.firstRow = std::max(0, static_cast<int>(std::floor(top / side)));
+    visible.endRow = std::min(rows, static_cast<int>(std::ceil((top + view.getSize().y) / side)));
+    visible.firstColumn = std::max(0, static_cast<int>(std::floor(left / side)));
+    visible.endColumn = std::min(columns, static_cast<int>(std::ceil((left + view.getSize().x) / side)));
+    return visible;
+}
+
+void renderer::TileRenderer::place(const Visible& visible, const int& newRows, const int& newColumns) {
+    rows = newRows;
+    columns = newColumns;
+    placed = visible;
+    const size_t width = visible.endColumn - visible.firstColumn;
+    const size_t count = static_cast<size_t>(visible.endRow - visible.firstRow) * width;
+    quads.resize(count * 4);
+    drawn.assign(count, UNDRAWN);
+
+    const float tile = static_cast<float>(tileSize);
+    for (int x = visible.firstRow; x < visible.endRow; ++x) {
+        for (int y = visible.firstColumn; y < visible.endColumn; ++y) {
+            sf::Vertex* quad = &quads[((x - visible.firstRow) * width + (y - visible.firstColumn)) * 4];
+            quad[0].position = sf::Vector2f(y * tile, x * tile);
+            quad[1].position = sf::Vector2f((y + 1) * tile, x * tile);
+            quad[2].position = sf::Vector2f((y + 1) * tile, (x + 1) * tile);
+            quad[3].position = sf::Vector2f(y * tile, (x + 1) * tile);
+        }
+    }
+}
+
+void renderer::TileRenderer::drawTiles(const WorldSnapshot& snapshot, sf::RenderTarget& target) {
+    const Visible visible = getVisible(target, static_cast<float>(tileSize), snapshot.rows, snapshot.columns);
+    if (visible.firstRow >= visible.endRow || visible.firstColumn >= visible.endColumn) {
+        return;
+    }
+    if (rows != snapshot.rows || columns != snapshot.columns || visible.firstRow != placed.firstRow || visible.endRow != placed.endRow
+        || visible.firstColumn != placed.firstColumn || visible.endColumn != placed.endColumn) {
+        place(visible, snapshot.rows, snapshot.columns);
+    }
+
+    // The reader may skip snapshots, so their changes cannot be replayed;
+    // comparing each visible cell's look with the quad's finds them instead
+    const size_t width = visible.endColumn - visible.firstColumn;
+    for (int x = visible.firstRow; x < visible.endRow; ++x) {
+        for (int y = visible.firstColumn; y < visible.endColumn; ++y) {
+            const size_t index = (x - visible.firstRow) * width + (y - visible.firstColumn);
+            const uint32_t cellId = snapshot.getCellId(x, y);
+            const uint32_t look = appearance(snapshot.species[cellId], snapshot.energy[cellId]);
+            if (drawn[index] != look) {
+                drawn[index] = look;
+                paintQuad(&quads[index * 4], look);
+            }
+        }
+    }
+    target.draw(quads, sf::RenderStates(&atlas));
+}
+
+void renderer::TileRenderer::drawDensity(const WorldSnapshot& snapshot, sf::RenderTarget& target) {
+    const DensityPyramid& density = snapshot.density;
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+
+    // The finest level whose blocks are at least BLOCK_PIXELS wide; level 0 is the cells
+    uint32_t level = 0;
+    float pixels = getCellPixels(target);
+    while (pixels < BLOCK_PIXELS && level < density.getLevelCount()) {
+        ++level;
+        pixels *= 2;
+    }
+    const int levelRows = level == 0 ? snapshot.rows : density.getRows(level);
+    const int levelColumns = level == 0 ? snapshot.columns : density.getColumns(level);
+    const float side = static_cast<float>(tileSize) * (1u << level);
+    const Visible visible = getVisible(target, side, levelRows, levelColumns);
+    if (visible.firstRow >= visible.endRow || visible.firstColumn >= visible.endColumn) {
+        return;
+    }
+
+    // Colours of the ground and of every species at full energy
+    std::vector<sf::Color> colors(registry.getCount() + 1);
+    uint32_t maxEnergy = 1;
+    for (uint32_t species = 0; species < colors.size(); ++species) {
+        uint8_t rgb[3];
+        palette::getCellColor(species, UINT32_MAX, rgb);
+        colors[species] = sf::Color(rgb[0], rgb[1], rgb[2]);
+        if (species != animalconfig::NO_SPECIES)
+            maxEnergy = std::max(maxEnergy, registry.get(species).maxEnergy);
+    }
+
+    const unsigned int width = visible.endColumn - visible.firstColumn;
+    const unsigned int height = visible.endRow - visible.firstRow;
+    blockPixels.resize(static_cast<size_t>(width) * height * 4);
+    DensityPyramid::Block block;
+    for (int x = visible.firstRow; x < visible.endRow; ++x) {
+        for (int y = visible.firstColumn; y < visible.endColumn; ++y) {
+            sf::Color color;
+            if (level == 0) {
+                const uint32_t cellId = snapshot.getCellId(x, y);
+                color = overlay == Overlay::Energy ? getHeatColor(static_cast<float>(snapshot.energy[cellId]) / maxEnergy) : colors[snapshot.species[cellId]];
+            } else if (overlay == Overlay::Energy) {
+                density.getBlock(level, x, y, snapshot.species, snapshot.energy, block);
+                color = getHeatColor(static_cast<float>(block.energy) / density.getArea(level, x, y) / maxEnergy);
+            } else {
+                // Each species' colour weighted by its share of the block's cells, the ground for the rest
+                density.getBlock(level, x, y, snapshot.species, snapshot.energy, block);
+                const uint32_t area = density.getArea(level, x, y);
+                uint32_t mix[3] = {0, 0, 0};
+                uint32_t filled = 0;
+                for (uint32_t species = 1; species < colors.size(); ++species) {
+                    const uint32_t count = block.counts[species];
+                    mix[0] += colors[species].r * count;
+                    mix[1] += colors[species].g * count;
+                    mix[2] += colors[species].b * count;
+                    filled += count;
+                }
+                const uint32_t empty = area - std::min(area, filled);
+                color = sf::Color((mix[0] + colors[0].r * empty) / area, (mix[1] + colors[0].g * empty) / area, (mix[2] + colors[0].b * empty) / area);
+            }
+            sf::Uint8* pixel = &blockPixels[((x - visible.firstRow) * static_cast<size_t>(width) + (y - visible.firstColumn)) * 4];
+            pixel[0] = color.r;
+            pixel[1] = color.g;
+            pixel[2] = color.b;
+            pixel[3] = 255;
+        }
+    }
+
+    // One pixel a block, stretched over the blocks' area of the view
+    if (blocks.getSize().x < width || blocks.getSize().y < height) {
+        if (!blocks.create(std::max(width, blocks.getSize().x), std::max(height, blocks.getSize().y))) {
+            throw std::runtime_error("Could not create the density texture");
+        }
+    }
+    blocks.update(blockPixels.data(), width, height, 0, 0);
+    sf::Sprite sprite(blocks, sf::IntRect(0, 0, width, height));
+    sprite.setPosition(visible.firstColumn * side, visible.firstRow * side);
+    sprite.setScale(side, side);
+    target.draw(sprite);
+}
@@ -0,0 +1,150 @@
+#include "../include/SimulationThread.h"
+#include "../include/World.h"
+
+namespace {
+    // A simulation this far behind its rate catches up no further
+    const std::chrono::milliseconds MAX_LAG(250);
+}
+
+SimulationThread::SimulationThread(World& world, const TickHook& beforeTick, const bool& paused)
+    : world(world), beforeTick(beforeTick) {
+    this->paused.store(paused, std::memory_order_relaxed);
+    world.setChangeTracking(true);
+    thread = std::thread(&SimulationThread::loop, this);
+}
+
+SimulationThread::~SimulationThread() {
+    try {
+        stop();
+    } catch (...) {
+    }
+}
+
+void SimulationThread::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    control.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    running.store(false, std::memory_order_relaxed);
+    if (error) {
+        std::exception_ptr thrown = error;
+        error = nullptr;
+        std::rethrow_exception(thrown);
+    }
+}
+
+// Stored under the mutex, so the loop cannot miss the change between
+// checking its predicate and going to sleep
+void SimulationThread::setTickRate(const double& ticksPerSecond) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tickRate.store(ticksPerSecond > 0.0 ? ticksPerSecond : 0.0, std::memory_order_relaxed);
+    }
+    control.notify_all();
+}
+
+void SimulationThread::setSpeed(const double& multiplier) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        speed.store(multiplier > 0.0 ? multiplier : 1.0, std::memory_order_relaxed);
+    }
+    control.notify_all();
+}
+
+void SimulationThread::setPaused(const bool& pause) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        paused.store(pause, std::memory_order_relaxed);
+        steps = 0;
+    }
+    control.notify_all();
+}
+
+void SimulationThread::step(const uint32_t& ticks) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        steps += ticks;
+    }
+    control.notify_all();
+}
+
+std::chrono::duration<double> SimulationThread::getTickPeriod() const {
+    const double rate = tickRate.load(std::memory_order_relaxed) * speed.load(std::memory_order_relaxed);
+    return std::chrono::duration<double>(rate > 0.0 ? 1.0 / rate : 0.0);
+}
+
+void SimulationThread::publish() {
+    const bool tracked = world.takeChangedCells(changed);
+    for (size_t copy = 0; copy < 3; ++copy) {
+        if (stale[copy]) {
+            continue;
+        }
+        if (!tracked || pending[copy].size() + changed.size() > world.getCellCount()) {
+            stale[copy] = true;
+            pending[copy].clear();
+        } else {
+            pending[copy].insert(pending[copy].end(), changed.begin(), changed.end());
+        }
+    }
+
+    const size_t back = snapshots.getBackIndex();
+    world.updateSnapshot(snapshots.getBack(), stale[back] ? nullptr : &pending[back]);
+    pending[back].clear();
+    stale[back] = false;
+    snapshots.publish();
+}
+
+void SimulationThread::loop() {
+    try {
+        publish();
+        std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            // Paused: sleep until resumed, stepped or stopped
+            control.wait(lock, [this] { return stopping || !paused.load(std::memory_order_relaxed) || steps > 0; });
+            if (stopping) {
+                break;
+            }
+            const bool stepping = paused.load(std::memory_order_relaxed);
+            if (stepping) {
+                --steps;
+            }
+            lock.unlock();
+
+            if (beforeTick) {
+                beforeTick(world);
+            }
+            world.run();
+            ticksRun.fetch_add(1, std::memory_order_relaxed);
+            publish();
+
+            lock.lock();
+            const std::chrono::duration<double> period = getTickPeriod();
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (stepping || period.count() <= 0.0) {
+                next = now;
+                continue;
+            }
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+            if (next < now - MAX_LAG) {
+                next = now;
+            }
+            // Rate, speed or pause changes wake the wait and take effect at once
+            const double rate = getTickRate() * getSpeed();
+            const bool wasPaused = paused.load(std::memory_order_relaxed);
+            control.wait_until(lock, next, [&] {
+                return stopping || paused.load(std::memory_order_relaxed) != wasPaused || getTickRate() * getSpeed() != rate;
+            });
+            if (getTickRate() * getSpeed() != rate) {
+                next = std::chrono::steady_clock::now();
+            }
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    running.store(false, std::memory_order_relaxed);
+}
@@ -0,0 +1,51 @@
+#include "../include/World.h"
+#include "../include/Snapshot.h"
+#include <algorithm>
+
+void World::updateSnapshot(WorldSnapshot& snapshot, const std::vector<uint32_t>* cells) const {
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    snapshot.tick = tick;
+    snapshot.occupied = getOccupiedCellsCount();
+    snapshot.counts.resize(registry.getCount() + 1);
+    for (uint32_t species = 0; species < snapshot.counts.size(); ++species) {
+        snapshot.counts[species] = stats.get(species).count;
+    }
+
+    auto copyCell = [&](const int& x, const int& y) {
+        const uint32_t cellId = getCellId(x, y);
+        snapshot.species[cellId] = getCellSpecies(x, y);
+        snapshot.energy[cellId] = getCellEnergy(x, y);
+    };
+
+    const bool sameShape = snapshot.rows == size.x && snapshot.columns == size.y && snapshot.density.getSpeciesCount() == registry.getCount();
+    if (cells != nullptr && sameShape) {
+        // Take each cell's old agent out of the pyramid and put the new one in
+        for (const uint32_t& cellId : *cells) {
+            const int x = cellId / size.y, y = cellId % size.y;
+            snapshot.density.apply(x, y, snapshot.species[cellId], snapshot.energy[cellId], -1);
+            copyCell(x, y);
+            snapshot.density.apply(x, y, snapshot.species[cellId], snapshot.energy[cellId], 1);
+        }
+        return;
+    }
+
+    snapshot.rows = size.x;
+    snapshot.columns = size.y;
+    snapshot.species.assign(getCellCount(), animalconfig::NO_SPECIES);
+    snapshot.energy.assign(getCellCount(), 0);
+    if (storageMode == StorageMode::Dense) {
+        std::copy(denseCellSpecies.begin(), denseCellSpecies.begin() + getCellCount(), snapshot.species.begin());
+        for (uint32_t cellId = 0; cellId < getCellCount(); ++cellId) {
+            if (denseGrid[cellId] != EntityStore::INVALID) {
+                snapshot.energy[cellId] = denseStore.energy[denseGrid[cellId]];
+            }
+        }
+    } else if (gridLayout == GridLayout::Chunked) {
+        chunkedGrid.forEachSet(animalconfig::NO_SPECIES, copyCell);
+    } else {
+        gridOccupied.forEachSet(0, size.x, [&](uint32_t x, uint32_t y) { copyCell(x, y); });
+    }
+    if (!sameShape)
+        snapshot.density.reset(size.x, size.y, registry.getCount());
+    snapshot.density.build(snapshot.species, snapshot.energy);
+}
@@ -0,0 +1,88 @@
+#include "../include/SpatialIndex.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    // One plane per possible species id, so a query never leaves a species out
+    const uint32_t MAX_QUERY_PLANES = 1u << (8 * sizeof(animalconfig::SpeciesId));
+
+    // Selected planes' words for one row, OR-ed on the fly
+    struct RowWords {
+        const uint64_t* const* rows;
+        uint32_t count;
+
+        inline uint64_t operator[](const int& word) const {
+            uint64_t bits = 0;
+            for (uint32_t i = 0; i < count; ++i) {
+                bits |= rows[i][word];
+            }
+            return bits;
+        }
+    };
+}
+
+void SpatialIndex::resize(const uint32_t& rows, const uint32_t& cols) {
+    numRows = rows;
+    numCols = cols;
+    for (BitGrid& plane : planes) {
+        plane.resize(rows, cols);
+    }
+}
+
+void SpatialIndex::clear() {
+    for (BitGrid& plane : planes) {
+        plane.clear();
+    }
+}
+
+void SpatialIndex::addPlanes(const animalconfig::SpeciesId& species) {
+    size_t first = planes.size();
+    planes.resize(species + 1);
+    for (size_t id = first; id < planes.size(); ++id) {
+        planes[id].resize(numRows, numCols);
+        if (!counting) {
+            planes[id].pauseCount();
+        }
+    }
+}
+
+void SpatialIndex::pauseCount() {
+    counting = false;
+    for (BitGrid& plane : planes) {
+        plane.pauseCount();
+    }
+}
+
+void SpatialIndex::resumeCount() {
+    counting = true;
+    for (BitGrid& plane : planes) {
+        plane.resumeCount();
+    }
+}
+
+kinematics::Vector2D SpatialIndex::findNearest(const kinematics::Vector2D& pos, const int& range,
+                                               const animalconfig::SpeciesId* species, const size_t& count) const {
+    if (numRows == 0 || numCols == 0)
+        return kinematics::Vector2D(-1, -1);
+
+    // Skip empty planes; while counts are paused they may be stale, so keep them all
+    uint32_t selected[MAX_QUERY_PLANES];
+    uint32_t selectedCount = 0;
+    for (size_t i = 0; i < count && selectedCount < MAX_QUERY_PLANES; ++i) {
+        if (species[i] < planes.size() && (!counting || planes[species[i]].getCount() != 0)) {
+            selected[selectedCount++] = species[i];
+        }
+    }
+    if (selectedCount == 0)
+        return kinematics::Vector2D(-1, -1);
+
+    // findNearestBit reads one row at a time, so every row reuses the same pointers
+    const uint64_t* rows[MAX_QUERY_PLANES];
+    const kinematics::Vector2D size(numRows, numCols);
+    return findNearestBit(size, pos, range, [&](const int& x) {
+        for (uint32_t i = 0; i < selectedCount; ++i) {
+            rows[i] = planes[selected[i]].getRowWords(x);
+        }
+        return RowWords{rows, selectedCount};
+    });
+}
@@ -0,0 +1,230 @@
+#include "../include/VisionKernel.h"
+#include "../include/BitGrid.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <climits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define ECOSIM_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define ECOSIM_TARGET(isa)
+        #define ECOSIM_FLATTEN
+    #else
+        #define ECOSIM_TARGET(isa) __attribute__((target(isa)))
+        // Inline the search and its block compare into the kernel's own copy
+        #define ECOSIM_FLATTEN __attribute__((flatten))
+    #endif
+#endif
+
+namespace {
+    // Bits at and above `count` may be garbage; SIMD kernels always do 64 cells
+    typedef uint64_t (*MatchFunction)(const uint8_t*, const uint32_t&, const vision::Match&);
+
+    uint64_t matchScalar(const uint8_t* cells, const uint32_t& count, const vision::Match& match) {
+        // value - lo wraps below lo, so one unsigned compare checks both ends
+        const uint8_t span = match.hi - match.lo;
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            bits |= static_cast<uint64_t>(static_cast<uint8_t>(cells[i] - match.lo) <= span) << i;
+        }
+        return bits;
+    }
+
+#if defined(ECOSIM_X86)
+    ECOSIM_TARGET("sse4.1")
+    uint64_t matchSSE41(const uint8_t* cells, const uint32_t&, const vision::Match& match) {
+        const __m128i lo = _mm_set1_epi8(static_cast<char>(match.lo));
+        const __m128i span = _mm_set1_epi8(static_cast<char>(match.hi - match.lo));
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < 64; i += 16) {
+            __m128i shifted = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + i)), lo);
+            __m128i inside = _mm_cmpeq_epi8(_mm_min_epu8(shifted, span), shifted);
+            bits |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(inside))) << i;
+        }
+        return bits;
+    }
+
+    ECOSIM_TARGET("avx2")
+    uint64_t matchAVX2(const uint8_t* cells, const uint32_t&, const vision::Match& match) {
+        const __m256i lo = _mm256_set1_epi8(static_cast<char>(match.lo));
+        const __m256i span = _mm256_set1_epi8(static_cast<char>(match.hi - match.lo));
+        __m256i low = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells)), lo);
+        __m256i high = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + 32)), lo);
+        uint32_t lowBits = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(low, span), low));
+        uint32_t highBits = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(high, span), high));
+        return static_cast<uint64_t>(lowBits) | (static_cast<uint64_t>(highBits) << 32);
+    }
+
+    bool cpuHas(const vision::Kernel& kernel) {
+    #if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        const bool sse41 = (info[2] & (1 << 19)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+        return kernel == vision::Kernel::AVX2 ? avx2 : sse41;
+    #else
+        __builtin_cpu_init();
+        return kernel == vision::Kernel::AVX2 ? __builtin_cpu_supports("avx2") : __builtin_cpu_supports("sse4.1");
+    #endif
+    }
+#endif
+
+    MatchFunction functionFor(const vision::Kernel& kernel) {
+        switch (kernel) {
+#if defined(ECOSIM_X86)
+            case vision::Kernel::AVX2: return matchAVX2;
+            case vision::Kernel::SSE41: return matchSSE41;
+#endif
+            default: return matchScalar;
+        }
+    }
+
+    // Rows outwards from pos, nearest match on each side of pos.y, and stop
+    // once the row distance alone loses to the best hit; as in SpatialIndex.
+    // Block is inlined into each kernel's copy of the search.
+    template <MatchFunction Block>
+    inline kinematics::Vector2D search(const uint8_t* plane, const kinematics::Vector2D& size,
+                                       const kinematics::Vector2D& pos, const int& range, const vision::Match& match) {
+        kinematics::Vector2D nearest(-1, -1);
+        const int minRow = std::max(0, pos.x - range);
+        const int maxRow = std::min(size.x - 1, pos.x + range);
+        const int minCol = std::max(0, pos.y - range);
+        const int maxCol = std::min(size.y - 1, pos.y + range);
+
+        int best = INT_MAX;
+        for (int dx = 0; dx <= range && dx <= best; ++dx) {
+            for (int side = 0; side < 2; ++side) {
+                if (dx == 0 && side == 1)
+                    break;
+                int x = side == 0 ? pos.x - dx : pos.x + dx;
+                if (x < minRow || x > maxRow)
+                    continue;
+
+                const uint8_t* row = plane + static_cast<size_t>(x) * size.y;
+                int reach = best == INT_MAX ? range : best - dx;
+                int lo = std::max(minCol, pos.y - reach);
+                int hi = std::min(maxCol, pos.y + reach);
+                int center = dx == 0 ? 1 : 0;   // pos itself is not a candidate
+
+                // Last match in [lo, pos.y - center] and first in [pos.y + center, hi]
+                int left = -1, right = -1;
+                for (int blockEnd = pos.y - center; blockEnd >= lo && left == -1; blockEnd -= 64) {
+                    int blockStart = std::max(lo, blockEnd - 63);
+                    uint64_t bits = Block(row + blockStart, blockEnd - blockStart + 1, match) & (~0ULL >> (63 - (blockEnd - blockStart)));
+                    if (bits != 0)
+                        left = blockStart + BitGrid::highestBit(bits);
+                }
+                for (int blockStart = pos.y + center; blockStart <= hi && right == -1; blockStart += 64) {
+                    int blockEnd = std::min(hi, blockStart + 63);
+                    uint64_t bits = Block(row + blockStart, blockEnd - blockStart + 1, match) & (~0ULL >> (63 - (blockEnd - blockStart)));
+                    if (bits != 0)
+                        right = blockStart + BitGrid::lowestBit(bits);
+                }
+                int col = (left != -1 && (right == -1 || pos.y - left <= right - pos.y)) ? left : right;
+                if (col == -1)
+                    continue;
+
+                int dist = dx + abs(col - pos.y);
+                if (dist < best || (dist == best && (x < nearest.x || (x == nearest.x && col < nearest.y)))) {
+                    best = dist;
+                    nearest = kinematics::Vector2D(x, col);
+                }
+            }
+        }
+        return nearest;
+    }
+
+    typedef kinematics::Vector2D (*SearchFunction)(const uint8_t*, const kinematics::Vector2D&, const kinematics::Vector2D&,
+                                                   const int&, const vision::Match&);
+
+    kinematics::Vector2D searchScalar(const uint8_t* plane, const kinematics::Vector2D& size,
+                                      const kinematics::Vector2D& pos, const int& range, const vision::Match& match) {
+        return search<matchScalar>(plane, size, pos, range, match);
+    }
+
+#if defined(ECOSIM_X86)
+    ECOSIM_TARGET("sse4.1") ECOSIM_FLATTEN
+    kinematics::Vector2D searchSSE41(const uint8_t* plane, const kinematics::Vector2D& size,
+                                     const kinematics::Vector2D& pos, const int& range, const vision::Match& match) {
+        return search<matchSSE41>(plane, size, pos, range, match);
+    }
+
+    ECOSIM_TARGET("avx2") ECOSIM_FLATTEN
+    kinematics::Vector2D searchAVX2(const uint8_t* plane, const kinematics::Vector2D& size,
+                                    const kinematics::Vector2D& pos, const int& range, const vision::Match& match) {
+        return search<matchAVX2>(plane, size, pos, range, match);
+    }
+#endif
+
+    SearchFunction searchFor(const vision::Kernel& kernel) {
+        switch (kernel) {
+#if defined(ECOSIM_X86)
+            case vision::Kernel::AVX2: return searchAVX2;
+            case vision::Kernel::SSE41: return searchSSE41;
+#endif
+            default: return searchScalar;
+        }
+    }
+
+    std::atomic<vision::Kernel> activeKernel{vision::getBestKernel()};
+    std::atomic<MatchFunction> activeMatch{functionFor(activeKernel.load())};
+    std::atomic<SearchFunction> activeSearch{searchFor(activeKernel.load())};
+}
+
+namespace vision {
+
+Kernel getBestKernel() {
+#if defined(ECOSIM_X86)
+    if (cpuHas(Kernel::AVX2))
+        return Kernel::AVX2;
+    if (cpuHas(Kernel::SSE41))
+        return Kernel::SSE41;
+#endif
+    return Kernel::Scalar;
+}
+
+Kernel getKernel() {
+    return activeKernel.load();
+}
+
+void setKernel(Kernel kernel) {
+#if defined(ECOSIM_X86)
+    if (kernel != Kernel::Scalar && !cpuHas(kernel)) {
+        kernel = getBestKernel();
+    }
+#else
+    kernel = Kernel::Scalar;
+#endif
+    activeKernel.store(kernel);
+    activeMatch.store(functionFor(kernel));
+    activeSearch.store(searchFor(kernel));
+}
+
+const char* getKernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::AVX2: return "avx2";
+        case Kernel::SSE41: return "sse4.1";
+        default: return "scalar";
+    }
+}
+
+uint64_t matchBlock(const uint8_t* cells, const Match& match) {
+    return activeMatch.load(std::memory_order_relaxed)(cells, 64, match);
+}
+
+kinematics::Vector2D findNearest(const uint8_t* plane, const kinematics::Vector2D& size,
+                                 const kinematics::Vector2D& pos, const int& range, const Match& match) {
+    return activeSearch.load(std::memory_order_relaxed)(plane, size, pos, range, match);
+}
+
+}
@@ -0,0 +1,83 @@
+#include "../include/WorkerPool.h"
+
+WorkerPool::WorkerPool(uint32_t threadCount) {
+    for (uint32_t worker = 1; worker < threadCount; ++worker) {
+        threads.emplace_back(&WorkerPool::workerLoop, this, worker);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(WorkerPool* pool, const uint32_t& count, const Task& task) {
+    if (pool) {
+        pool->run(count, task);
+    } else {
+        for (uint32_t index = 0; index < count; ++index) {
+            task(index, 0);
+        }
+    }
+}
+
+void WorkerPool::run(const uint32_t& count, const Task& job) {
+    if (count == 0)
+        return;
+
+    if (threads.empty()) {
+        for (uint32_t index = 0; index < count; ++index) {
+            job(index, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &job;
+        taskCount = count;
+        nextIndex.store(0, std::memory_order_relaxed);
+        running = threads.size();
+        ++generation;
+    }
+    wake.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return running == 0; });
+    task = nullptr;
+}
+
+void WorkerPool::drain(uint32_t worker) {
+    uint32_t index;
+    while ((index = nextIndex.fetch_add(1, std::memory_order_relaxed)) < taskCount) {
+        (*task)(index, worker);
+    }
+}
+
+void WorkerPool::workerLoop(uint32_t worker) {
+    uint32_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping)
+                return;
+            seenGeneration = generation;
+        }
+
+        drain(worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--running == 0) {
+            finished.notify_one();
+        }
+    }
+}
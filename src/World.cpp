@@ -1,10 +1,18 @@
 #include "../include/World.h"
 #include "../include/Entity.h"
+#include "../include/Profiler.h"
 #include <climits>
-#include <SFML/Graphics.hpp>
+#include <stdexcept>
+#include <unordered_set>
 
-// Initialize static member
+namespace {
+    // Plain random draws tried before falling back to the free-cell index
+    const uint32_t REJECTION_TRIES = 16;
+}
+
+// Initialize static members
 World* World::instancePtr = nullptr;
+thread_local World::StripeContext* World::stripeContext = nullptr;
 
 // Default constructor
 World::World() : size(0, 0) {}
@@ -16,6 +24,12 @@ World::World(int width, int height) : size(width, height) {
     }
 }
 
+World::~World() {
+    if (checkpointThread.joinable()) {
+        checkpointThread.join();
+    }
+}
+
 // Get singleton instance
 World& World::getInstance() {
     if (!instancePtr) {
@@ -35,157 +49,289 @@ void World::resetInstance() {
     instancePtr = nullptr;
 }
 void World::run(){
-    for(int x = 0; x < size.x; ++x){
-        for(int y = 0; y < size.y; ++y){
-            Entity* entity = grid[x][y];
-            if (entity != nullptr) {
-                entity->isUpdated = false;
-            }
-        }
+    ECOSIM_PROFILE_SCOPE(profiler::Phase::Tick);
+    if (gridLayout == GridLayout::Chunked) {
+        runChunked();
+    } else if (tickEngine == TickEngine::Intent) {
+        runIntent();
+    } else {
+        runStriped();
     }
-    
-    for(int x = 0; x < size.x; ++x){
-        for(int y = 0; y < size.y; ++y){
-            Entity* entity = grid[x][y];
-            if (entity == nullptr || entity->isUpdated) 
-                continue;
-            if(entity->entityConfig.symbol != animalconfig::HERBIVORE_CONFIG.symbol)
-                continue;
-            
-            if(entity->entityConfig.energy <= 0) {
-                killEntity(entity);
-                grid[x][y] = nullptr; 
-            } else {
-                entity->update();
-            }
-
-            if(entity != nullptr) {
-                entity->isUpdated = true;
-            }
+    {
+        ECOSIM_PROFILE_SCOPE(profiler::Phase::Record);
+        if (eventLog) {
+            flushEvents();
+        }
+        if (stats.isRecording()) {
+            stats.sample(tick);
         }
     }
 
-    for(int x = 0; x < size.x; ++x){
-        for(int y = 0; y < size.y; ++y){
-            Entity* entity = grid[x][y];
-            if (entity == nullptr || entity->isUpdated) 
-                continue;
-            
-            if(entity->entityConfig.energy <= 0) {
+    ++tick;
+    tickKey = rng::tickKey(seed, tick);
+}
+
+// Chunk by chunk, herbivores first; chunks emptied by the tick are freed at the end
+void World::runChunked(){
+    const animalconfig::SpeciesId herbivore = animalconfig::SpeciesRegistry::getInstance().findBySymbol(animalconfig::HERBIVORE_CONFIG.symbol);
+
+    ++generation;
+    for (uint32_t pass = 0; pass < 2; ++pass) {
+        ECOSIM_PROFILE_SCOPE(pass == 0 ? profiler::Phase::HerbivorePass : profiler::Phase::AgentPass);
+        chunkedGrid.forEachSet(pass == 0 ? herbivore : animalconfig::NO_SPECIES, [&](int x, int y) {
+            Entity* entity = chunkedGrid.get(x, y);
+            if (entity->updatedGeneration == generation)
+                return;
+
+            if (entity->energy <= 0) {
+                recordEvent(EventLog::Type::Starve, entity->speciesId, entity->id, 0, kinematics::Vector2D(x, y), kinematics::Vector2D(x, y));
                 killEntity(entity);
-                grid[x][y] = nullptr; 
             } else {
                 entity->update();
             }
 
-            if(entity != nullptr) {
-                entity->isUpdated = true;
+            if (entity != nullptr) {
+                entity->updatedGeneration = generation;
             }
-        }
+        });
     }
+    chunkedGrid.collect();
 }
+
+void World::setGridLayout(GridLayout layout) {
+    if (getOccupiedCellsCount() != 0) {
+        throw std::runtime_error("Grid layout can only change while the world is empty");
+    }
+    if (layout == GridLayout::Chunked && storageMode != StorageMode::Objects) {
+        throw std::runtime_error("The chunked grid layout needs objects storage");
+    }
+    if (layout == GridLayout::Chunked && (tickEngine != TickEngine::Sweep || getThreadCount() > 1)) {
+        throw std::runtime_error("The chunked grid layout runs the sweep engine on a single thread");
+    }
+    gridLayout = layout;
+    entityPool.reset();
+    initialize(size.x, size.y);
+}
+
 char World::getCellSymbol(const int& x, const int& y) const {
-    if (isCellOccupied(x, y)) {
-        return grid[x][y]->getSymbol();
+    return animalconfig::SpeciesRegistry::getInstance().get(getCellSpecies(x, y)).symbol;
+}
+animalconfig::SpeciesId World::getCellSpecies(const int& x, const int& y) const {
+    if (!isCellOccupied(x, y)) {
+        return animalconfig::NO_SPECIES;
+    }
+    if (storageMode == StorageMode::Dense) {
+        return getDenseSpecies(x, y);
+    }
+    return getEntityAt(x, y)->speciesId;
+}
+uint32_t World::getCellEnergy(const int& x, const int& y) const {
+    if (!isCellOccupied(x, y)) {
+        return 0;
     }
-    return '.';
+    if (storageMode == StorageMode::Dense) {
+        return denseStore.energy[denseGrid[getCellId(x, y)]];
+    }
+    return getEntityAt(x, y)->energy;
 }
 Entity* World::getEntityAt(const int& x, const int& y) const {
-    if (isCellOccupied(x, y)) {
-        return grid[x][y];
+    if (storageMode == StorageMode::Objects && isCellOccupied(x, y)) {
+        return gridLayout == GridLayout::Chunked ? chunkedGrid.get(x, y) : grid[getCellId(x, y)];
     }
     return nullptr;
 }
 
 void World::addEntity(Entity* entity){
     kinematics::Vector2D pos = entity->getPosition();
-    uint32_t cellId = getCellId(pos.x, pos.y);
+    Entity* previous = getEntityAt(pos.x, pos.y);
+    if (previous != entity) {
+        if (previous != nullptr) {
+            noteDeath(previous->speciesId, previous->energy);
+        }
+        noteArrival(entity->speciesId, entity->energy);
+    }
+    markChanged(getCellId(pos.x, pos.y));
+    if (gridLayout == GridLayout::Chunked) {
+        chunkedGrid.set(pos.x, pos.y, entity);
+        return;
+    }
 
-    grid[pos.x][pos.y] = entity;
-    gridOccupied.insert(cellId);
+    Entity*& cell = grid[getCellId(pos.x, pos.y)];
+    if (cell != nullptr && cell != entity) {
+        speciesIndex.reset(cell->speciesId, pos.x, pos.y);
+    }
+    cell = entity;
+    gridOccupied.set(pos.x, pos.y);
+    speciesIndex.set(entity->speciesId, pos.x, pos.y);
 }
 
 void World::addEntityType(char symbol){
-    kinematics::Vector2D pos = getNewEmptyCell();
-    Entity* newEntity = new Entity(animalconfig::getConfig(symbol), pos.x, pos.y);
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    animalconfig::SpeciesId species = registry.findBySymbol(animalconfig::getConfig(symbol).symbol);
+
+    spawnSpecies(species, getNewEmptyCell());
+}
+
+void World::spawnSpecies(const animalconfig::SpeciesId& species, const kinematics::Vector2D& pos){
+    if (storageMode == StorageMode::Dense) {
+        spawnDense(species, pos);
+    } else {
+        spawnEntity(species, pos);
+    }
+}
+
+Entity* World::spawnEntity(const animalconfig::config& config, const kinematics::Vector2D& pos){
+    Entity* newEntity;
+    if (stripeContext != nullptr) {
+        std::lock_guard<std::mutex> lock(spawnMutex);
+        newEntity = entityPool.acquire(config, *this, pos);
+    } else {
+        newEntity = entityPool.acquire(config, *this, pos);
+    }
+    addEntity(newEntity);
+    return newEntity;
+}
+
+Entity* World::spawnEntity(const animalconfig::SpeciesId& species, const kinematics::Vector2D& pos){
+    return spawnEntity(species, pos, newEntityId());
+}
+
+Entity* World::spawnEntity(const animalconfig::SpeciesId& species, const kinematics::Vector2D& pos, const uint64_t& id){
+    Entity* newEntity;
+    if (stripeContext != nullptr) {
+        std::lock_guard<std::mutex> lock(spawnMutex);
+        newEntity = entityPool.acquire(species, *this, pos, id);
+    } else {
+        newEntity = entityPool.acquire(species, *this, pos, id);
+    }
     addEntity(newEntity);
+    return newEntity;
 }
 
+// While at least half the world is free a few plain draws almost surely hit an
+// empty cell, which keeps seeded runs as they were. Fuller worlds, or a run of
+// misses, draw a rank among the free cells instead, so a pick never costs more
+// than O(log n) however full the world is.
 kinematics::Vector2D World::getNewEmptyCell(){
-    uint32_t cellId;
-    if (gridOccupied.size() == size.x * size.y) {
+    const uint64_t cellCount = getCellCount();
+    const uint64_t freeCount = getFreeCellCount();
+    if (freeCount == 0) {
         throw std::runtime_error("World is full");
     }
-    do{
-        cellId = rand() % (size.x * size.y);
-    } while (gridOccupied.find(cellId) != gridOccupied.end());
 
+    if (freeCount * 2 >= cellCount) {
+        for (uint32_t attempt = 0; attempt < REJECTION_TRIES; ++attempt) {
+            uint64_t cellId = drawRandom() % cellCount;
+            kinematics::Vector2D pos(cellId / size.y, cellId % size.y);
+            if (!isCellOccupied(pos.x, pos.y))
+                return pos;
+        }
+    }
+    uint64_t cellId = findFreeCell(drawRandom() % freeCount);
     return kinematics::Vector2D(cellId / size.y, cellId % size.y);
 }
 
+std::vector<kinematics::Vector2D> World::getNewEmptyCells(const uint64_t& count){
+    const uint64_t freeCount = getFreeCellCount();
+    if (count > freeCount) {
+        throw std::runtime_error("Not enough empty cells");
+    }
+
+    // Floyd's sampling: one draw per cell, distinct ranks without retries
+    std::unordered_set<uint64_t> picked;
+    picked.reserve(count);
+    std::vector<kinematics::Vector2D> cells;
+    cells.reserve(count);
+    for (uint64_t bound = freeCount - count; bound < freeCount; ++bound) {
+        uint64_t rank = drawRandom() % (bound + 1);
+        if (!picked.insert(rank).second) {
+            rank = bound;
+            picked.insert(rank);
+        }
+        uint64_t cellId = findFreeCell(rank);
+        cells.emplace_back(cellId / size.y, cellId % size.y);
+    }
+    return cells;
+}
+
 void World::killEntity(Entity* &entity) {
     kinematics::Vector2D pos = entity->getPosition();
-    uint32_t cellId = getCellId(pos.x, pos.y);
+    noteDeath(entity->speciesId, entity->energy);
+    markChanged(getCellId(pos.x, pos.y));
 
-    gridOccupied.erase(cellId);
-    grid[pos.x][pos.y] = nullptr;
-    delete entity;
+    if (gridLayout == GridLayout::Chunked) {
+        chunkedGrid.set(pos.x, pos.y, nullptr);
+    } else {
+        gridOccupied.reset(pos.x, pos.y);
+        speciesIndex.reset(entity->speciesId, pos.x, pos.y);
+        grid[getCellId(pos.x, pos.y)] = nullptr;
+    }
+    if (stripeContext != nullptr) {
+        stripeContext->retiredEntities.push_back(entity);
+    } else if (entityPool.owns(entity)) {
+        entityPool.release(entity);
+    } else {
+        delete entity;
+    }
     entity = nullptr;
 }
 
-void World::displayWorld() const {
-    uint32_t numPlants = 0, numHerbivores = 0, numCarnivores = 0;
+void World::clear() {
+    grid.assign(grid.size(), nullptr);
+    denseGrid.assign(denseGrid.size(), EntityStore::INVALID);
+    denseCellSpecies.assign(denseCellSpecies.size(), animalconfig::NO_SPECIES);
+    gridOccupied.clear();
+    speciesIndex.clear();
+    chunkedGrid.clear();
+    entityPool.reset();
+    denseStore.clear();
+    stats.clear();
+    for (StripeContext& context : stripeContexts) {
+        context.tallies.assign(PopulationStats::MAX_SPECIES, PopulationStats::Tally());
+        context.changedCells.clear();
+    }
+    changedCells.clear();
+    changesOverflowed = true;
+}
 
-    for (int x = 0; x < size.x; ++x) {
-        for (int y = 0; y < size.y; ++y) {
-            char symbol = getCellSymbol(x, y);
-            std::cout << symbol << ' ';
-            if (symbol == animalconfig::PLANT_CONFIG.symbol) {
-                numPlants++;
-            } else if (symbol == animalconfig::HERBIVORE_CONFIG.symbol) {
-                numHerbivores++;
-            } else if (symbol == animalconfig::CARNIVORE_CONFIG.symbol) {
-                numCarnivores++;
-            }
-        }
-        std::cout << '\n';
+void World::setTickEngine(TickEngine engine) {
+    if (engine != TickEngine::Sweep && gridLayout == GridLayout::Chunked) {
+        throw std::runtime_error("The chunked grid layout runs the sweep engine on a single thread");
+    }
+    tickEngine = engine;
+}
+
+void World::setChangeTracking(const bool& enabled) {
+    // Changed cells are kept as 32-bit ids
+    if (enabled && getCellCount() > UINT32_MAX) {
+        throw std::runtime_error("Change tracking needs a world of at most 2^32 cells");
+    }
+    trackChanges = enabled;
+    changedCells.clear();
+    changesOverflowed = true;
+}
+
+bool World::takeChangedCells(std::vector<uint32_t>& cells) {
+    cells.clear();
+    if (!trackChanges || changesOverflowed) {
+        changedCells.clear();
+        changesOverflowed = false;
+        return false;
     }
-    std::cout << "Plants: " << numPlants << ", Herbivores: " << numHerbivores << ", Carnivores: " << numCarnivores << '\n';
+    cells.swap(changedCells);
+    return true;
 }
-void World::render(sf::RenderWindow& window, std::map<char, sf::Texture>& textures, const uint32_t& tileSize) {
+
+void World::displayWorld() const {
     for (int x = 0; x < size.x; ++x) {
         for (int y = 0; y < size.y; ++y) {
-            sf::Sprite sprite;
-            char symbol = getCellSymbol(x, y);
-            
-            sf::Texture* texture = &textures[' ']; // Default to tile
-            if (textures.count(symbol)) {
-                texture = &textures[symbol];
-            }
-            sprite.setTexture(*texture);
-
-            const Entity* entity = getEntityAt(x, y);
-            if(entity != nullptr && (entity->entityConfig.symbol == 'H' || entity->entityConfig.symbol == 'C')) {
-                if(entity->entityConfig.energy <= 50) {
-                    sf::Color color(255, 100, 100);
-                    color.a = 50 + (3 * entity->entityConfig.energy);
-                    sprite.setColor(color);
-                }
-            }
-
-            // color.a = 200;
-            // sprite.setColor(color);
-            // --- SCALING LOGIC ---
-            // Get the original size of the texture
-            sf::Vector2u textureSize = texture->getSize();
-            // Calculate the scale factor needed to fit the tile size
-            float scaleX = (float)tileSize / textureSize.x;
-            float scaleY = (float)tileSize / textureSize.y;
-            // Apply the scale
-            sprite.setScale(scaleX, scaleY);
-            
-            sprite.setPosition(y * tileSize, x * tileSize);
-            window.draw(sprite);
+            std::cout << getCellSymbol(x, y) << ' ';
         }
+        std::cout << '\n';
     }
-}
\ No newline at end of file
+
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    std::cout << "Plants: " << stats.get(registry.findBySymbol(animalconfig::PLANT_CONFIG.symbol)).count
+              << ", Herbivores: " << stats.get(registry.findBySymbol(animalconfig::HERBIVORE_CONFIG.symbol)).count
+              << ", Carnivores: " << stats.get(registry.findBySymbol(animalconfig::CARNIVORE_CONFIG.symbol)).count << '\n';
+}
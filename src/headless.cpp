@@ -0,0 +1,494 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <memory>
+#include "../include/World.h"
+#include "../include/Entity.h"
+#include "../include/AnimalConfig.h"
+#include "../include/VisionKernel.h"
+#include "../include/FrameExporter.h"
+#include "../include/Profiler.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+using namespace std;
+
+namespace {
+    struct Scenario {
+        uint32_t width = 80;
+        uint32_t height = 40;
+        uint32_t ticks = 1000;
+        uint32_t plants = 400;
+        uint32_t herbivores = 200;
+        uint32_t carnivores = 20;
+        uint32_t seed = 0;
+        uint32_t threads = 1;
+        bool seeded = false;
+        World::StorageMode storage = World::StorageMode::Objects;
+        World::TickEngine engine = World::TickEngine::Sweep;
+        World::NearestSearch search = World::NearestSearch::Scan;
+        World::GridLayout layout = World::GridLayout::Flat;
+        // Spawn: one addEntityType per agent; otherwise one populate() call
+        string seeding = "spawn";
+        string configPath;
+        string loadPath;
+        string savePath;
+        string eventsPath;
+        string statsPath;
+        string framesPath;
+        FrameExporter::Format frameFormat = FrameExporter::Format::PNG;
+        uint32_t frameEvery = 1;
+        uint32_t frameScale = 4;
+        uint32_t checkpointEvery = 0;
+        bool profile = false;
+        string tracePath;
+        uint32_t traceTicks = 10;
+    };
+
+    // Ticks of statistics buffered before they are appended to the file
+    const uint32_t STATS_FLUSH_TICKS = 256;
+
+    // A .bin path gets the binary series, anything else CSV
+    void flushStats(PopulationStats& stats, const string& path){
+        if(path.size() >= 4 && path.compare(path.size() - 4, 4, ".bin") == 0) stats.flushBinary(path);
+        else stats.flushCsv(path);
+    }
+
+    void printUsage(const char* program){
+        cout << "Usage: " << program << " [options]\n"
+             << "  --width, -w <n>       world grid width (default: 80)\n"
+             << "  --height, -h <n>      world grid height (default: 40)\n"
+             << "  --ticks, -n <n>       number of ticks to simulate (default: 1000)\n"
+             << "  --plants <n>          initial plants (default: 400)\n"
+             << "  --herbivores <n>      initial herbivores (default: 200)\n"
+             << "  --carnivores <n>      initial carnivores (default: 20)\n"
+             << "  --seed <n>            random seed (default: time based)\n"
+             << "  --threads, -t <n>     worker threads, 0 = all cores (default: 1)\n"
+             << "  --storage <mode>      objects | dense (default: objects)\n"
+             << "  --engine <engine>     sweep | intent (default: sweep)\n"
+             << "  --search <mode>       scan | field, intent engine only (default: scan)\n"
+             << "  --layout <layout>     flat | chunked, chunked needs objects storage, the sweep engine and one thread (default: flat)\n"
+             << "  --seeding <mode>      spawn | uniform | clustered | poisson (default: spawn)\n"
+             << "  --config <file>       species config (JSON) to load\n"
+             << "  --load <file>         start from a checkpoint instead of seeding\n"
+             << "  --save <file>         write a checkpoint when the run ends\n"
+             << "  --save-every <n>      also write it every n ticks, in the background\n"
+             << "  --events <file>       record every move, birth, kill and starvation\n"
+             << "  --stats <file>        per-species series each tick, .bin for binary, else CSV\n"
+             << "  --frames <dir>        write numbered images of the grid to an existing directory\n"
+             << "  --frame-every <n>     one frame every n ticks (default: 1)\n"
+             << "  --frame-format <fmt>  png | ppm (default: png)\n"
+             << "  --frame-scale <n>     pixels per cell side (default: 4)\n"
+             << "  --profile             time each tick phase and print p50/p99 per phase\n"
+             << "  --trace <file>        write a Chrome trace of the first ticks (implies --profile)\n"
+             << "  --trace-ticks <n>     ticks the trace covers (default: 10)\n";
+    }
+
+    bool parseArgs(int argc, char** argv, Scenario& scenario){
+        for(int i = 1; i < argc; ++i){
+            string arg = argv[i];
+            if(arg == "--help"){
+                printUsage(argv[0]);
+                return false;
+            }
+            if(arg == "--profile"){
+                scenario.profile = true;
+                continue;
+            }
+            if(i + 1 >= argc){
+                cerr << "Missing value for " << arg << '\n';
+                return false;
+            }
+            if(arg == "--storage"){
+                string mode = argv[++i];
+                if(mode == "dense") scenario.storage = World::StorageMode::Dense;
+                else if(mode == "objects") scenario.storage = World::StorageMode::Objects;
+                else {
+                    cerr << "Unknown storage mode " << mode << '\n';
+                    return false;
+                }
+                continue;
+            }
+            if(arg == "--engine"){
+                string engine = argv[++i];
+                if(engine == "intent") scenario.engine = World::TickEngine::Intent;
+                else if(engine == "sweep") scenario.engine = World::TickEngine::Sweep;
+                else {
+                    cerr << "Unknown tick engine " << engine << '\n';
+                    return false;
+                }
+                continue;
+            }
+            if(arg == "--search"){
+                string search = argv[++i];
+                if(search == "field") scenario.search = World::NearestSearch::Field;
+                else if(search == "scan") scenario.search = World::NearestSearch::Scan;
+                else {
+                    cerr << "Unknown search mode " << search << '\n';
+                    return false;
+                }
+                continue;
+            }
+            if(arg == "--layout"){
+                string layout = argv[++i];
+                if(layout == "chunked") scenario.layout = World::GridLayout::Chunked;
+                else if(layout == "flat") scenario.layout = World::GridLayout::Flat;
+                else {
+                    cerr << "Unknown grid layout " << layout << '\n';
+                    return false;
+                }
+                continue;
+            }
+            if(arg == "--seeding"){
+                scenario.seeding = argv[++i];
+                if(scenario.seeding != "spawn" && scenario.seeding != "uniform" && scenario.seeding != "clustered" && scenario.seeding != "poisson"){
+                    cerr << "Unknown seeding mode " << scenario.seeding << '\n';
+                    return false;
+                }
+                continue;
+            }
+            if(arg == "--config"){
+                scenario.configPath = argv[++i];
+                continue;
+            }
+            if(arg == "--load"){
+                scenario.loadPath = argv[++i];
+                continue;
+            }
+            if(arg == "--save"){
+                scenario.savePath = argv[++i];
+                continue;
+            }
+            if(arg == "--events"){
+                scenario.eventsPath = argv[++i];
+                continue;
+            }
+            if(arg == "--stats"){
+                scenario.statsPath = argv[++i];
+                continue;
+            }
+            if(arg == "--trace"){
+                scenario.tracePath = argv[++i];
+                scenario.profile = true;
+                continue;
+            }
+            if(arg == "--frames"){
+                scenario.framesPath = argv[++i];
+                continue;
+            }
+            if(arg == "--frame-format"){
+                string format = argv[++i];
+                if(format == "png") scenario.frameFormat = FrameExporter::Format::PNG;
+                else if(format == "ppm") scenario.frameFormat = FrameExporter::Format::PPM;
+                else {
+                    cerr << "Unknown frame format " << format << '\n';
+                    return false;
+                }
+                continue;
+            }
+            uint32_t value = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+
+            if(arg == "--width" || arg == "-w") scenario.width = value;
+            else if(arg == "--height" || arg == "-h") scenario.height = value;
+            else if(arg == "--ticks" || arg == "-n") scenario.ticks = value;
+            else if(arg == "--plants") scenario.plants = value;
+            else if(arg == "--herbivores") scenario.herbivores = value;
+            else if(arg == "--carnivores") scenario.carnivores = value;
+            else if(arg == "--seed") { scenario.seed = value; scenario.seeded = true; }
+            else if(arg == "--threads" || arg == "-t") scenario.threads = value;
+            else if(arg == "--save-every") scenario.checkpointEvery = value;
+            else if(arg == "--frame-every") scenario.frameEvery = value;
+            else if(arg == "--frame-scale") scenario.frameScale = value;
+            else if(arg == "--trace-ticks") scenario.traceTicks = value;
+            else {
+                cerr << "Unknown option " << arg << '\n';
+                printUsage(argv[0]);
+                return false;
+            }
+        }
+        if(scenario.checkpointEvery > 0 && scenario.savePath.empty()){
+            cerr << "--save-every needs --save\n";
+            return false;
+        }
+        return scenario.width > 0 && scenario.height > 0;
+    }
+
+    // Peak resident set size of this process in bytes.
+    uint64_t peakMemoryBytes(){
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return counters.PeakWorkingSetSize;
+        return 0;
+#else
+        struct rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+    #if defined(__APPLE__)
+        return usage.ru_maxrss;
+    #else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+    #endif
+#endif
+    }
+}
+
+int main(int argc, char** argv){
+    Scenario scenario;
+    if(!parseArgs(argc, argv, scenario)){
+        return 1;
+    }
+    if(!scenario.configPath.empty()){
+        try{
+            animalconfig::SpeciesRegistry::getInstance().loadFromFile(scenario.configPath);
+        } catch (const std::runtime_error& e){
+            cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    if(scenario.layout == World::GridLayout::Chunked && scenario.storage != World::StorageMode::Objects){
+        cerr << "The chunked layout needs objects storage\n";
+        return 1;
+    }
+    if(scenario.layout == World::GridLayout::Chunked && (scenario.engine != World::TickEngine::Sweep || scenario.threads != 1)){
+        cerr << "The chunked layout runs the sweep engine on a single thread\n";
+        return 1;
+    }
+
+    World &world = World::getInstance();
+    world.setGridLayout(scenario.layout);
+    world.initialize(scenario.height, scenario.width);
+    world.setStorageMode(scenario.storage);
+    world.setThreadCount(scenario.threads);
+    world.setTickEngine(scenario.engine);
+    world.setNearestSearch(scenario.search);
+    world.setSeed(scenario.seeded ? scenario.seed : time(0));
+
+    auto seedingStart = chrono::steady_clock::now();
+    try{
+        if(!scenario.loadPath.empty()){
+            // Size, storage, layout, engine, species and random state all come from the file
+            world.loadCheckpoint(scenario.loadPath);
+            scenario.seeding = "checkpoint";
+        } else if(scenario.seeding == "spawn"){
+            for(uint32_t i = 0; i < scenario.plants; ++i) world.addEntityType(animalconfig::PLANT_CONFIG.symbol);
+            for(uint32_t i = 0; i < scenario.herbivores; ++i) world.addEntityType(animalconfig::HERBIVORE_CONFIG.symbol);
+            for(uint32_t i = 0; i < scenario.carnivores; ++i) world.addEntityType(animalconfig::CARNIVORE_CONFIG.symbol);
+        } else {
+            const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+            const char symbols[3] = {animalconfig::PLANT_CONFIG.symbol, animalconfig::HERBIVORE_CONFIG.symbol, animalconfig::CARNIVORE_CONFIG.symbol};
+            const uint32_t counts[3] = {scenario.plants, scenario.herbivores, scenario.carnivores};
+            vector<World::Population> populations(3);
+            for(int i = 0; i < 3; ++i){
+                populations[i].species = registry.findBySymbol(symbols[i]);
+                populations[i].count = counts[i];
+                if(scenario.seeding == "clustered"){
+                    populations[i].pattern = World::Population::Pattern::Clustered;
+                    populations[i].clusters = 1 + counts[i] / 500;
+                    populations[i].spread = 8.0;
+                } else if(scenario.seeding == "poisson"){
+                    populations[i].pattern = World::Population::Pattern::PoissonDisk;
+                }
+            }
+            world.populate(populations);
+        }
+    } catch (const std::runtime_error& e){
+        cerr << "Failed to seed world: " << e.what() << '\n';
+        return 1;
+    }
+    double seedingSeconds = chrono::duration<double>(chrono::steady_clock::now() - seedingStart).count();
+    uint32_t seededCount = world.getOccupiedCellsCount();
+
+    if(!scenario.eventsPath.empty()){
+        try{
+            world.startEventLog(scenario.eventsPath);
+        } catch (const std::runtime_error& e){
+            cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    if(!scenario.statsPath.empty()){
+        // Start a fresh series rather than appending to an old one
+        ofstream(scenario.statsPath, ios::trunc);
+        world.getStats().setRecording(true);
+    }
+
+    unique_ptr<FrameExporter> frames;
+    if(!scenario.framesPath.empty()){
+        FrameExporter::Options options;
+        options.directory = scenario.framesPath;
+        options.format = scenario.frameFormat;
+        options.every = scenario.frameEvery;
+        options.cellPixels = scenario.frameScale;
+        try{
+            frames.reset(new FrameExporter(options));
+        } catch (const std::runtime_error& e){
+            cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    profiler::Profiler& profiler = profiler::Profiler::getInstance();
+    if(scenario.profile){
+        if(!ECOSIM_PROFILE)
+            cerr << "This build has no profiler timers (ECOSIM_PROFILE=OFF)\n";
+        if(!scenario.tracePath.empty()) profiler.startTrace(scenario.traceTicks);
+        else profiler.setEnabled(true);
+    }
+
+    uint64_t entityUpdates = 0;
+    uint32_t ticks = 0;
+    uint32_t spawnTime = 0;
+    auto start = chrono::steady_clock::now();
+
+    for(; ticks < scenario.ticks; ++ticks){
+        // Same plant spawning cadence as the windowed viewer
+        if(spawnTime == 0){
+            spawnTime = (world.drawRandom() % 4) + 4;
+        } else if(spawnTime == (ticks % 10)){
+            if(!world.isFull())
+                world.addEntityType(animalconfig::PLANT_CONFIG.symbol);
+            spawnTime = 0;
+        }
+
+        entityUpdates += world.getOccupiedCellsCount();
+        world.run();
+        if(frames){
+            frames->capture(world);
+        }
+
+        if(world.getStats().isRecording() && (ticks + 1) % STATS_FLUSH_TICKS == 0){
+            try{
+                flushStats(world.getStats(), scenario.statsPath);
+            } catch (const std::runtime_error& e){
+                cerr << e.what() << '\n';
+                return 1;
+            }
+        }
+
+        if(scenario.checkpointEvery > 0 && (ticks + 1) % scenario.checkpointEvery == 0){
+            world.saveCheckpointAsync(scenario.savePath);
+        }
+
+        if(world.getOccupiedCellsCount() == 0){
+            ++ticks;
+            break;
+        }
+    }
+
+    // The last events are written out within the timed run
+    uint64_t eventCount = 0;
+    if(world.getEventLog()){
+        try{
+            eventCount = world.stopEventLog();
+        } catch (const std::runtime_error& e){
+            cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    if(world.getStats().isRecording()){
+        try{
+            flushStats(world.getStats(), scenario.statsPath);
+        } catch (const std::runtime_error& e){
+            cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    // Frames still being encoded are waited for outside the timed run
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if(seconds <= 0.0) seconds = 1e-9;
+    profiler.setEnabled(false);
+
+    if(!scenario.tracePath.empty()){
+        try{
+            profiler.writeChromeTrace(scenario.tracePath);
+        } catch (const std::runtime_error& e){
+            cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    if(frames){
+        try{
+            frames->close();
+        } catch (const std::runtime_error& e){
+            cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    if(!scenario.savePath.empty()){
+        try{
+            world.waitForCheckpoint();
+            world.saveCheckpoint(scenario.savePath);
+        } catch (const std::runtime_error& e){
+            cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    cout << "World:         " << world.size.y << "x" << world.size.x << '\n'
+         << "Seeding:       " << scenario.seeding << ", " << seededCount << " agents in " << seedingSeconds << " s\n"
+         << "Ticks:         " << ticks << '\n'
+         << "Elapsed:       " << seconds << " s\n"
+         << "Ticks/sec:     " << ticks / seconds << '\n'
+         << "Entities/sec:  " << entityUpdates / seconds << '\n'
+         << "Final count:   " << world.getOccupiedCellsCount() << '\n'
+         << "Species:       ";
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    for(uint32_t species = 1; species <= registry.getCount(); ++species){
+        const PopulationStats::Tally& tally = world.getStats().get(species);
+        cout << (species > 1 ? ", " : "") << registry.getName(species) << " " << tally.count
+             << " (+" << tally.births << " -" << tally.deaths << ")";
+    }
+    cout << '\n'
+         << "Storage:       " << (world.getStorageMode() == World::StorageMode::Dense ? "dense" : "objects") << '\n'
+         << "Threads:       " << world.getThreadCount() << '\n'
+         << "Engine:        " << (world.getTickEngine() == World::TickEngine::Intent ? "intent" : "sweep") << '\n'
+         << "Search:        " << (world.getNearestSearch() == World::NearestSearch::Field ? "field" : "scan") << '\n'
+         << "Vision kernel: " << vision::getKernelName(vision::getKernel()) << '\n'
+         << "Events:        ";
+    if(!scenario.eventsPath.empty()){
+        ifstream events(scenario.eventsPath, ios::binary | ios::ate);
+        cout << eventCount << " in " << events.tellg() / (1024.0 * 1024.0) << " MiB"
+             << (EventLog::isCompressed() ? "" : " (uncompressed)") << '\n';
+    } else {
+        cout << "off\n";
+    }
+    cout << "Frames:        ";
+    if(frames){
+        cout << frames->getFramesWritten() << " in " << scenario.framesPath << '\n';
+    } else {
+        cout << "off\n";
+    }
+    cout << "Layout:        " << (world.getGridLayout() == World::GridLayout::Chunked ? "chunked" : "flat");
+    if(world.getGridLayout() == World::GridLayout::Chunked){
+        cout << " (" << world.getChunkedGrid().getChunkCount() << " chunks, "
+             << world.getChunkedGrid().getMemoryBytes() / (1024.0 * 1024.0) << " MiB)";
+    }
+    cout << '\n'
+         << "Pool peak:     " << world.getEntityPool().getHighWaterMark() << " entities in "
+                              << world.getEntityPool().getSlabCount() << " slabs\n"
+         << "Peak memory:   " << peakMemoryBytes() / (1024.0 * 1024.0) << " MiB" << endl;
+    if(scenario.profile){
+        cout << '\n';
+        profiler.printSummary(cout);
+        if(!scenario.tracePath.empty())
+            cout << "Trace:         " << scenario.tracePath << " (" << profiler.getDroppedTraceEvents() << " events dropped)\n";
+    }
+    return 0;
+}
@@ -1,77 +1,222 @@
 #include <iostream>
 #include <cstdlib>
-#include <thread>
-#include <chrono>
+#include <algorithm>
 #include <ctime>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cmath>
 #include <SFML/Graphics.hpp>
 #include "../include/World.h"
 #include "../include/Entity.h"
 #include "../include/AnimalConfig.h"
+#include "../include/Renderer.h"
+#include "../include/Logger.h"
+#include "../include/SimulationThread.h"
 
 using namespace std;
 
 const uint32_t WIDTH = 15;
 const uint32_t HEIGHT = 15;
 const uint32_t TILE_SIZE = 48;
+// Largest window; bigger worlds are zoomed out to fit and drawn as density
+const uint32_t MAX_WINDOW_WIDTH = 1280;
+const uint32_t MAX_WINDOW_HEIGHT = 800;
+// Mouse wheel zoom a notch, and the share of the view W/A/S/D pan by
+const float ZOOM_STEP = 1.25f;
+const float PAN_STEP = 0.125f;
+const uint32_t FRAME_RATE = 60;
+// Ticks per second at normal speed; F runs the simulation uncapped instead
+const double TICK_RATE = 2.5;
+// Fastest fast-forward, and slowest slow motion as its inverse
+const double MAX_SPEED = 64.0;
+
+// The whole world, centred, at the largest scale that fits the window
+sf::View getFittedView(const sf::RenderWindow& window, const uint32_t& rows, const uint32_t& columns){
+    const float width = static_cast<float>(columns) * TILE_SIZE;
+    const float height = static_cast<float>(rows) * TILE_SIZE;
+    const float scale = max(width / window.getSize().x, height / window.getSize().y);
+    return sf::View(sf::Vector2f(width / 2, height / 2), sf::Vector2f(window.getSize().x * scale, window.getSize().y * scale));
+}
+
+// Scales the view by `factor`, keeping the point under `pixel` in place
+void zoomView(sf::RenderWindow& window, sf::View& view, const float& factor, const sf::Vector2i& pixel){
+    const sf::Vector2f before = window.mapPixelToCoords(pixel, view);
+    view.zoom(factor);
+    const sf::Vector2f after = window.mapPixelToCoords(pixel, view);
+    view.move(before - after);
+}
 
 void initializeWorldWithEntities(const uint32_t& numPlants, const uint32_t& numHerbivores, const uint32_t& numCarnivores){
     World &world = World::getInstance();
-    for(uint32_t i = 0; i < numPlants; ++i){
-        world.addEntityType(animalconfig::PLANT_CONFIG.symbol);
-    }
-    for(uint32_t i = 0; i < numHerbivores; ++i){
-        world.addEntityType(animalconfig::HERBIVORE_CONFIG.symbol);
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    vector<World::Population> populations(3);
+    populations[0].species = registry.findBySymbol(animalconfig::PLANT_CONFIG.symbol);
+    populations[0].count = numPlants;
+    populations[1].species = registry.findBySymbol(animalconfig::HERBIVORE_CONFIG.symbol);
+    populations[1].count = numHerbivores;
+    populations[2].species = registry.findBySymbol(animalconfig::CARNIVORE_CONFIG.symbol);
+    populations[2].count = numCarnivores;
+    world.populate(populations);
+}
+int main(int argc, char** argv){
+    // --threads, -t <n>: worker threads for the tick, 0 (default) uses every core
+    // --width, -w / --height, -h <n>: world size in cells
+    uint32_t threads = 0;
+    uint32_t width = WIDTH, height = HEIGHT;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" || arg == "-t") {
+            threads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--width" || arg == "-w") {
+            width = max(1ul, strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--height" || arg == "-h") {
+            height = max(1ul, strtoul(argv[++i], nullptr, 10));
+        }
     }
-    for(uint32_t i = 0; i < numCarnivores; ++i){
-        world.addEntityType(animalconfig::CARNIVORE_CONFIG.symbol);
+
+    // Species overrides are optional; the built-in species are used without a config file
+    if (std::ifstream("../config.json")) {
+        try {
+            animalconfig::SpeciesRegistry::getInstance().loadFromFile("../config.json");
+        } catch (const std::runtime_error& e) {
+            ECOSIM_LOG_ERROR("{}", e.what());
+            return -1;
+        }
     }
-}
-int main(){
-    srand(time(0));
     World &world = World::getInstance();
-    world.initialize(HEIGHT, WIDTH);
+    world.initialize(height, width);
+    world.setThreadCount(threads);
+    world.setSeed(time(0));
 
-    initializeWorldWithEntities(15, 10, 2);
+    // 15 plants, 10 herbivores and 2 carnivores to the default 15 x 15 world
+    const uint64_t cells = static_cast<uint64_t>(width) * height;
+    initializeWorldWithEntities(cells / 15, cells / 22, max<uint64_t>(1, cells / 112));
 
-    sf::RenderWindow window(sf::VideoMode(WIDTH * TILE_SIZE, HEIGHT * TILE_SIZE), "EcoSim");
+    sf::RenderWindow window(sf::VideoMode(min(width * TILE_SIZE, MAX_WINDOW_WIDTH), min(height * TILE_SIZE, MAX_WINDOW_HEIGHT)), "EcoSim");
+    sf::View view = getFittedView(window, height, width);
+    float windowWidth = window.getSize().x;
+    bool dragging = false;
+    sf::Vector2i dragFrom;
 
     std::map<char, sf::Texture> textures;
-    if (!textures['H'].loadFromFile("../sprites/sheep.png")) { cerr << "Error loading sheep.png" << endl; return -1; }
-    if (!textures['C'].loadFromFile("../sprites/wolf.png")) { cerr << "Error loading wolf.png" << endl; return -1; }
-    if (!textures['*'].loadFromFile("../sprites/bush.png")) { cerr << "Error loading bush.png" << endl; return -1; }
-    if (!textures['.'].loadFromFile("../sprites/tile.png")) { cerr << "Error loading tile.png" << endl; return -1; }
+    if (!textures['H'].loadFromFile("../sprites/sheep.png")) { ECOSIM_LOG_ERROR("Error loading {}", "sheep.png"); return -1; }
+    if (!textures['C'].loadFromFile("../sprites/wolf.png")) { ECOSIM_LOG_ERROR("Error loading {}", "wolf.png"); return -1; }
+    if (!textures['*'].loadFromFile("../sprites/bush.png")) { ECOSIM_LOG_ERROR("Error loading {}", "bush.png"); return -1; }
+    if (!textures['.'].loadFromFile("../sprites/tile.png")) { ECOSIM_LOG_ERROR("Error loading {}", "tile.png"); return -1; }
     textures[' '] = textures['.'];
+    renderer::TileRenderer tiles(textures, TILE_SIZE);
 
-    int counter = 0;
+    // Same plant spawning cadence as before, now run on the simulation thread
     uint32_t spawnTime = 0;
-    while(window.isOpen()){
-        if(spawnTime == 0){
-            spawnTime = (rand() % 4) + 4;
-        } else if(spawnTime == (counter % 10)){
-            world.addEntityType(animalconfig::PLANT_CONFIG.symbol);
+    SimulationThread simulation(world, [&spawnTime](World& ticked) {
+        if (spawnTime == 0) {
+            spawnTime = (ticked.drawRandom() % 4) + 4;
+        } else if (spawnTime == (ticked.getTick() % 10)) {
+            if (!ticked.isFull())
+                ticked.addEntityType(animalconfig::PLANT_CONFIG.symbol);
             spawnTime = 0;
         }
+    });
+    simulation.setTickRate(TICK_RATE);
+    window.setFramerateLimit(FRAME_RATE);
+
+    uint64_t loggedTick = UINT64_MAX;
+    while(window.isOpen()){
         sf::Event event;
         while(window.pollEvent(event)){
             if(event.type == sf::Event::Closed)
                 window.close();
+            if(event.type == sf::Event::Resized){
+                // Same scale, more or less of the world
+                const float scale = view.getSize().x / windowWidth;
+                view.setSize(event.size.width * scale, event.size.height * scale);
+                windowWidth = event.size.width;
+            }
+            if(event.type == sf::Event::MouseWheelScrolled)
+                zoomView(window, view, pow(ZOOM_STEP, -event.mouseWheelScroll.delta), sf::Vector2i(event.mouseWheelScroll.x, event.mouseWheelScroll.y));
+            if(event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left){
+                dragging = true;
+                dragFrom = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+            }
+            if(event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left)
+                dragging = false;
+            if(event.type == sf::Event::MouseMoved && dragging){
+                const sf::Vector2i to(event.mouseMove.x, event.mouseMove.y);
+                view.move(window.mapPixelToCoords(dragFrom, view) - window.mapPixelToCoords(to, view));
+                dragFrom = to;
+            }
+            if(event.type != sf::Event::KeyPressed)
+                continue;
+            switch(event.key.code){
+                case sf::Keyboard::Space:
+                    simulation.setPaused(!simulation.isPaused());
+                    break;
+                case sf::Keyboard::Right:
+                case sf::Keyboard::Period:
+                    simulation.setPaused(true);
+                    simulation.step();
+                    break;
+                case sf::Keyboard::Add:
+                case sf::Keyboard::Equal:
+                    simulation.setSpeed(min(simulation.getSpeed() * 2, MAX_SPEED));
+                    break;
+                case sf::Keyboard::Subtract:
+                case sf::Keyboard::Hyphen:
+                    simulation.setSpeed(max(simulation.getSpeed() / 2, 1 / MAX_SPEED));
+                    break;
+                case sf::Keyboard::F:
+                    simulation.setTickRate(simulation.getTickRate() > 0 ? 0 : TICK_RATE);
+                    break;
+                case sf::Keyboard::W:
+                    view.move(0, -view.getSize().y * PAN_STEP);
+                    break;
+                case sf::Keyboard::S:
+                    view.move(0, view.getSize().y * PAN_STEP);
+                    break;
+                case sf::Keyboard::A:
+                    view.move(-view.getSize().x * PAN_STEP, 0);
+                    break;
+                case sf::Keyboard::D:
+                    view.move(view.getSize().x * PAN_STEP, 0);
+                    break;
+                case sf::Keyboard::Home:
+                    view = getFittedView(window, height, width);
+                    break;
+                case sf::Keyboard::E:
+                    tiles.setOverlay(tiles.getOverlay() == renderer::TileRenderer::Overlay::Species ? renderer::TileRenderer::Overlay::Energy : renderer::TileRenderer::Overlay::Species);
+                    break;
+                default:
+                    break;
+            }
         }
 
-        world.run();
-        
+        // Whatever tick the simulation finished last; it never waits for us
+        const WorldSnapshot* snapshot = simulation.getLatestSnapshot();
         window.clear();
-        // Pass the TILE_SIZE to the render function
-        world.render(window, textures, TILE_SIZE);
+        window.setView(view);
+        if (snapshot != nullptr)
+            tiles.render(*snapshot, window);
         window.display();
 
-        cout << "Iteration: " << counter++ << " - Occupied Cells: " << world.getOccupiedCellsCount() << endl;
-        
-        if (world.getOccupiedCellsCount() == 0) {
-            cout << "WARNING: No entities left in the world!" << endl;
+        if (snapshot == nullptr || snapshot->tick == loggedTick)
+            continue;
+        loggedTick = snapshot->tick;
+        ECOSIM_LOG_INFO("Iteration: {} - Occupied Cells: {}", snapshot->tick, snapshot->occupied);
+        for (uint32_t species = 1; species < snapshot->counts.size(); ++species) {
+            ECOSIM_LOG_DEBUG("  {}: {}", animalconfig::SpeciesRegistry::getInstance().getName(species), snapshot->counts[species]);
+        }
+        if (snapshot->occupied == 0) {
+            ECOSIM_LOG_WARNING("No entities left in the world!");
             break;
         }
-        
-        this_thread::sleep_for(chrono::milliseconds(400));
+    }
+
+    try {
+        simulation.stop();
+    } catch (const std::runtime_error& e) {
+        ECOSIM_LOG_ERROR("Simulation stopped: {}", e.what());
+        return -1;
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -13,10 +13,125 @@ TEST(AnimalConfigTest, HerbivoreConfig) {
     EXPECT_EQ(animalconfig::HERBIVORE_CONFIG.prey, '*');
     EXPECT_EQ(animalconfig::HERBIVORE_CONFIG.energy, 100);
     EXPECT_EQ(animalconfig::HERBIVORE_CONFIG.maxEnergy, 200);
-    EXPECT_EQ(animalconfig::HERBIVORE_CONFIG.visionRange, 5);
-    EXPECT_EQ(animalconfig::HERBIVORE_CONFIG.reproductionCost, 50);
+    EXPECT_EQ(animalconfig::HERBIVORE_CONFIG.visionRange, 2);
+    EXPECT_EQ(animalconfig::HERBIVORE_CONFIG.reproductionCost, 100);
     EXPECT_EQ(animalconfig::HERBIVORE_CONFIG.reproductionThreshold, 150);
     EXPECT_EQ(animalconfig::HERBIVORE_CONFIG.energyGainFromEating, 20);
     EXPECT_EQ(animalconfig::HERBIVORE_CONFIG.energyCostPerTick, 1);
 }
 
+
+class SpeciesRegistryTest: public ::testing::Test {
+protected:
+    void TearDown() override {
+        animalconfig::SpeciesRegistry::getInstance().reset();
+    }
+};
+
+TEST_F(SpeciesRegistryTest, BuiltInSpecies) {
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    animalconfig::SpeciesId herbivore = registry.findBySymbol('H');
+    animalconfig::SpeciesId plant = registry.findBySymbol('*');
+
+    EXPECT_EQ(registry.getCount(), 3);
+    EXPECT_EQ(registry.get(herbivore).maxEnergy, animalconfig::HERBIVORE_CONFIG.maxEnergy);
+    EXPECT_EQ(registry.getPrey(herbivore), plant);
+    EXPECT_TRUE(registry.isMobile(herbivore));
+    EXPECT_FALSE(registry.isMobile(plant));
+    EXPECT_EQ(registry.findBySymbol('X'), animalconfig::NO_SPECIES);
+    EXPECT_EQ(registry.get(animalconfig::NO_SPECIES).symbol, '.');
+}
+
+TEST_F(SpeciesRegistryTest, LoadAddsAndOverrides) {
+    animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    registry.loadFromString(R"({
+        "species": [
+            { "symbol": "H", "visionRange": 4 },
+            { "name": "fox", "symbol": "F", "prey": "H", "energy": 80, "maxEnergy": 160, "visionRange": 3 },
+            { "name": "bear", "symbol": "B", "prey": "F" }
+        ]
+    })");
+
+    animalconfig::SpeciesId herbivore = registry.findBySymbol('H');
+    animalconfig::SpeciesId fox = registry.findBySymbol('F');
+    animalconfig::SpeciesId bear = registry.findBySymbol('B');
+
+    EXPECT_EQ(registry.getCount(), 5);
+    EXPECT_EQ(registry.get(herbivore).visionRange, 4);
+    EXPECT_EQ(registry.get(herbivore).maxEnergy, animalconfig::HERBIVORE_CONFIG.maxEnergy); // Untouched fields kept
+    EXPECT_EQ(registry.getName(fox), "fox");
+    EXPECT_EQ(registry.get(fox).energy, 80);
+    EXPECT_EQ(registry.getPrey(fox), herbivore);
+    EXPECT_TRUE(registry.isMobile(fox));
+
+    // Ranks default to one above the prey
+    EXPECT_EQ(registry.getRank(fox), registry.getRank(herbivore) + 1);
+    EXPECT_EQ(registry.getRank(bear), registry.getRank(fox) + 1);
+    EXPECT_EQ(animalconfig::getEntityRank('B'), registry.getRank(bear));
+}
+
+TEST_F(SpeciesRegistryTest, RejectsMalformedConfig) {
+    animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+
+    EXPECT_THROW(registry.loadFromString("{\"species\": [ {\"symbol\": \"H\", } ]}"), std::runtime_error);
+    EXPECT_THROW(registry.loadFromString("{\"animals\": []}"), std::runtime_error);
+    EXPECT_THROW(registry.loadFromString("{\"species\": [ {\"symbol\": \"Q\", \"speed\": 3} ]}"), std::runtime_error);
+    EXPECT_THROW(registry.loadFromString("{\"species\": [ {\"symbol\": \"QQ\"} ]}"), std::runtime_error);
+    EXPECT_THROW(registry.loadFromFile("does-not-exist.json"), std::runtime_error);
+    EXPECT_THROW(registry.loadFromString("{\"species\": [ {\"symbol\": \"H\", \"reproductionThreshold\": 110, \"reproductionCost\": 150} ]}"), std::runtime_error);
+}
+
+TEST_F(SpeciesRegistryTest, RejectsNumbersThatDoNotFit) {
+    animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+
+    EXPECT_THROW(registry.loadFromString("{\"species\": [ {\"symbol\": \"H\", \"energy\": 2.7} ]}"), std::runtime_error);
+    EXPECT_THROW(registry.loadFromString("{\"species\": [ {\"symbol\": \"H\", \"maxEnergy\": 5000000000} ]}"), std::runtime_error);
+    EXPECT_THROW(registry.loadFromString("{\"species\": [ {\"symbol\": \"H\", \"energy\": -1} ]}"), std::runtime_error);
+    EXPECT_NO_THROW(registry.loadFromString("{\"species\": [ {\"symbol\": \"H\", \"maxEnergy\": 4294967295} ]}"));
+    EXPECT_EQ(registry.get(registry.findBySymbol('H')).maxEnergy, UINT32_MAX);
+}
+
+TEST_F(SpeciesRegistryTest, CapsVisionRange) {
+    animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    animalconfig::SpeciesId herbivore = registry.findBySymbol('H');
+
+    EXPECT_THROW(registry.loadFromString("{\"species\": [ {\"symbol\": \"H\", \"visionRange\": 255} ]}"), std::runtime_error);
+    EXPECT_THROW(registry.loadFromString("{\"species\": [ {\"symbol\": \"H\", \"visionRange\": 4294967295} ]}"), std::runtime_error);
+    EXPECT_EQ(registry.get(herbivore).visionRange, animalconfig::HERBIVORE_CONFIG.visionRange);
+
+    animalconfig::config farSighted = animalconfig::HERBIVORE_CONFIG;
+    farSighted.visionRange = animalconfig::MAX_VISION_RANGE + 1;
+    EXPECT_THROW(registry.add("hawk", farSighted, 1, true), std::runtime_error);
+
+    EXPECT_NO_THROW(registry.loadFromString("{\"species\": [ {\"symbol\": \"H\", \"visionRange\": 254} ]}"));
+    EXPECT_EQ(registry.get(herbivore).visionRange, animalconfig::MAX_VISION_RANGE);
+}
+
+TEST_F(SpeciesRegistryTest, FailedLoadLeavesRegistryUnchanged) {
+    animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    animalconfig::SpeciesId herbivore = registry.findBySymbol('H');
+
+    // The third entry is bad; the first two must not stick
+    EXPECT_THROW(registry.loadFromString(R"({
+        "species": [
+            { "symbol": "H", "visionRange": 7 },
+            { "name": "fox", "symbol": "F", "prey": "H" },
+            { "symbol": "B", "energy": "lots" }
+        ]
+    })"), std::runtime_error);
+
+    EXPECT_EQ(registry.getCount(), 3);
+    EXPECT_EQ(registry.findBySymbol('F'), animalconfig::NO_SPECIES);
+    EXPECT_EQ(registry.findBySymbol('B'), animalconfig::NO_SPECIES);
+    EXPECT_EQ(registry.get(herbivore).visionRange, animalconfig::HERBIVORE_CONFIG.visionRange);
+    EXPECT_EQ(registry.getPredators(herbivore).size(), 1u);
+}
+
+TEST_F(SpeciesRegistryTest, Reset) {
+    animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    registry.loadFromString(R"({"species": [{"symbol": "F", "prey": "H"}]})");
+    registry.reset();
+
+    EXPECT_EQ(registry.getCount(), 3);
+    EXPECT_EQ(registry.findBySymbol('F'), animalconfig::NO_SPECIES);
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <utility>
+#include "../include/BitGrid.h"
+
+TEST(BitGridTest, StartsEmpty) {
+    BitGrid bits(10, 70);
+    EXPECT_EQ(bits.getCount(), 0);
+    EXPECT_EQ(bits.getWordsPerRow(), 2);
+    EXPECT_FALSE(bits.test(9, 69));
+}
+
+TEST(BitGridTest, SetAndReset) {
+    BitGrid bits(4, 100);
+
+    EXPECT_TRUE(bits.set(3, 64));
+    EXPECT_FALSE(bits.set(3, 64)); // Already set
+    EXPECT_TRUE(bits.test(3, 64));
+    EXPECT_FALSE(bits.test(3, 63));
+    EXPECT_FALSE(bits.test(2, 64));
+    EXPECT_EQ(bits.getCount(), 1);
+
+    EXPECT_TRUE(bits.reset(3, 64));
+    EXPECT_FALSE(bits.reset(3, 64)); // Already clear
+    EXPECT_FALSE(bits.test(3, 64));
+    EXPECT_EQ(bits.getCount(), 0);
+}
+
+TEST(BitGridTest, RowsAreWordAligned) {
+    BitGrid bits(3, 10);
+    bits.set(1, 0);
+    bits.set(1, 9);
+
+    const uint64_t* row = bits.getRowWords(1);
+    EXPECT_EQ(row[0], (1ULL << 0) | (1ULL << 9));
+    EXPECT_EQ(bits.getRowWords(0)[0], 0);
+    EXPECT_EQ(bits.getRowWords(2)[0], 0);
+}
+
+TEST(BitGridTest, Clear) {
+    BitGrid bits(8, 8);
+    for (uint32_t i = 0; i < 8; ++i) {
+        bits.set(i, i);
+    }
+    EXPECT_EQ(bits.getCount(), 8);
+
+    bits.clear();
+    EXPECT_EQ(bits.getCount(), 0);
+    EXPECT_FALSE(bits.test(4, 4));
+}
+
+TEST(BitGridTest, PausedCount) {
+    BitGrid bits(4, 130);
+    bits.set(0, 0);
+    bits.pauseCount();
+
+    bits.set(1, 129);
+    bits.set(3, 64);
+    bits.reset(0, 0);
+    EXPECT_EQ(bits.getCount(), 1); // Untouched while paused
+    EXPECT_TRUE(bits.test(3, 64));
+
+    bits.resumeCount();
+    EXPECT_EQ(bits.getCount(), 2);
+    bits.set(2, 5);
+    EXPECT_EQ(bits.getCount(), 3);
+}
+
+TEST(BitGridTest, BitScans) {
+    EXPECT_EQ(BitGrid::lowestBit(1ULL), 0);
+    EXPECT_EQ(BitGrid::highestBit(1ULL), 0);
+    EXPECT_EQ(BitGrid::lowestBit((1ULL << 63) | (1ULL << 5)), 5);
+    EXPECT_EQ(BitGrid::highestBit((1ULL << 63) | (1ULL << 5)), 63);
+}
+
+TEST(BitGridTest, ForEachSetFollowsLiveBits) {
+    BitGrid bits(3, 130);
+    bits.set(0, 5);
+    bits.set(1, 64);
+    bits.set(2, 129);
+
+    std::vector<std::pair<uint32_t, uint32_t>> visited;
+    bits.forEachSet(0, 3, [&](uint32_t row, uint32_t col) {
+        visited.emplace_back(row, col);
+        if (row == 0 && col == 5) {
+            bits.set(0, 9);     // Ahead of the scan: visited
+            bits.set(0, 2);     // Behind it: not
+            bits.reset(1, 64);  // Cleared before the scan gets there
+        }
+    });
+
+    std::vector<std::pair<uint32_t, uint32_t>> expected = {{0, 5}, {0, 9}, {2, 129}};
+    EXPECT_EQ(visited, expected);
+}
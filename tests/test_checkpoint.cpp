@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include "../include/Checkpoint.h"
+#include "../include/World.h"
+#include "../include/Entity.h"
+
+class CheckpointTest: public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "ecosim_checkpoint_test.bin";
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+        animalconfig::SpeciesRegistry::getInstance().reset();
+    }
+
+    std::unique_ptr<World> seeded(const World::StorageMode& storage, const World::GridLayout& layout) {
+        std::unique_ptr<World> world = World::createTestInstance(0, 0);
+        world->setGridLayout(layout);
+        world->initialize(60, 70);
+        world->setStorageMode(storage);
+        world->setSeed(5);
+        for (int i = 0; i < 600; ++i) world->addEntityType('*');
+        for (int i = 0; i < 250; ++i) world->addEntityType('H');
+        for (int i = 0; i < 25; ++i) world->addEntityType('C');
+        return world;
+    }
+
+    // Species, energy and id of every cell, row-major
+    static std::vector<uint64_t> fingerprint(const World& world) {
+        std::vector<uint64_t> cells;
+        for (int x = 0; x < world.size.x; ++x) {
+            for (int y = 0; y < world.size.y; ++y) {
+                uint64_t energy = 0, id = 0;
+                if (world.getStorageMode() == World::StorageMode::Dense) {
+                    uint32_t slot = world.getSlotAt(x, y);
+                    if (slot != EntityStore::INVALID) {
+                        energy = world.getEntityStore().energy[slot];
+                        id = world.getEntityStore().id[slot];
+                    }
+                } else if (const Entity* entity = world.getEntityAt(x, y)) {
+                    energy = entity->energy;
+                    id = entity->id;
+                }
+                cells.push_back(world.getCellSpecies(x, y) | energy << 8);
+                cells.push_back(id);
+            }
+        }
+        return cells;
+    }
+
+    static void runTicks(World& world, const int& ticks) {
+        for (int i = 0; i < ticks; ++i) {
+            world.run();
+            if (world.drawRandom() % 3 == 0 && !world.isFull())
+                world.addEntityType('*');
+        }
+    }
+
+    void expectResumesExactly(const World::StorageMode& storage, const World::GridLayout& layout) {
+        std::unique_ptr<World> original = seeded(storage, layout);
+        runTicks(*original, 15);
+        original->saveCheckpoint(path);
+        runTicks(*original, 15);
+
+        std::unique_ptr<World> restored = World::createTestInstance(10, 10);
+        restored->loadCheckpoint(path);
+        EXPECT_EQ(restored->getStorageMode(), storage);
+        EXPECT_EQ(restored->getGridLayout(), layout);
+        EXPECT_EQ(restored->getTick(), 15u);
+        runTicks(*restored, 15);
+
+        EXPECT_EQ(restored->getOccupiedCellsCount(), original->getOccupiedCellsCount());
+        EXPECT_EQ(fingerprint(*restored), fingerprint(*original));
+    }
+
+    // Edits the saved image and stamps a valid checksum again, for files
+    // that are well formed but say something impossible
+    template <typename Edit>
+    void rewrite(Edit edit) {
+        std::vector<char> image;
+        {
+            std::ifstream in(path, std::ios::binary);
+            image.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        checkpoint::Header header;
+        std::memcpy(&header, image.data(), sizeof(header));
+        edit(header, image.data() + sizeof(header));
+        header.checksum = 0;
+        header.checksum = checkpoint::checksum(image.data() + sizeof(header), header.payloadBytes, checkpoint::checksum(&header, sizeof(header)));
+        std::memcpy(image.data(), &header, sizeof(header));
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(image.data(), image.size());
+    }
+
+    void corruptByte(const size_t& offset) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(offset);
+        char byte = 0;
+        file.read(&byte, 1);
+        byte ^= 0x10;
+        file.seekp(offset);
+        file.write(&byte, 1);
+    }
+
+    std::string path;
+};
+
+TEST_F(CheckpointTest, ObjectsResumeExactly) {
+    expectResumesExactly(World::StorageMode::Objects, World::GridLayout::Flat);
+}
+
+TEST_F(CheckpointTest, DenseResumesExactly) {
+    expectResumesExactly(World::StorageMode::Dense, World::GridLayout::Flat);
+}
+
+TEST_F(CheckpointTest, ChunkedResumesExactly) {
+    expectResumesExactly(World::StorageMode::Objects, World::GridLayout::Chunked);
+}
+
+TEST_F(CheckpointTest, SpeciesTableIsRestored) {
+    animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    registry.loadFromString(R"({"species": [{"name": "wolf", "symbol": "W", "prey": "C", "rank": 9, "energy": 77}]})");
+    std::unique_ptr<World> world = World::createTestInstance(20, 20);
+    world->setSeed(1);
+    world->addEntityType('W');
+    world->saveCheckpoint(path);
+
+    registry.reset();
+    std::unique_ptr<World> restored = World::createTestInstance(1, 1);
+    restored->loadCheckpoint(path);
+    animalconfig::SpeciesId wolf = registry.findBySymbol('W');
+    ASSERT_NE(wolf, animalconfig::NO_SPECIES);
+    EXPECT_EQ(registry.getName(wolf), "wolf");
+    EXPECT_EQ(registry.getRank(wolf), 9);
+    EXPECT_EQ(registry.get(wolf).energy, 77u);
+    EXPECT_EQ(restored->getOccupiedCellsCount(), 1u);
+}
+
+TEST_F(CheckpointTest, CorruptFilesAreRejected) {
+    std::unique_ptr<World> world = seeded(World::StorageMode::Objects, World::GridLayout::Flat);
+    world->saveCheckpoint(path);
+    std::unique_ptr<World> restored = World::createTestInstance(10, 10);
+
+    corruptByte(sizeof(checkpoint::Header) + 100);
+    EXPECT_THROW(restored->loadCheckpoint(path), std::runtime_error);
+
+    world->saveCheckpoint(path);
+    corruptByte(offsetof(checkpoint::Header, tick));
+    EXPECT_THROW(restored->loadCheckpoint(path), std::runtime_error);
+
+    world->saveCheckpoint(path);
+    corruptByte(0);
+    EXPECT_THROW(restored->loadCheckpoint(path), std::runtime_error);
+
+    {
+        std::ofstream truncated(path, std::ios::binary | std::ios::trunc);
+        truncated << "ECOSIMCK";
+    }
+    EXPECT_THROW(restored->loadCheckpoint(path), std::runtime_error);
+    EXPECT_THROW(restored->loadCheckpoint(path + ".missing"), std::runtime_error);
+
+    // Dense free slots that are out of range, still alive, or listed twice
+    std::unique_ptr<World> dense = seeded(World::StorageMode::Dense, World::GridLayout::Flat);
+    runTicks(*dense, 15);
+    const EntityStore& store = dense->getEntityStore();
+    ASSERT_GE(store.getFreeSlots().size(), 2u);
+    uint32_t live = 0;
+    while (!store.isAlive(live)) ++live;
+    const uint32_t badSlots[3][2] = {{store.getSlotCount(), 0}, {live, 0}, {UINT32_MAX, 1}};
+    for (const uint32_t* bad : badSlots) {
+        dense->saveCheckpoint(path);
+        rewrite([&](checkpoint::Header& header, char* payload) {
+            // Free then retired slots close the image
+            uint32_t* slots = reinterpret_cast<uint32_t*>(payload + header.payloadBytes
+                - checkpoint::alignUp(header.retiredSlotCount * sizeof(uint32_t))
+                - checkpoint::alignUp(header.freeSlotCount * sizeof(uint32_t)));
+            slots[bad[1]] = bad[0] == UINT32_MAX ? slots[0] : bad[0];
+        });
+        EXPECT_THROW(restored->loadCheckpoint(path), std::runtime_error);
+    }
+
+    // A rejected file leaves the world as it was
+    EXPECT_EQ(restored->size, kinematics::Vector2D(10, 10));
+}
+
+TEST_F(CheckpointTest, RejectedSpeciesTableKeepsTheRegistry) {
+    std::unique_ptr<World> world = seeded(World::StorageMode::Objects, World::GridLayout::Flat);
+    world->saveCheckpoint(path);
+    rewrite([](checkpoint::Header&, char* payload) {
+        reinterpret_cast<checkpoint::SpeciesRecord*>(payload)->symbol = 'Z';   // Plant no longer first
+    });
+
+    animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    registry.loadFromString(R"({"species": [{"name": "wolf", "symbol": "W", "prey": "C"}]})");
+    std::unique_ptr<World> restored = World::createTestInstance(10, 10);
+    EXPECT_THROW(restored->loadCheckpoint(path), std::runtime_error);
+    EXPECT_NE(registry.findBySymbol('W'), animalconfig::NO_SPECIES);
+    EXPECT_EQ(registry.findBySymbol('Z'), animalconfig::NO_SPECIES);
+    EXPECT_EQ(registry.getCount(), 4u);
+}
+
+TEST_F(CheckpointTest, TwoAgentsInOneCellAreRejected) {
+    std::unique_ptr<World> world = seeded(World::StorageMode::Objects, World::GridLayout::Flat);
+    world->saveCheckpoint(path);
+    rewrite([](checkpoint::Header& header, char* payload) {
+        const checkpoint::SpeciesRecord* species = reinterpret_cast<const checkpoint::SpeciesRecord*>(payload);
+        size_t nameBytes = 0;
+        for (uint32_t i = 0; i < header.speciesCount; ++i) {
+            nameBytes += species[i].nameBytes;
+        }
+        char* positions = payload + checkpoint::alignUp(header.speciesCount * sizeof(checkpoint::SpeciesRecord)) + checkpoint::alignUp(nameBytes);
+        int32_t* posX = reinterpret_cast<int32_t*>(positions);
+        int32_t* posY = reinterpret_cast<int32_t*>(positions + checkpoint::alignUp(header.entityCount * sizeof(int32_t)));
+        posX[1] = posX[0];
+        posY[1] = posY[0];
+    });
+
+    std::unique_ptr<World> restored = World::createTestInstance(10, 10);
+    EXPECT_THROW(restored->loadCheckpoint(path), std::runtime_error);
+    EXPECT_EQ(restored->size, kinematics::Vector2D(10, 10));
+}
+
+TEST_F(CheckpointTest, BackgroundSaveMatchesTheStateWhenCalled) {
+    std::unique_ptr<World> world = seeded(World::StorageMode::Dense, World::GridLayout::Flat);
+    runTicks(*world, 5);
+    std::vector<uint64_t> saved = fingerprint(*world);
+    world->saveCheckpointAsync(path);
+    runTicks(*world, 5);
+    world->waitForCheckpoint();
+
+    std::unique_ptr<World> restored = World::createTestInstance(1, 1);
+    restored->loadCheckpoint(path);
+    EXPECT_EQ(fingerprint(*restored), saved);
+
+    world->saveCheckpointAsync(::testing::TempDir() + "missing_directory/checkpoint.bin");
+    EXPECT_THROW(world->waitForCheckpoint(), std::runtime_error);
+}
+
+TEST(ChecksumTest, DependsOnEveryByte) {
+    std::vector<unsigned char> bytes(101);
+    for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = static_cast<unsigned char>(i * 7);
+    uint64_t base = checkpoint::checksum(bytes.data(), bytes.size());
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] ^= 1;
+        EXPECT_NE(checkpoint::checksum(bytes.data(), bytes.size()), base) << "byte " << i;
+        bytes[i] ^= 1;
+    }
+    EXPECT_NE(checkpoint::checksum(bytes.data(), bytes.size(), 1), base);
+    EXPECT_NE(checkpoint::checksum(bytes.data(), 100), base);
+}
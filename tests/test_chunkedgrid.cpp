@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <utility>
+#include "../include/ChunkedGrid.h"
+#include "../include/SpatialIndex.h"
+#include "../include/World.h"
+#include "../include/Entity.h"
+#include "../include/Rng.h"
+
+class ChunkedGridTest: public ::testing::Test {
+protected:
+    void SetUp() override {
+        world = World::createTestInstance(1, 1);
+    }
+
+    Entity* make(const animalconfig::SpeciesId& species, const int& x, const int& y) {
+        entities.emplace_back(new Entity(species, *world, kinematics::Vector2D(x, y)));
+        return entities.back().get();
+    }
+
+    std::unique_ptr<World> world;
+    std::vector<std::unique_ptr<Entity>> entities;
+};
+
+TEST_F(ChunkedGridTest, ChunksComeAndGo) {
+    ChunkedGrid grid;
+    grid.resize(1000, 1000);
+    EXPECT_EQ(grid.getChunkCount(), 0);
+
+    Entity* plant = make(1, 130, 700);
+    grid.set(130, 700, plant);
+    EXPECT_EQ(grid.getChunkCount(), 1);
+    size_t usedBytes = grid.getMemoryBytes();
+    EXPECT_EQ(grid.get(130, 700), plant);
+    EXPECT_TRUE(grid.test(130, 700));
+    EXPECT_FALSE(grid.test(130, 701));
+    EXPECT_EQ(grid.get(0, 0), nullptr);
+    EXPECT_EQ(grid.getCount(), 1);
+
+    grid.set(130, 700, nullptr);
+    EXPECT_EQ(grid.getCount(), 0);
+    EXPECT_EQ(grid.getChunkCount(), 1);     // Until collect()
+    grid.collect();
+    EXPECT_EQ(grid.getChunkCount(), 0);
+    EXPECT_LT(grid.getMemoryBytes(), usedBytes);
+}
+
+TEST_F(ChunkedGridTest, ReplacingAnOccupantKeepsTheCount) {
+    ChunkedGrid grid;
+    grid.resize(64, 64);
+    grid.set(3, 3, make(1, 3, 3));
+    Entity* herbivore = make(2, 3, 3);
+    grid.set(3, 3, herbivore);
+
+    EXPECT_EQ(grid.getCount(), 1);
+    animalconfig::SpeciesId plant = 1, herbivores = 2;
+    EXPECT_EQ(grid.findNearest(kinematics::Vector2D(3, 5), 4, &plant, 1), kinematics::Vector2D(-1, -1));
+    EXPECT_EQ(grid.findNearest(kinematics::Vector2D(3, 5), 4, &herbivores, 1), kinematics::Vector2D(3, 3));
+}
+
+TEST_F(ChunkedGridTest, FindNearestCrossesChunks) {
+    const int rows = 200, cols = 300;
+    ChunkedGrid grid;
+    grid.resize(rows, cols);
+    SpatialIndex index;
+    index.resize(rows, cols);
+
+    for (int i = 0; i < 400; ++i) {
+        uint64_t draw = rng::draw(9, 0, i, 1, 0);
+        int x = draw % rows, y = (draw >> 20) % cols;
+        animalconfig::SpeciesId species = 1 + (draw >> 40) % 3;
+        if (grid.test(x, y))
+            continue;
+        grid.set(x, y, make(species, x, y));
+        index.set(species, x, y);
+    }
+
+    const animalconfig::SpeciesId predators[2] = {2, 3};
+    // More species than a fixed-size query buffer would hold, 3 last
+    std::vector<animalconfig::SpeciesId> longList;
+    for (animalconfig::SpeciesId id = 4; id < 24; ++id) {
+        longList.push_back(id);
+    }
+    longList.push_back(3);
+    for (int i = 0; i < 2000; ++i) {
+        uint64_t draw = rng::draw(10, 0, i, 1, 0);
+        kinematics::Vector2D pos(draw % rows, (draw >> 20) % cols);
+        int range = (draw >> 40) % 12;
+        EXPECT_EQ(grid.findNearest(pos, range, predators, 2), index.findNearest(pos, range, predators, 2));
+        EXPECT_EQ(grid.findNearest(pos, range, predators, 1), index.findNearest(pos, range, predators, 1));
+        EXPECT_EQ(grid.findNearest(pos, range, longList.data(), longList.size()), index.findNearest(pos, range, &predators[1], 1));
+    }
+}
+
+TEST_F(ChunkedGridTest, ForEachSetGoesChunkByChunk) {
+    ChunkedGrid grid;
+    grid.resize(200, 200);
+    grid.set(70, 1, make(1, 70, 1));
+    grid.set(1, 70, make(2, 1, 70));
+    grid.set(2, 3, make(1, 2, 3));
+
+    std::vector<std::pair<int, int>> visited;
+    grid.forEachSet(animalconfig::NO_SPECIES, [&](int x, int y) {
+        visited.emplace_back(x, y);
+    });
+    std::vector<std::pair<int, int>> expected = {{2, 3}, {1, 70}, {70, 1}};
+    EXPECT_EQ(visited, expected);
+
+    visited.clear();
+    grid.forEachSet(1, [&](int x, int y) {
+        visited.emplace_back(x, y);
+    });
+    expected = {{2, 3}, {70, 1}};
+    EXPECT_EQ(visited, expected);
+}
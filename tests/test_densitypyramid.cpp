@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <memory>
+#include "../include/DensityPyramid.h"
+#include "../include/Snapshot.h"
+#include "../include/World.h"
+#include "../include/Rng.h"
+
+namespace {
+    // Both pyramids are current with the same cells
+    void expectSamePyramid(const DensityPyramid& a, const DensityPyramid& b, const std::vector<animalconfig::SpeciesId>& species, const std::vector<uint32_t>& energy) {
+        ASSERT_EQ(a.getLevelCount(), b.getLevelCount());
+        ASSERT_EQ(a.getSpeciesCount(), b.getSpeciesCount());
+        DensityPyramid::Block blockA, blockB;
+        for (uint32_t level = 1; level <= a.getLevelCount(); ++level) {
+            ASSERT_EQ(a.getRows(level), b.getRows(level));
+            ASSERT_EQ(a.getColumns(level), b.getColumns(level));
+            for (int x = 0; x < a.getRows(level); ++x) {
+                for (int y = 0; y < a.getColumns(level); ++y) {
+                    a.getBlock(level, x, y, species, energy, blockA);
+                    b.getBlock(level, x, y, species, energy, blockB);
+                    ASSERT_EQ(blockA.energy, blockB.energy) << "level " << level << " block " << x << "," << y;
+                    ASSERT_EQ(blockA.counts, blockB.counts) << "level " << level << " block " << x << "," << y;
+                }
+            }
+        }
+    }
+
+    DensityPyramid::Block getBlock(const DensityPyramid& pyramid, const uint32_t& level, const int& x, const int& y, const std::vector<animalconfig::SpeciesId>& species, const std::vector<uint32_t>& energy) {
+        DensityPyramid::Block block;
+        pyramid.getBlock(level, x, y, species, energy, block);
+        return block;
+    }
+}
+
+TEST(DensityPyramidTest, SumsBlocksOfEveryLevel) {
+    // 5 x 7 cells: levels of 3 x 4, 2 x 2 and 1 x 1 blocks
+    const int rows = 5, columns = 7;
+    std::vector<animalconfig::SpeciesId> species(rows * columns, animalconfig::NO_SPECIES);
+    std::vector<uint32_t> energy(rows * columns, 0);
+    auto place = [&](const int& x, const int& y, const animalconfig::SpeciesId& id, const uint32_t& amount) {
+        species[x * columns + y] = id;
+        energy[x * columns + y] = amount;
+    };
+    place(0, 0, 1, 1);
+    place(1, 1, 2, 100);
+    place(4, 6, 3, 50);
+    place(3, 5, 2, 10);
+
+    DensityPyramid pyramid;
+    pyramid.reset(rows, columns, 3);
+    pyramid.build(species, energy);
+    ASSERT_EQ(pyramid.getLevelCount(), 3u);
+    EXPECT_EQ(pyramid.getRows(1), 3);
+    EXPECT_EQ(pyramid.getColumns(1), 4);
+    EXPECT_EQ(pyramid.getRows(3), 1);
+    EXPECT_EQ(pyramid.getColumns(3), 1);
+
+    auto block = [&](const uint32_t& level, const int& x, const int& y) { return getBlock(pyramid, level, x, y, species, energy); };
+    EXPECT_EQ(block(1, 0, 0).counts, std::vector<uint32_t>({2, 1, 1, 0}));
+    EXPECT_EQ(block(1, 0, 0).energy, 101u);
+    EXPECT_EQ(block(1, 2, 3).counts[3], 1u);
+    EXPECT_EQ(block(2, 0, 1).counts[2], 1u);
+    EXPECT_EQ(block(2, 0, 1).energy, 10u);
+    EXPECT_EQ(block(2, 1, 1).counts[animalconfig::NO_SPECIES], 1u);
+    EXPECT_EQ(block(2, 1, 1).energy, 50u);
+    EXPECT_EQ(block(3, 0, 0).counts[2], 2u);
+    EXPECT_EQ(block(3, 0, 0).energy, 161u);
+
+    // Blocks on the far edges cover fewer cells
+    EXPECT_EQ(pyramid.getArea(1, 0, 0), 4u);
+    EXPECT_EQ(pyramid.getArea(1, 2, 3), 1u);
+    EXPECT_EQ(pyramid.getArea(2, 1, 0), 4u);
+    EXPECT_EQ(pyramid.getArea(3, 0, 0), 35u);
+}
+
+TEST(DensityPyramidTest, ApplyMatchesARebuild) {
+    const int rows = 37, columns = 21;
+    std::vector<animalconfig::SpeciesId> species(rows * columns, animalconfig::NO_SPECIES);
+    std::vector<uint32_t> energy(rows * columns, 0);
+    DensityPyramid patched;
+    patched.reset(rows, columns, 4);
+
+    for (uint64_t step = 0; step < 5000; ++step) {
+        const uint32_t cellId = rng::mix(step) % species.size();
+        const int x = cellId / columns, y = cellId % columns;
+        patched.apply(x, y, species[cellId], energy[cellId], -1);
+        species[cellId] = rng::mix(step + 1000000) % 5;
+        energy[cellId] = species[cellId] == animalconfig::NO_SPECIES ? 0 : rng::mix(step + 2000000) % 300;
+        patched.apply(x, y, species[cellId], energy[cellId], 1);
+    }
+
+    DensityPyramid built;
+    built.reset(rows, columns, 4);
+    built.build(species, energy);
+    expectSamePyramid(patched, built, species, energy);
+}
+
+TEST(DensityPyramidTest, SnapshotPatchesKeepItCurrent) {
+    for (const World::StorageMode& mode : {World::StorageMode::Objects, World::StorageMode::Dense}) {
+        std::unique_ptr<World> world = World::createTestInstance(45, 33);
+        world->setStorageMode(mode);
+        world->setSeed(8);
+        world->setChangeTracking(true);
+        for (int i = 0; i < 300; ++i) world->addEntityType('*');
+        for (int i = 0; i < 120; ++i) world->addEntityType('H');
+        for (int i = 0; i < 15; ++i) world->addEntityType('C');
+
+        WorldSnapshot patched;
+        std::vector<uint32_t> changed;
+        for (int tick = 0; tick < 20; ++tick) {
+            world->updateSnapshot(patched, world->takeChangedCells(changed) ? &changed : nullptr);
+            WorldSnapshot full;
+            world->updateSnapshot(full);
+            ASSERT_EQ(patched.species, full.species);
+            ASSERT_EQ(patched.energy, full.energy);
+            expectSamePyramid(patched.density, full.density, full.species, full.energy);
+            const uint32_t top = full.density.getLevelCount();
+            EXPECT_EQ(getBlock(full.density, top, 0, 0, full.species, full.energy).counts[animalconfig::NO_SPECIES], world->getOccupiedCellsCount());
+            world->run();
+        }
+    }
+}
+
+TEST(DensityPyramidTest, CountsPastSixteenBits) {
+    // Level 8 blocks hold 65536 cells, one more than 16-bit counters can count
+    const int side = 300;
+    std::vector<animalconfig::SpeciesId> species(side * side, 1);
+    std::vector<uint32_t> energy(side * side, 7);
+    DensityPyramid pyramid;
+    pyramid.reset(side, side, 1);
+    pyramid.build(species, energy);
+    ASSERT_EQ(pyramid.getLevelCount(), 9u);
+    EXPECT_EQ(getBlock(pyramid, 7, 0, 0, species, energy).counts, std::vector<uint32_t>({16384, 16384}));
+    EXPECT_EQ(getBlock(pyramid, 8, 0, 0, species, energy).counts, std::vector<uint32_t>({65536, 65536}));
+    EXPECT_EQ(getBlock(pyramid, 9, 0, 0, species, energy).counts[0], 90000u);
+    EXPECT_EQ(getBlock(pyramid, 9, 0, 0, species, energy).energy, 630000u);
+
+    pyramid.apply(299, 299, 1, 7, -1);
+    species[side * side - 1] = animalconfig::NO_SPECIES;
+    energy[side * side - 1] = 0;
+    DensityPyramid built;
+    built.reset(side, side, 1);
+    built.build(species, energy);
+    expectSamePyramid(pyramid, built, species, energy);
+}
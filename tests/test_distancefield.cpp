@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include "../include/DistanceField.h"
+#include "../include/Rng.h"
+
+TEST(DistanceFieldTest, NoSourcesIsFarEverywhere) {
+    SpatialIndex index;
+    index.resize(6, 9);
+    animalconfig::SpeciesId species = 1;
+    DistanceField field;
+    field.build(index, &species, 1, 5, nullptr);
+
+    EXPECT_EQ(field.getDistance(0), DistanceField::FAR);
+    EXPECT_EQ(field.getStep(6 * 9 - 1), DistanceField::NO_STEP);
+    EXPECT_FALSE(field.reaches(20, 200));
+}
+
+TEST(DistanceFieldTest, StepsLeadToTheSource) {
+    SpatialIndex index;
+    index.resize(5, 5);
+    index.set(2, 2, 2);
+    animalconfig::SpeciesId species = 2;
+    DistanceField field;
+    field.build(index, &species, 1, 3, nullptr);
+
+    EXPECT_EQ(field.getDistance(2 * 5 + 2), 0);
+    EXPECT_EQ(field.getStep(2 * 5 + 2), DistanceField::NO_STEP);
+    EXPECT_EQ(field.getDistance(0), DistanceField::FAR);   // 4 steps away
+    EXPECT_EQ(field.getDistance(1), 3);
+    EXPECT_EQ(field.getStep(1), 2);                         // Right comes before down
+    EXPECT_EQ(field.getStep(4 * 5 + 2), 0);                 // Up
+    EXPECT_TRUE(field.reaches(2 * 5 + 4, 2));
+    EXPECT_FALSE(field.reaches(2 * 5 + 4, 1));
+}
+
+TEST(DistanceFieldTest, MatchesManhattanDistanceToNearestSource) {
+    const int rows = 40, cols = 150;
+    SpatialIndex index;
+    index.resize(rows, cols);
+    std::vector<kinematics::Vector2D> sources;
+    for (int i = 0; i < 60; ++i) {
+        uint64_t draw = rng::draw(5, 0, i, 1, 0);
+        kinematics::Vector2D pos(draw % rows, (draw >> 20) % cols);
+        index.set(1 + i % 2, pos.x, pos.y);
+        index.set(3, pos.x, (pos.y + 1) % cols);   // Not asked for
+        sources.push_back(pos);
+    }
+
+    WorkerPool workers(3);
+    const animalconfig::SpeciesId species[2] = {1, 2};
+    const uint32_t radius = 9;
+    DistanceField field;
+    field.build(index, species, 2, radius, &workers);
+
+    const int stepX[4] = {-1, 0, 0, 1};
+    const int stepY[4] = {0, -1, 1, 0};
+    for (int x = 0; x < rows; ++x) {
+        for (int y = 0; y < cols; ++y) {
+            uint32_t expected = UINT32_MAX;
+            for (const kinematics::Vector2D& source : sources) {
+                expected = std::min<uint32_t>(expected, abs(source.x - x) + abs(source.y - y));
+            }
+            const uint32_t cellId = x * cols + y;
+            if (expected > radius) {
+                EXPECT_EQ(field.getDistance(cellId), DistanceField::FAR);
+                continue;
+            }
+            ASSERT_EQ(field.getDistance(cellId), expected) << x << "," << y;
+            if (expected > 0) {
+                uint8_t step = field.getStep(cellId);
+                ASSERT_LT(step, 4);
+                EXPECT_EQ(field.getDistance((x + stepX[step]) * cols + y + stepY[step]), expected - 1);
+            }
+        }
+    }
+}
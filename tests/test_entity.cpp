@@ -51,7 +51,7 @@ public:
 
 TEST_F(EntityTest, EntityInitialization) {
     Entity entity(animalconfig::HERBIVORE_CONFIG, *testWorld, 0, 0, 1, 1);
-    EXPECT_EQ(entity.entityConfig.symbol, 'H');
+    EXPECT_EQ(entity.getSymbol(), 'H');
     EXPECT_EQ(entity.getPosition().x, 0);
     EXPECT_EQ(entity.getPosition().y, 0);
     EXPECT_EQ(entity.getVelocity().x, 1);
@@ -195,10 +195,10 @@ TEST_F(EntityTest, EntityFeeding) {
 
     testWorld->addEntity(predator);
     testWorld->addEntity(prey);
-    uint32_t initialEnergy = predator->entityConfig.energy;
+    uint32_t initialEnergy = predator->energy;
     predator->feed(prey);
 
-    EXPECT_GT(predator->entityConfig.energy, initialEnergy);
+    EXPECT_GT(predator->energy, initialEnergy);
     runBoundaryTest(*predator);
 
     delete predator;
@@ -212,10 +212,10 @@ TEST_F(EntityTest, CannotEntityFeeding) {
 
     testWorld->addEntity(predator);
     testWorld->addEntity(prey);
-    uint32_t initialEnergy = predator->entityConfig.energy;
+    uint32_t initialEnergy = predator->energy;
     predator->feed(prey);
 
-    EXPECT_EQ(predator->entityConfig.energy, initialEnergy);
+    EXPECT_EQ(predator->energy, initialEnergy);
     runBoundaryTest(*predator);
 
     delete predator;
@@ -229,7 +229,7 @@ TEST_F(EntityTest, NOEntityFeeding) {
 
         testWorld->addEntity(predator);
         testWorld->addEntity(prey);
-        uint32_t initialEnergy = predator->entityConfig.energy;
+        uint32_t initialEnergy = predator->energy;
         predator->feed(prey);
 
         delete predator;
@@ -247,7 +247,7 @@ TEST_F(EntityTest, NOEntityFeeding) {
 
 TEST_F(EntityTest, EntityReproduction) {
     Entity entity(animalconfig::HERBIVORE_CONFIG, *testWorld, 0, 0);
-    entity.entityConfig.energy = entity.entityConfig.reproductionThreshold;
+    entity.energy = entity.getConfig().reproductionThreshold;
     testWorld->addEntity(&entity);
 
     bool reproduced = entity.reproduce();
@@ -281,11 +281,11 @@ TEST_F(EntityTest, EntityFindNearestPredator) {
 
 TEST_F(EntityTest, EntityTickEnergy) {
     Entity entity(animalconfig::HERBIVORE_CONFIG, *testWorld, 0, 0);
-    uint32_t initialEnergy = entity.entityConfig.energy;
+    uint32_t initialEnergy = entity.energy;
 
     testWorld->addEntity(&entity);
 
     entity.tickEnergy();
-    EXPECT_LT(entity.entityConfig.energy, initialEnergy);
+    EXPECT_LT(entity.energy, initialEnergy);
     runBoundaryTest(entity);
 }
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include "../include/EntityStore.h"
+
+TEST(EntityStoreTest, AddEntity) {
+    EntityStore store;
+    uint32_t index = store.add(2, 3, 4, 100);
+
+    EXPECT_EQ(index, 0);
+    EXPECT_TRUE(store.isAlive(index));
+    EXPECT_EQ(store.posX[index], 3);
+    EXPECT_EQ(store.posY[index], 4);
+    EXPECT_EQ(store.energy[index], 100);
+    EXPECT_EQ(store.species[index], 2);
+    EXPECT_EQ(store.getLiveCount(), 1);
+}
+
+TEST(EntityStoreTest, RemovedSlotsWaitForRecycle) {
+    EntityStore store;
+    uint32_t first = store.add(1, 0, 0, 1);
+    store.remove(first);
+
+    EXPECT_FALSE(store.isAlive(first));
+    EXPECT_EQ(store.getLiveCount(), 0);
+
+    // Not reused until recycle()
+    uint32_t second = store.add(1, 1, 1, 1);
+    EXPECT_NE(second, first);
+
+    store.recycle();
+    uint32_t third = store.add(3, 2, 2, 5);
+    EXPECT_EQ(third, first);
+    EXPECT_EQ(store.species[third], 3);
+    EXPECT_EQ(store.getSlotCount(), 2);
+}
+
+TEST(EntityStoreTest, IndicesAreStable) {
+    EntityStore store;
+    uint32_t a = store.add(1, 0, 0, 1);
+    uint32_t b = store.add(2, 5, 5, 7);
+    store.remove(a);
+    store.recycle();
+    store.add(3, 9, 9, 1);
+
+    EXPECT_EQ(store.posX[b], 5);
+    EXPECT_EQ(store.energy[b], 7);
+}
+
+TEST(EntityStoreTest, Clear) {
+    EntityStore store;
+    store.add(1, 0, 0, 1);
+    store.add(1, 0, 1, 1);
+    store.clear();
+
+    EXPECT_EQ(store.getSlotCount(), 0);
+    EXPECT_EQ(store.getLiveCount(), 0);
+}
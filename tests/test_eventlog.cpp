@@ -0,0 +1,264 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <utility>
+#include <stdexcept>
+#include "../include/EventLog.h"
+#include "../include/World.h"
+#include "../include/Entity.h"
+#include "../include/Rng.h"
+
+class EventLogTest: public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "ecosim_eventlog_test.bin";
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    static EventLog::Event makeEvent(const uint64_t& key) {
+        uint64_t bits = rng::mix(key);
+        EventLog::Event event;
+        event.type = static_cast<EventLog::Type>(bits & 3);
+        event.x = static_cast<int32_t>(bits >> 8 & 1023);
+        event.y = static_cast<int32_t>(bits >> 20 & 1023);
+        event.entity = rng::mix(bits);
+        event.other = event.type == EventLog::Type::Kill || event.type == EventLog::Type::Birth ? bits : 0;
+        event.species = 1 + (bits >> 2 & 3);
+        event.dx = event.type == EventLog::Type::Starve ? 0 : static_cast<int8_t>((bits >> 4 & 1) ? 1 : -1);
+        event.dy = 0;
+        return event;
+    }
+
+    static void expectSame(const EventLog::Event& a, const EventLog::Event& b) {
+        EXPECT_EQ(a.type, b.type);
+        EXPECT_EQ(a.x, b.x);
+        EXPECT_EQ(a.y, b.y);
+        EXPECT_EQ(a.dx, b.dx);
+        EXPECT_EQ(a.dy, b.dy);
+        EXPECT_EQ(a.entity, b.entity);
+        EXPECT_EQ(a.other, b.other);
+        EXPECT_EQ(a.species, b.species);
+    }
+
+    // Ticks 10..(10 + ticks) with `perTick` events each, written from two buffers per tick
+    void writeSynthetic(const uint32_t& ticks, const uint32_t& perTick) {
+        EventLog log(path);
+        std::vector<EventLog::Event> first, second;
+        for (uint64_t tick = 10; tick < 10 + ticks; ++tick) {
+            for (uint32_t i = 0; i < perTick; ++i) {
+                (i % 2 == 0 ? first : second).push_back(makeEvent(tick * perTick + i));
+            }
+            log.append(first);
+            log.append(second);
+            EXPECT_TRUE(first.empty());
+            EXPECT_TRUE(second.empty());
+            log.endTick(tick);
+        }
+        log.close();
+        EXPECT_EQ(log.getEventCount(), static_cast<uint64_t>(ticks) * perTick);
+    }
+
+    // Births add agents; kills and starvation remove them
+    static int64_t populationChange(const std::vector<EventLogReader::Record>& records) {
+        int64_t change = 0;
+        for (const EventLogReader::Record& record : records) {
+            const EventLog::Event& event = record.event;
+            EXPECT_LE(std::abs(event.dx) + std::abs(event.dy), 1);
+            switch (event.type) {
+                case EventLog::Type::Birth: ++change; break;
+                case EventLog::Type::Kill:
+                case EventLog::Type::Starve: --change; break;
+                case EventLog::Type::Move: EXPECT_EQ(std::abs(event.dx) + std::abs(event.dy), 1); break;
+            }
+        }
+        return change;
+    }
+
+    typedef std::map<std::pair<int32_t, int32_t>, uint64_t> Occupants;
+
+    // Id of the agent in every occupied cell
+    static Occupants getOccupants(const World& world) {
+        Occupants occupants;
+        for (int x = 0; x < world.size.x; ++x) {
+            for (int y = 0; y < world.size.y; ++y) {
+                if (world.getStorageMode() == World::StorageMode::Dense) {
+                    const uint32_t slot = world.getSlotAt(x, y);
+                    if (slot != EntityStore::INVALID)
+                        occupants[{x, y}] = world.getEntityStore().id[slot];
+                } else if (const Entity* entity = world.getEntityAt(x, y)) {
+                    occupants[{x, y}] = entity->id;
+                }
+            }
+        }
+        return occupants;
+    }
+
+    // Plays the events back onto `occupants`; every event must find its
+    // agents where the events before it left them
+    static void replay(Occupants& occupants, const std::vector<EventLogReader::Record>& records) {
+        for (const EventLogReader::Record& record : records) {
+            const EventLog::Event& event = record.event;
+            const std::pair<int32_t, int32_t> at(event.x, event.y), to(event.x + event.dx, event.y + event.dy);
+            Occupants::iterator actor = occupants.find(at);
+            ASSERT_TRUE(actor != occupants.end() && actor->second == event.entity) << "tick " << record.tick;
+            switch (event.type) {
+                case EventLog::Type::Move:
+                    ASSERT_EQ(occupants.count(to), 0u) << "tick " << record.tick;
+                    occupants.erase(actor);
+                    occupants[to] = event.entity;
+                    break;
+                case EventLog::Type::Kill: {
+                    Occupants::iterator victim = occupants.find(to);
+                    ASSERT_TRUE(victim != occupants.end() && victim->second == event.other) << "tick " << record.tick;
+                    occupants.erase(victim);
+                    break;
+                }
+                case EventLog::Type::Birth:
+                    ASSERT_EQ(occupants.count(to), 0u) << "tick " << record.tick;
+                    occupants[to] = event.other;
+                    break;
+                case EventLog::Type::Starve:
+                    occupants.erase(actor);
+                    break;
+            }
+        }
+    }
+
+    std::vector<EventLogReader::Record> expectLogMatchesRun(World& world, const uint32_t& ticks = 40) {
+        world.setSeed(9);
+        for (int i = 0; i < 300; ++i) world.addEntityType('*');
+        for (int i = 0; i < 150; ++i) world.addEntityType('H');
+        for (int i = 0; i < 20; ++i) world.addEntityType('C');
+        const int64_t seeded = world.getOccupiedCellsCount();
+        Occupants occupants = getOccupants(world);
+
+        world.startEventLog(path);
+        for (uint32_t i = 0; i < ticks; ++i) world.run();
+        const int64_t final = world.getOccupiedCellsCount();
+        const uint64_t events = world.stopEventLog();
+        EXPECT_EQ(world.getEventLog(), nullptr);
+
+        EventLogReader reader(path);
+        std::vector<EventLogReader::Record> records = reader.read(0, ticks + 1000);
+        EXPECT_EQ(records.size(), events);
+        EXPECT_GT(records.size(), 0u);
+        EXPECT_EQ(reader.getLastTick(), ticks - 1);
+        EXPECT_EQ(seeded + populationChange(records), final);
+
+        // The recorded order is one the run could have happened in
+        replay(occupants, records);
+        EXPECT_EQ(occupants, getOccupants(world));
+        return records;
+    }
+
+    static void expectSameLog(const std::vector<EventLogReader::Record>& a, const std::vector<EventLogReader::Record>& b) {
+        ASSERT_EQ(a.size(), b.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            EXPECT_EQ(a[i].tick, b[i].tick);
+            expectSame(a[i].event, b[i].event);
+        }
+    }
+
+    std::string path;
+};
+
+TEST_F(EventLogTest, RoundTripsAcrossChunks) {
+    writeSynthetic(300, 2000);
+
+    EventLogReader reader(path);
+    EXPECT_TRUE(reader.hasIndex());
+    EXPECT_GT(reader.getChunkCount(), 2u);
+    EXPECT_EQ(reader.getFirstTick(), 10u);
+    EXPECT_EQ(reader.getLastTick(), 309u);
+
+    std::vector<EventLogReader::Record> records = reader.read(150, 152);
+    ASSERT_EQ(records.size(), 4000u);
+    for (uint32_t i = 0; i < records.size(); ++i) {
+        const uint64_t tick = 150 + i / 2000;
+        const uint32_t index = i % 2000;
+        // Each tick holds the first buffer's events, then the second's
+        const uint32_t original = index < 1000 ? index * 2 : (index - 1000) * 2 + 1;
+        EXPECT_EQ(records[i].tick, tick);
+        expectSame(records[i].event, makeEvent(tick * 2000 + original));
+    }
+    EXPECT_EQ(reader.read(0, 10).size(), 0u);
+    EXPECT_EQ(reader.read(0, 1000).size(), 600000u);
+}
+
+TEST_F(EventLogTest, ReadsLogsWithoutAFooter) {
+    writeSynthetic(200, 2000);
+    std::vector<char> bytes;
+    {
+        std::ifstream file(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    EventLogReader complete(path);
+    const size_t chunks = complete.getChunkCount();
+    {
+        // Drop the footer and half of the index
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), bytes.size() - sizeof(EventLog::Footer) - 12);
+    }
+
+    EventLogReader reader(path);
+    EXPECT_FALSE(reader.hasIndex());
+    EXPECT_EQ(reader.getChunkCount(), chunks);
+    EXPECT_EQ(reader.read(0, 1000).size(), 400000u);
+}
+
+TEST_F(EventLogTest, RejectsOtherFiles) {
+    EXPECT_THROW(EventLogReader(path + ".missing"), std::runtime_error);
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "not an event log at all";
+    }
+    EXPECT_THROW(EventLogReader reader(path), std::runtime_error);
+    EXPECT_THROW(EventLog(::testing::TempDir() + "missing_directory/events.bin"), std::runtime_error);
+}
+
+TEST_F(EventLogTest, RecordsSweepTicks) {
+    std::unique_ptr<World> world = World::createTestInstance(40, 50);
+    expectLogMatchesRun(*world);
+}
+
+TEST_F(EventLogTest, RecordsDenseStripedTicks) {
+    std::unique_ptr<World> world = World::createTestInstance(40, 50);
+    world->setStorageMode(World::StorageMode::Dense);
+    world->setThreadCount(3);
+    const std::vector<EventLogReader::Record> striped = expectLogMatchesRun(*world);
+
+    // Same log, event for event, on one thread
+    std::unique_ptr<World> serial = World::createTestInstance(40, 50);
+    serial->setStorageMode(World::StorageMode::Dense);
+    expectSameLog(expectLogMatchesRun(*serial), striped);
+}
+
+TEST_F(EventLogTest, RecordsIntentTicks) {
+    std::unique_ptr<World> world = World::createTestInstance(40, 50);
+    world->setTickEngine(World::TickEngine::Intent);
+    expectLogMatchesRun(*world);
+}
+
+TEST_F(EventLogTest, IntentLogIndependentOfThreadCount) {
+    // Long enough for unfed carnivores to starve
+    std::unique_ptr<World> world = World::createTestInstance(40, 50);
+    world->setTickEngine(World::TickEngine::Intent);
+    world->setThreadCount(4);
+    const std::vector<EventLogReader::Record> parallel = expectLogMatchesRun(*world, 90);
+    size_t starved = 0;
+    for (const EventLogReader::Record& record : parallel) {
+        starved += record.event.type == EventLog::Type::Starve;
+    }
+    EXPECT_GT(starved, 1u);
+
+    std::unique_ptr<World> serial = World::createTestInstance(40, 50);
+    serial->setTickEngine(World::TickEngine::Intent);
+    expectSameLog(expectLogMatchesRun(*serial, 90), parallel);
+}
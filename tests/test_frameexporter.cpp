@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <stdexcept>
+#include "../include/FrameExporter.h"
+#include "../include/Palette.h"
+#include "../include/World.h"
+
+#ifdef ECOSIM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+class FrameExporterTest: public ::testing::Test {
+protected:
+    void TearDown() override {
+        for (const std::string& path : written) {
+            std::remove(path.c_str());
+        }
+    }
+
+    static std::vector<uint8_t> readFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    static uint32_t get32(const std::vector<uint8_t>& bytes, const size_t& at) {
+        return static_cast<uint32_t>(bytes[at]) << 24 | bytes[at + 1] << 16 | bytes[at + 2] << 8 | bytes[at + 3];
+    }
+
+    // Pixels of a PNG written by writePng, checking its structure on the way
+    static std::vector<uint8_t> decodePng(const std::vector<uint8_t>& png, uint32_t& width, uint32_t& height, size_t* idatChunks = nullptr) {
+        EXPECT_EQ(png[1], 'P');
+        size_t at = 8;
+        if (idatChunks)
+            *idatChunks = 0;
+        std::vector<uint8_t> stream;
+        while (at + 12 <= png.size()) {
+            const uint32_t length = get32(png, at);
+            const std::string type(png.begin() + at + 4, png.begin() + at + 8);
+            if (type == "IHDR") {
+                width = get32(png, at + 8);
+                height = get32(png, at + 12);
+            } else if (type == "IDAT") {
+                stream.insert(stream.end(), png.begin() + at + 8, png.begin() + at + 8 + length);
+                if (idatChunks)
+                    ++*idatChunks;
+            }
+            at += 12 + length;
+        }
+        EXPECT_EQ(at, png.size());
+
+        const size_t stride = width * 3 + 1;
+        std::vector<uint8_t> raw(stride * height);
+#ifdef ECOSIM_HAVE_ZLIB
+        uLongf size = raw.size();
+        EXPECT_EQ(uncompress(raw.data(), &size, stream.data(), stream.size()), Z_OK);
+        EXPECT_EQ(size, raw.size());
+#else
+        // Stored blocks: a 5-byte header before each
+        size_t in = 2, out = 0;
+        while (out < raw.size()) {
+            const size_t length = stream[in + 1] | stream[in + 2] << 8;
+            std::copy(stream.begin() + in + 5, stream.begin() + in + 5 + length, raw.begin() + out);
+            in += 5 + length;
+            out += length;
+        }
+#endif
+        std::vector<uint8_t> rgb;
+        for (uint32_t y = 0; y < height; ++y) {
+            EXPECT_EQ(raw[y * stride], 0);
+            rgb.insert(rgb.end(), raw.begin() + y * stride + 1, raw.begin() + (y + 1) * stride);
+        }
+        return rgb;
+    }
+
+    std::vector<std::string> written;
+};
+
+TEST_F(FrameExporterTest, RasterisesCells) {
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    WorldSnapshot snapshot;
+    snapshot.rows = 2;
+    snapshot.columns = 3;
+    snapshot.species = {registry.findBySymbol('*'), animalconfig::NO_SPECIES, registry.findBySymbol('H'),
+                        animalconfig::NO_SPECIES, registry.findBySymbol('C'), registry.findBySymbol('H')};
+    snapshot.energy = {1, 0, 150, 0, 120, 10};
+
+    std::vector<uint8_t> rgb;
+    FrameExporter::rasterise(snapshot, 3, rgb);
+    ASSERT_EQ(rgb.size(), 9u * 6u * 3u);
+    for (int x = 0; x < 6; ++x) {
+        for (int y = 0; y < 9; ++y) {
+            const uint32_t cellId = snapshot.getCellId(x / 3, y / 3);
+            uint8_t expected[3];
+            palette::getCellColor(snapshot.species[cellId], snapshot.energy[cellId], expected);
+            for (int channel = 0; channel < 3; ++channel) {
+                EXPECT_EQ(rgb[(x * 9 + y) * 3 + channel], expected[channel]);
+            }
+        }
+    }
+
+    uint8_t empty[3], plant[3], healthy[3], weak[3];
+    palette::getCellColor(animalconfig::NO_SPECIES, 0, empty);
+    palette::getCellColor(snapshot.species[0], 1, plant);
+    palette::getCellColor(snapshot.species[2], 150, healthy);
+    palette::getCellColor(snapshot.species[2], 10, weak);
+    EXPECT_NE(std::vector<uint8_t>(empty, empty + 3), std::vector<uint8_t>(plant, plant + 3));
+    // Plants never fade; weak animals do
+    EXPECT_GT(plant[1], plant[0]);
+    EXPECT_LT(weak[1], healthy[1]);
+}
+
+TEST_F(FrameExporterTest, WritesImageFiles) {
+    std::vector<uint8_t> rgb(200 * 150 * 3);
+    for (size_t i = 0; i < rgb.size(); ++i) rgb[i] = static_cast<uint8_t>(i * 7 / 3);
+
+    const std::string png = ::testing::TempDir() + "ecosim_frame_test.png";
+    const std::string ppm = ::testing::TempDir() + "ecosim_frame_test.ppm";
+    written = {png, ppm};
+    FrameExporter::writePng(png, 200, 150, rgb);
+    FrameExporter::writePpm(ppm, 200, 150, rgb);
+
+    uint32_t width = 0, height = 0;
+    EXPECT_EQ(decodePng(readFile(png), width, height), rgb);
+    EXPECT_EQ(width, 200u);
+    EXPECT_EQ(height, 150u);
+
+    const std::vector<uint8_t> bytes = readFile(ppm);
+    const std::string header = "P6\n200 150\n255\n";
+    ASSERT_EQ(bytes.size(), header.size() + rgb.size());
+    EXPECT_EQ(std::string(bytes.begin(), bytes.begin() + header.size()), header);
+    EXPECT_TRUE(std::equal(rgb.begin(), rgb.end(), bytes.begin() + header.size()));
+
+    EXPECT_THROW(FrameExporter::writePpm(::testing::TempDir() + "missing_directory/frame.ppm", 2, 2, std::vector<uint8_t>(12)), std::runtime_error);
+}
+
+TEST_F(FrameExporterTest, SplitsImageDataAcrossChunks) {
+    std::vector<uint8_t> rgb(120 * 90 * 3);
+    for (size_t i = 0; i < rgb.size(); ++i) rgb[i] = static_cast<uint8_t>(i * 13 / 5);
+
+    const std::string png = ::testing::TempDir() + "ecosim_frame_chunks_test.png";
+    written = {png};
+    FrameExporter::writePng(png, 120, 90, rgb, 1000);
+
+    uint32_t width = 0, height = 0;
+    size_t chunks = 0;
+    const std::vector<uint8_t> bytes = readFile(png);
+    EXPECT_EQ(decodePng(bytes, width, height, &chunks), rgb);
+    EXPECT_GT(chunks, 1u);
+    for (size_t at = 8; at + 12 <= bytes.size(); at += 12 + get32(bytes, at)) {
+        EXPECT_LE(get32(bytes, at), 1000u);
+    }
+
+    EXPECT_THROW(FrameExporter::writePng(png, 120, 90, rgb, 0), std::runtime_error);
+}
+
+TEST_F(FrameExporterTest, ExportsEveryKthTick) {
+    std::unique_ptr<World> world = World::createTestInstance(20, 30);
+    world->setSeed(2);
+    for (int i = 0; i < 100; ++i) world->addEntityType('*');
+    for (int i = 0; i < 40; ++i) world->addEntityType('H');
+
+    FrameExporter::Options options;
+    options.directory = ::testing::TempDir();
+    options.prefix = "ecosim_export_test";
+    options.every = 3;
+    options.cellPixels = 2;
+    options.encoders = 2;
+    std::vector<WorldSnapshot> expected;
+    {
+        FrameExporter exporter(options);
+        for (int tick = 0; tick < 10; ++tick) {
+            world->run();
+            exporter.capture(*world);
+            if (tick % 3 == 0) {
+                expected.emplace_back();
+                world->updateSnapshot(expected.back());
+            }
+        }
+        exporter.close();
+        EXPECT_EQ(exporter.getFramesQueued(), 4u);
+        EXPECT_EQ(exporter.getFramesWritten(), 4u);
+        EXPECT_THROW(exporter.capture(*world), std::runtime_error);
+        for (uint64_t frame = 0; frame < 5; ++frame) written.push_back(exporter.getFramePath(frame));
+    }
+    EXPECT_EQ(written[0], ::testing::TempDir() + "ecosim_export_test_000000.png");
+
+    for (size_t frame = 0; frame < expected.size(); ++frame) {
+        uint32_t width = 0, height = 0;
+        std::vector<uint8_t> rgb;
+        FrameExporter::rasterise(expected[frame], 2, rgb);
+        EXPECT_EQ(decodePng(readFile(written[frame]), width, height), rgb) << "frame " << frame;
+        EXPECT_EQ(width, 60u);
+        EXPECT_EQ(height, 40u);
+    }
+    EXPECT_FALSE(std::ifstream(written[4]).good());
+}
+
+TEST_F(FrameExporterTest, ReportsWriteErrors) {
+    FrameExporter::Options options;
+    options.every = 0;
+    EXPECT_THROW(FrameExporter exporter(options), std::runtime_error);
+
+    std::unique_ptr<World> world = World::createTestInstance(10, 10);
+    options.every = 1;
+    options.directory = ::testing::TempDir() + "missing_directory";
+    FrameExporter exporter(options);
+    exporter.capture(*world);
+
+    // Wider than a PNG may be, at the default 4 pixels a cell
+    WorldSnapshot wide;
+    wide.rows = 1;
+    wide.columns = 600000000;
+    EXPECT_THROW(exporter.capture(wide), std::runtime_error);
+    EXPECT_EQ(exporter.getFramesQueued(), 1u);
+    EXPECT_THROW(exporter.close(), std::runtime_error);
+}
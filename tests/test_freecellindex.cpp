@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <set>
+#include "../include/OccupancyGrid.h"
+#include "../include/Rng.h"
+
+namespace {
+    // Free cells in the order select() counts them: blocks row-major, then cells row-major
+    std::vector<uint64_t> freeCellsInBlockOrder(const OccupancyGrid& grid) {
+        std::vector<uint64_t> cells;
+        const uint32_t size = FreeCellIndex::BLOCK_SIZE;
+        for (uint32_t blockRow = 0; blockRow < grid.getRows(); blockRow += size) {
+            for (uint32_t blockCol = 0; blockCol < grid.getCols(); blockCol += size) {
+                for (uint32_t row = blockRow; row < std::min(grid.getRows(), blockRow + size); ++row) {
+                    for (uint32_t col = blockCol; col < std::min(grid.getCols(), blockCol + size); ++col) {
+                        if (!grid.test(row, col))
+                            cells.push_back(static_cast<uint64_t>(row) * grid.getCols() + col);
+                    }
+                }
+            }
+        }
+        return cells;
+    }
+
+    void scatter(OccupancyGrid& grid, const uint64_t& seed, const uint32_t& count) {
+        for (uint32_t i = 0; i < count; ++i) {
+            uint64_t draw = rng::draw(seed, 0, i, 0, 0);
+            uint32_t row = draw % grid.getRows(), col = (draw >> 24) % grid.getCols();
+            if ((draw >> 48) & 3) {
+                grid.set(row, col);
+            } else {
+                grid.reset(row, col);
+            }
+        }
+    }
+}
+
+TEST(FreeCellIndexTest, EmptyGridCountsEveryCell) {
+    OccupancyGrid grid;
+    grid.resize(130, 70);
+    EXPECT_EQ(grid.getFreeCount(), 130u * 70u);
+    EXPECT_EQ(grid.findFree(0), 0u);
+    // The second block of the first block row starts at column 64
+    EXPECT_EQ(grid.findFree(64 * 64), 64u);
+}
+
+TEST(FreeCellIndexTest, SelectMatchesBruteForce) {
+    OccupancyGrid grid;
+    grid.resize(150, 203);
+    scatter(grid, 3, 20000);
+
+    std::vector<uint64_t> expected = freeCellsInBlockOrder(grid);
+    ASSERT_EQ(grid.getFreeCount(), expected.size());
+    ASSERT_EQ(grid.getFreeCount(), 150u * 203u - grid.getCount());
+    for (uint64_t rank = 0; rank < expected.size(); ++rank) {
+        ASSERT_EQ(grid.findFree(rank), expected[rank]) << "rank " << rank;
+    }
+}
+
+TEST(FreeCellIndexTest, ResumeRebuildsTheCounts) {
+    OccupancyGrid tracked, paused;
+    tracked.resize(100, 100);
+    paused.resize(100, 100);
+
+    paused.pauseCount();
+    scatter(tracked, 5, 8000);
+    scatter(paused, 5, 8000);
+    paused.resumeCount();
+
+    ASSERT_EQ(paused.getFreeCount(), tracked.getFreeCount());
+    for (uint64_t rank = 0; rank < tracked.getFreeCount(); rank += 7) {
+        EXPECT_EQ(paused.findFree(rank), tracked.findFree(rank));
+    }
+}
+
+TEST(FreeCellIndexTest, NearlyFullGrid) {
+    OccupancyGrid grid;
+    grid.resize(65, 65);
+    for (uint32_t row = 0; row < 65; ++row) {
+        for (uint32_t col = 0; col < 65; ++col) {
+            grid.set(row, col);
+        }
+    }
+    EXPECT_EQ(grid.getFreeCount(), 0u);
+
+    grid.reset(64, 64);
+    grid.reset(10, 64);
+    ASSERT_EQ(grid.getFreeCount(), 2u);
+    EXPECT_EQ(grid.findFree(0), 10u * 65u + 64u);
+    EXPECT_EQ(grid.findFree(1), 64u * 65u + 64u);
+
+    grid.clear();
+    EXPECT_EQ(grid.getFreeCount(), 65u * 65u);
+}
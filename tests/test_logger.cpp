@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <thread>
+#include <cstdio>
+#include "../include/Logger.h"
+
+class LoggerTest: public ::testing::Test {
+protected:
+    void SetUp() override {
+        file = std::tmpfile();
+        ASSERT_NE(file, nullptr);
+        logging::Logger::getInstance().setOutput(file);
+    }
+
+    void TearDown() override {
+        logging::Logger& logger = logging::Logger::getInstance();
+        logger.setOutput(stderr);
+        logger.setLevel(logging::Level::Debug);
+        std::fclose(file);
+    }
+
+    // Lines written so far, without their time stamps
+    std::vector<std::string> lines() {
+        logging::Logger::getInstance().flush();
+        std::vector<std::string> result;
+        std::rewind(file);
+        char buffer[512];
+        while (std::fgets(buffer, sizeof(buffer), file)) {
+            std::string line(buffer);
+            if (!line.empty() && line.back() == '\n') line.pop_back();
+            size_t end = line.find("] ");
+            result.push_back(end == std::string::npos ? line : line.substr(end + 2));
+        }
+        return result;
+    }
+
+    std::FILE* file = nullptr;
+};
+
+TEST_F(LoggerTest, FormatsArguments) {
+    const std::string name = "herbivore";
+    ECOSIM_LOG_INFO("{} at {}, {}: energy {} ({})", name, -3, 7u, 2.5, true);
+    ECOSIM_LOG_WARNING("symbol '{}' {}", '*', "unknown");
+    ECOSIM_LOG_ERROR("{} and {} without arguments", 1);
+    ECOSIM_LOG_INFO("{}", std::string(200, 'x'));
+
+    std::vector<std::string> written = lines();
+    ASSERT_EQ(written.size(), 4u);
+    EXPECT_EQ(written[0], "INFO  herbivore at -3, 7: energy 2.5 (true)");
+    EXPECT_EQ(written[1], "WARN  symbol '*' unknown");
+    EXPECT_EQ(written[2], "ERROR 1 and {} without arguments");
+    // Text beyond the message's buffer is cut
+    EXPECT_EQ(written[3], "INFO  " + std::string(logging::Logger::TEXT_BYTES, 'x'));
+}
+
+TEST_F(LoggerTest, FiltersLevels) {
+    logging::Logger& logger = logging::Logger::getInstance();
+    logger.setLevel(logging::Level::Warning);
+    ECOSIM_LOG_INFO("hidden");
+    ECOSIM_LOG_ERROR("shown");
+
+    // Below ECOSIM_LOG_LEVEL the call and its arguments are gone
+    int evaluated = 0;
+    ECOSIM_LOG_DEBUG("{}", ++evaluated);
+    EXPECT_EQ(evaluated, ECOSIM_LOG_LEVEL <= 0 ? 1 : 0);
+
+    std::vector<std::string> written = lines();
+    ASSERT_EQ(written.size(), 1u);
+    EXPECT_EQ(written[0], "ERROR shown");
+}
+
+TEST_F(LoggerTest, CollectsManyProducers) {
+    logging::Logger& logger = logging::Logger::getInstance();
+    const uint64_t droppedBefore = logger.getDroppedCount();
+    const int threads = 4;
+    const int perThread = 5000;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t) {
+        producers.emplace_back([t]() {
+            for (int i = 0; i < perThread; ++i) {
+                ECOSIM_LOG_INFO("producer {} message {}", t, i);
+            }
+        });
+    }
+    for (std::thread& producer : producers) producer.join();
+
+    // Every message is either written, whole, or counted as dropped
+    std::vector<std::string> written = lines();
+    size_t messages = 0;
+    std::vector<int> last(threads, -1);
+    for (const std::string& line : written) {
+        int t = 0, i = 0;
+        if (std::sscanf(line.c_str(), "INFO  producer %d message %d", &t, &i) != 2)
+            continue;
+        ASSERT_GE(t, 0);
+        ASSERT_LT(t, threads);
+        // One producer's messages stay in order
+        EXPECT_GT(i, last[t]);
+        last[t] = i;
+        ++messages;
+    }
+    EXPECT_GT(messages, 0u);
+    EXPECT_EQ(messages + (logger.getDroppedCount() - droppedBefore), static_cast<size_t>(threads * perThread));
+}
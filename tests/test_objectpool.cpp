@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "../include/ObjectPool.h"
+#include <set>
+
+namespace {
+    struct Item {
+        int value;
+        explicit Item(int value) : value(value) {}
+    };
+}
+
+TEST(ObjectPoolTest, AcquireConstructs) {
+    ObjectPool<Item, 8> pool;
+    Item* item = pool.acquire(42);
+
+    EXPECT_EQ(item->value, 42);
+    EXPECT_EQ(pool.getLiveCount(), 1);
+    EXPECT_EQ(pool.getSlabCount(), 1);
+    EXPECT_TRUE(pool.owns(item));
+}
+
+TEST(ObjectPoolTest, ReleaseReusesSlot) {
+    ObjectPool<Item, 8> pool;
+    Item* first = pool.acquire(1);
+    pool.release(first);
+    Item* second = pool.acquire(2);
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(second->value, 2);
+    EXPECT_EQ(pool.getLiveCount(), 1);
+}
+
+TEST(ObjectPoolTest, GrowsBySlabs) {
+    ObjectPool<Item, 4> pool;
+    std::set<Item*> items;
+    for (int i = 0; i < 10; ++i) {
+        items.insert(pool.acquire(i));
+    }
+
+    EXPECT_EQ(items.size(), 10);
+    EXPECT_EQ(pool.getSlabCount(), 3);
+    EXPECT_EQ(pool.getCapacity(), 12);
+    for (Item* item : items) {
+        EXPECT_TRUE(pool.owns(item));
+    }
+}
+
+TEST(ObjectPoolTest, DoesNotOwnForeignObjects) {
+    ObjectPool<Item, 4> pool;
+    pool.acquire(1);
+    Item local(2);
+    Item* heap = new Item(3);
+
+    EXPECT_FALSE(pool.owns(&local));
+    EXPECT_FALSE(pool.owns(heap));
+    delete heap;
+}
+
+TEST(ObjectPoolTest, HighWaterMark) {
+    ObjectPool<Item, 4> pool;
+    Item* items[6];
+    for (int i = 0; i < 6; ++i) {
+        items[i] = pool.acquire(i);
+    }
+    for (int i = 0; i < 4; ++i) {
+        pool.release(items[i]);
+    }
+
+    EXPECT_EQ(pool.getLiveCount(), 2);
+    EXPECT_EQ(pool.getHighWaterMark(), 6);
+}
+
+TEST(ObjectPoolTest, ResetRewindsWithoutFreeingSlabs) {
+    ObjectPool<Item, 4> pool;
+    Item* first = pool.acquire(1);
+    for (int i = 0; i < 6; ++i) {
+        pool.acquire(i);
+    }
+    pool.reset();
+
+    EXPECT_EQ(pool.getLiveCount(), 0);
+    EXPECT_EQ(pool.getSlabCount(), 2);
+    EXPECT_EQ(pool.acquire(5), first);
+
+    for (int i = 0; i < 7; ++i) {
+        pool.acquire(i);
+    }
+    EXPECT_EQ(pool.getSlabCount(), 2); // Reused both slabs before allocating
+    pool.acquire(0);
+    EXPECT_EQ(pool.getSlabCount(), 3);
+}
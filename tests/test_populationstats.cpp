@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <stdexcept>
+#include "../include/PopulationStats.h"
+#include "../include/World.h"
+#include "../include/Entity.h"
+
+class PopulationStatsTest: public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "ecosim_stats_test";
+    }
+
+    void TearDown() override {
+        std::remove((path + ".csv").c_str());
+        std::remove((path + ".bin").c_str());
+        std::remove((path + ".ck").c_str());
+    }
+
+    static void seed(World& world) {
+        world.setSeed(3);
+        for (int i = 0; i < 400; ++i) world.addEntityType('*');
+        for (int i = 0; i < 180; ++i) world.addEntityType('H');
+        for (int i = 0; i < 20; ++i) world.addEntityType('C');
+    }
+
+    static void runTicks(World& world, const int& ticks) {
+        for (int i = 0; i < ticks; ++i) {
+            world.run();
+            if (world.drawRandom() % 2 == 0 && !world.isFull())
+                world.addEntityType('*');
+        }
+    }
+
+    // Count and energy of every species, from a full scan of the grid
+    static std::vector<PopulationStats::Tally> scan(const World& world) {
+        std::vector<PopulationStats::Tally> tallies(PopulationStats::MAX_SPECIES);
+        for (int x = 0; x < world.size.x; ++x) {
+            for (int y = 0; y < world.size.y; ++y) {
+                animalconfig::SpeciesId species = world.getCellSpecies(x, y);
+                if (species == animalconfig::NO_SPECIES)
+                    continue;
+                uint32_t energy = 0;
+                if (world.getStorageMode() == World::StorageMode::Dense) {
+                    energy = world.getEntityStore().energy[world.getSlotAt(x, y)];
+                } else {
+                    energy = world.getEntityAt(x, y)->energy;
+                }
+                ++tallies[species].count;
+                tallies[species].energy += energy;
+            }
+        }
+        return tallies;
+    }
+
+    static void expectMatchesScan(const World& world) {
+        std::vector<PopulationStats::Tally> expected = scan(world);
+        const PopulationStats& stats = world.getStats();
+        for (size_t species = 0; species < expected.size(); ++species) {
+            EXPECT_EQ(stats.get(species).count, expected[species].count) << "species " << species;
+            EXPECT_EQ(stats.get(species).energy, expected[species].energy) << "species " << species;
+        }
+        EXPECT_EQ(stats.getTotal().count, static_cast<int64_t>(world.getOccupiedCellsCount()));
+    }
+
+    void expectTracksRun(World& world) {
+        seed(world);
+        expectMatchesScan(world);
+        runTicks(world, 30);
+        expectMatchesScan(world);
+        EXPECT_GT(world.getStats().getTotal().births, 0u);
+        EXPECT_GT(world.getStats().getTotal().deaths, 0u);
+    }
+
+    std::string path;
+};
+
+TEST_F(PopulationStatsTest, TracksSweepTicks) {
+    std::unique_ptr<World> world = World::createTestInstance(40, 50);
+    expectTracksRun(*world);
+}
+
+TEST_F(PopulationStatsTest, TracksStripedTicks) {
+    std::unique_ptr<World> world = World::createTestInstance(40, 50);
+    world->setThreadCount(3);
+    expectTracksRun(*world);
+}
+
+TEST_F(PopulationStatsTest, TracksDenseTicks) {
+    std::unique_ptr<World> serial = World::createTestInstance(40, 50);
+    serial->setStorageMode(World::StorageMode::Dense);
+    expectTracksRun(*serial);
+
+    std::unique_ptr<World> striped = World::createTestInstance(40, 50);
+    striped->setStorageMode(World::StorageMode::Dense);
+    striped->setThreadCount(3);
+    expectTracksRun(*striped);
+}
+
+TEST_F(PopulationStatsTest, TracksIntentTicks) {
+    std::unique_ptr<World> objects = World::createTestInstance(40, 50);
+    objects->setTickEngine(World::TickEngine::Intent);
+    expectTracksRun(*objects);
+
+    std::unique_ptr<World> dense = World::createTestInstance(40, 50);
+    dense->setStorageMode(World::StorageMode::Dense);
+    dense->setTickEngine(World::TickEngine::Intent);
+    dense->setNearestSearch(World::NearestSearch::Field);
+    expectTracksRun(*dense);
+}
+
+TEST_F(PopulationStatsTest, TracksChunkedTicks) {
+    std::unique_ptr<World> world = World::createTestInstance(0, 0);
+    world->setGridLayout(World::GridLayout::Chunked);
+    world->initialize(90, 100);
+    expectTracksRun(*world);
+}
+
+TEST_F(PopulationStatsTest, TracksPopulateAndRestore) {
+    const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    std::vector<World::Population> populations(2);
+    populations[0].species = registry.findBySymbol('*');
+    populations[0].count = 500;
+    populations[1].species = registry.findBySymbol('H');
+    populations[1].count = 200;
+    populations[1].pattern = World::Population::Pattern::Clustered;
+    populations[1].clusters = 4;
+
+    std::unique_ptr<World> world = World::createTestInstance(50, 60);
+    world->setStorageMode(World::StorageMode::Dense);
+    world->setThreadCount(2);
+    world->populate(populations);
+    expectMatchesScan(*world);
+    runTicks(*world, 10);
+    world->saveCheckpoint(path + ".ck");
+
+    std::unique_ptr<World> restored = World::createTestInstance(10, 10);
+    restored->loadCheckpoint(path + ".ck");
+    expectMatchesScan(*restored);
+    // Births and deaths restart from zero; the file holds the state, not the history
+    EXPECT_EQ(restored->getStats().getTotal().births, 0u);
+
+    restored->clear();
+    EXPECT_EQ(restored->getStats().getTotal().count, 0);
+}
+
+TEST_F(PopulationStatsTest, WritesSeries) {
+    std::unique_ptr<World> world = World::createTestInstance(40, 50);
+    seed(*world);
+    world->getStats().setRecording(true);
+    runTicks(*world, 4);
+    const std::vector<PopulationStats::Sample> first = world->getStats().getSamples();
+    const uint32_t speciesCount = animalconfig::SpeciesRegistry::getInstance().getCount();
+    ASSERT_EQ(first.size(), 4u * speciesCount);
+    EXPECT_EQ(first.back().tick, 3u);
+    EXPECT_EQ(first.back().species, speciesCount);
+    world->getStats().flushBinary(path + ".bin");
+    EXPECT_TRUE(world->getStats().getSamples().empty());
+
+    runTicks(*world, 3);
+    const std::vector<PopulationStats::Sample> second = world->getStats().getSamples();
+    world->getStats().flushCsv(path + ".csv");
+    world->getStats().sample(world->getTick());
+    world->getStats().flushBinary(path + ".bin");
+
+    std::vector<PopulationStats::Sample> read = PopulationStats::readBinary(path + ".bin");
+    ASSERT_EQ(read.size(), first.size() + speciesCount);
+    for (size_t i = 0; i < first.size(); ++i) {
+        EXPECT_EQ(read[i].tick, first[i].tick);
+        EXPECT_EQ(read[i].species, first[i].species);
+        EXPECT_EQ(read[i].count, first[i].count);
+        EXPECT_EQ(read[i].energy, first[i].energy);
+        EXPECT_EQ(read[i].births, first[i].births);
+    }
+    EXPECT_EQ(read.back().count, world->getStats().get(speciesCount).count);
+
+    std::ifstream csv(path + ".csv");
+    std::string line;
+    std::getline(csv, line);
+    EXPECT_EQ(line, "tick,species,name,count,energy,births,deaths");
+    size_t rows = 0;
+    while (std::getline(csv, line)) ++rows;
+    EXPECT_EQ(rows, second.size());
+
+    EXPECT_THROW(PopulationStats::readBinary(path + ".csv"), std::runtime_error);
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include "../include/Profiler.h"
+#include "../include/World.h"
+
+class ProfilerTest: public ::testing::Test {
+protected:
+    void SetUp() override {
+        profiler::Profiler::getInstance().setEnabled(false);
+        profiler::Profiler::getInstance().reset();
+    }
+
+    void TearDown() override {
+        profiler::Profiler::getInstance().setEnabled(false);
+        profiler::Profiler::getInstance().reset();
+    }
+
+    static std::unique_ptr<World> makeWorld(const World::StorageMode& mode = World::StorageMode::Objects) {
+        std::unique_ptr<World> world = World::createTestInstance(40, 40);
+        world->setStorageMode(mode);
+        world->setSeed(5);
+        for (int i = 0; i < 300; ++i) world->addEntityType('*');
+        for (int i = 0; i < 120; ++i) world->addEntityType('H');
+        for (int i = 0; i < 20; ++i) world->addEntityType('C');
+        return world;
+    }
+
+    static const profiler::PhaseSummary* find(const std::vector<profiler::PhaseSummary>& summary, const profiler::Phase& phase) {
+        for (const profiler::PhaseSummary& entry : summary) {
+            if (entry.phase == phase) return &entry;
+        }
+        return nullptr;
+    }
+};
+
+TEST_F(ProfilerTest, HistogramPercentilesAreClose) {
+    profiler::Histogram histogram;
+    for (uint64_t nanoseconds = 1; nanoseconds <= 10000; ++nanoseconds) {
+        histogram.add(nanoseconds);
+    }
+    EXPECT_EQ(histogram.getCount(), 10000u);
+    EXPECT_EQ(histogram.getTotal(), 10000u * 10001u / 2);
+    EXPECT_EQ(histogram.getMax(), 10000u);
+    EXPECT_NEAR(static_cast<double>(histogram.getPercentile(0.5)), 5000.0, 5000.0 * 0.07);
+    EXPECT_NEAR(static_cast<double>(histogram.getPercentile(0.99)), 9900.0, 9900.0 * 0.07);
+    EXPECT_EQ(histogram.getPercentile(1.0), 10000u);
+
+    // Every value lands in a bucket whose middle is within a sixteenth of it
+    for (uint64_t value : {0ull, 7ull, 15ull, 16ull, 100ull, 12345ull, 1ull << 40, ~0ull}) {
+        const uint64_t middle = profiler::Histogram::getBucketMiddle(profiler::Histogram::getBucket(value));
+        EXPECT_NEAR(static_cast<double>(middle), static_cast<double>(value), value / 16.0 + 0.5) << value;
+    }
+
+    profiler::Histogram other;
+    other.add(20000);
+    histogram.merge(other);
+    EXPECT_EQ(histogram.getCount(), 10001u);
+    EXPECT_EQ(histogram.getMax(), 20000u);
+    EXPECT_EQ(profiler::Histogram().getPercentile(0.5), 0u);
+}
+
+TEST_F(ProfilerTest, RecordsNothingWhileDisabled) {
+    std::unique_ptr<World> world = makeWorld();
+    for (int tick = 0; tick < 5; ++tick) world->run();
+    EXPECT_TRUE(profiler::Profiler::getInstance().getSummary().empty());
+}
+
+#if ECOSIM_PROFILE
+TEST_F(ProfilerTest, TimesEveryPhaseOfATick) {
+    for (const World::StorageMode& mode : {World::StorageMode::Objects, World::StorageMode::Dense}) {
+        profiler::Profiler::getInstance().reset();
+        std::unique_ptr<World> world = makeWorld(mode);
+        profiler::Profiler::getInstance().setEnabled(true);
+        for (int tick = 0; tick < 10; ++tick) world->run();
+        profiler::Profiler::getInstance().setEnabled(false);
+
+        const std::vector<profiler::PhaseSummary> summary = profiler::Profiler::getInstance().getSummary();
+        const profiler::PhaseSummary* tick = find(summary, profiler::Phase::Tick);
+        ASSERT_NE(tick, nullptr);
+        EXPECT_EQ(tick->count, 10u);
+        EXPECT_LE(tick->p50Nanoseconds, tick->p99Nanoseconds);
+        EXPECT_LE(tick->p99Nanoseconds, tick->maxNanoseconds);
+        for (const profiler::Phase& phase : {profiler::Phase::HerbivorePass, profiler::Phase::AgentPass, profiler::Phase::Record,
+                                             profiler::Phase::FindPredator, profiler::Phase::FindPrey, profiler::Phase::Reproduce}) {
+            const profiler::PhaseSummary* entry = find(summary, phase);
+            ASSERT_NE(entry, nullptr) << profiler::getPhaseName(phase);
+            EXPECT_GT(entry->count, 0u);
+            EXPECT_LE(entry->totalNanoseconds, tick->totalNanoseconds);
+        }
+        EXPECT_EQ(find(summary, profiler::Phase::HerbivorePass)->count, 10u);
+        // Some agents see nothing to flee from or hunt, and wander
+        EXPECT_NE(find(summary, profiler::Phase::Wander), nullptr);
+    }
+
+    std::ostringstream printed;
+    profiler::Profiler::getInstance().printSummary(printed);
+    EXPECT_NE(printed.str().find("HerbivorePass"), std::string::npos);
+}
+
+TEST_F(ProfilerTest, TracesTheFirstTicks) {
+    std::unique_ptr<World> world = makeWorld();
+    profiler::Profiler::getInstance().startTrace(2);
+    EXPECT_TRUE(profiler::Profiler::isEnabled());
+    for (int tick = 0; tick < 5; ++tick) world->run();
+    EXPECT_FALSE(profiler::Profiler::getInstance().isTracing());
+
+    const std::string path = ::testing::TempDir() + "ecosim_trace_test.json";
+    profiler::Profiler::getInstance().writeChromeTrace(path);
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::remove(path.c_str());
+
+    const std::string trace = contents.str();
+    EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    size_t ticks = 0;
+    for (size_t at = trace.find("\"name\":\"Tick\""); at != std::string::npos; at = trace.find("\"name\":\"Tick\"", at + 1)) {
+        ++ticks;
+    }
+    EXPECT_EQ(ticks, 2u);
+    EXPECT_NE(trace.find("\"name\":\"AgentPass\",\"cat\":\"ecosim\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(trace.find("\"droppedEvents\":0"), std::string::npos);
+
+    // Histograms keep counting after the trace window
+    EXPECT_EQ(find(profiler::Profiler::getInstance().getSummary(), profiler::Phase::Tick)->count, 5u);
+}
+#endif
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include "../include/Rng.h"
+#include <set>
+#include <vector>
+
+TEST(RngTest, DrawsArePureFunctions) {
+    EXPECT_EQ(rng::draw(42, 7, 1000, rng::FLEE_STREAM, 3), rng::draw(42, 7, 1000, rng::FLEE_STREAM, 3));
+
+    // Every input changes the draw
+    uint64_t base = rng::draw(42, 7, 1000, rng::FLEE_STREAM, 3);
+    EXPECT_NE(base, rng::draw(43, 7, 1000, rng::FLEE_STREAM, 3));
+    EXPECT_NE(base, rng::draw(42, 8, 1000, rng::FLEE_STREAM, 3));
+    EXPECT_NE(base, rng::draw(42, 7, 1001, rng::FLEE_STREAM, 3));
+    EXPECT_NE(base, rng::draw(42, 7, 1000, rng::WANDER_STREAM, 3));
+    EXPECT_NE(base, rng::draw(42, 7, 1000, rng::FLEE_STREAM, 4));
+}
+
+TEST(RngTest, BlockMatchesSingleDraws) {
+    // Entity ids use all 64 bits
+    std::vector<uint64_t> keys;
+    for (uint64_t key = 0; key < 257; ++key) {
+        keys.push_back(key * 0x9E3779B97F4A7C15ULL + 5);
+    }
+    std::vector<uint64_t> block(keys.size());
+    rng::drawBlock(9, 3, keys.data(), keys.size(), rng::WANDER_STREAM, 2, block.data());
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(block[i], rng::draw(9, 3, keys[i], rng::WANDER_STREAM, 2));
+    }
+    EXPECT_NE(rng::draw(9, 3, keys[1], rng::WANDER_STREAM, 2), rng::draw(9, 3, keys[1] & 0xFFFFFFFFULL, rng::WANDER_STREAM, 2));
+}
+
+TEST(RngTest, NoCollisionsAcrossKeys) {
+    std::set<uint64_t> seen;
+    for (uint64_t key = 0; key < 10000; ++key) {
+        seen.insert(rng::draw(1, 0, key, rng::PRIORITY_STREAM));
+    }
+    EXPECT_EQ(seen.size(), 10000);
+}
+
+TEST(RngTest, UniformRanges) {
+    uint32_t buckets[4] = {0, 0, 0, 0};
+    double sum = 0.0;
+    const uint32_t samples = 40000;
+    for (uint32_t key = 0; key < samples; ++key) {
+        uint64_t bits = rng::draw(5, 1, key, rng::WORLD_STREAM);
+        double value = rng::uniform(bits);
+        ASSERT_GE(value, 0.0);
+        ASSERT_LT(value, 1.0);
+        sum += value;
+
+        uint32_t bucket = rng::below(bits, 4);
+        ASSERT_LT(bucket, 4u);
+        ++buckets[bucket];
+    }
+
+    EXPECT_NEAR(sum / samples, 0.5, 0.01);
+    for (uint32_t count : buckets) {
+        EXPECT_NEAR(count, samples / 4, samples / 40);
+    }
+}
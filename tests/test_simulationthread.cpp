@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+#include <functional>
+#include "../include/SimulationThread.h"
+#include "../include/World.h"
+
+class SimulationThreadTest: public ::testing::Test {
+protected:
+    void SetUp() override {
+        world = World::createTestInstance(30, 40);
+        world->setSeed(8);
+        for (int i = 0; i < 200; ++i) world->addEntityType('*');
+        for (int i = 0; i < 80; ++i) world->addEntityType('H');
+        for (int i = 0; i < 10; ++i) world->addEntityType('C');
+    }
+
+    // Polls `done` for up to five seconds
+    static bool waitFor(const std::function<bool()>& done) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!done()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::unique_ptr<World> world;
+};
+
+TEST_F(SimulationThreadTest, PublishesTheLatestTick) {
+    SimulationThread simulation(*world);
+    ASSERT_TRUE(waitFor([&] { return simulation.getTicksRun() >= 30; }));
+    simulation.stop();
+    EXPECT_FALSE(simulation.isRunning());
+
+    const WorldSnapshot* latest = simulation.getLatestSnapshot();
+    ASSERT_NE(latest, nullptr);
+    WorldSnapshot full;
+    world->updateSnapshot(full);
+    EXPECT_EQ(latest->tick, simulation.getTicksRun());
+    EXPECT_EQ(latest->tick, world->getTick());
+    EXPECT_EQ(latest->species, full.species);
+    EXPECT_EQ(latest->energy, full.energy);
+    EXPECT_EQ(latest->counts, full.counts);
+}
+
+TEST_F(SimulationThreadTest, PausesAndSteps) {
+    SimulationThread simulation(*world, SimulationThread::TickHook(), true);
+    EXPECT_TRUE(simulation.isPaused());
+    ASSERT_TRUE(waitFor([&] { return simulation.getLatestSnapshot() != nullptr; }));
+    EXPECT_EQ(simulation.getLatestSnapshot()->tick, 0u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(simulation.getTicksRun(), 0u);
+
+    simulation.step(3);
+    ASSERT_TRUE(waitFor([&] { return simulation.getLatestSnapshot()->tick == 3; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(simulation.getTicksRun(), 3u);
+
+    simulation.setPaused(false);
+    ASSERT_TRUE(waitFor([&] { return simulation.getTicksRun() > 10; }));
+    simulation.setPaused(true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const uint64_t stopped = simulation.getTicksRun();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(simulation.getTicksRun(), stopped);
+}
+
+TEST_F(SimulationThreadTest, KeepsToTheTickRate) {
+    SimulationThread simulation(*world, SimulationThread::TickHook(), true);
+    simulation.setTickRate(20.0);
+    simulation.setPaused(false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    const uint64_t slow = simulation.getTicksRun();
+    // About 6 ticks; well short of what an uncapped run manages
+    EXPECT_LE(slow, 15u);
+
+    simulation.setSpeed(1000.0);
+    EXPECT_TRUE(waitFor([&] { return simulation.getTicksRun() >= slow + 30; }));
+    simulation.stop();
+}
+
+TEST_F(SimulationThreadTest, RunsTheHookAndReportsErrors) {
+    uint64_t calls = 0;
+    SimulationThread simulation(*world, [&calls](World& ticked) {
+        EXPECT_EQ(ticked.getTick(), calls);
+        if (++calls == 5) throw std::runtime_error("hook failed");
+    });
+    ASSERT_TRUE(waitFor([&] { return !simulation.isRunning(); }));
+    EXPECT_EQ(simulation.getTicksRun(), 4u);
+    EXPECT_THROW(simulation.stop(), std::runtime_error);
+    EXPECT_NO_THROW(simulation.stop());
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "../include/Snapshot.h"
+#include "../include/World.h"
+
+namespace {
+    struct Pair {
+        uint64_t first = 0;
+        uint64_t second = 0;
+    };
+}
+
+TEST(TripleBufferTest, HandsOverTheLatestCopy) {
+    TripleBuffer<Pair> buffer;
+    EXPECT_EQ(buffer.getLatest(), nullptr);
+
+    for (uint64_t value = 1; value <= 3; ++value) {
+        buffer.getBack().first = value;
+        buffer.publish();
+    }
+    const Pair* held = buffer.getLatest();
+    ASSERT_NE(held, nullptr);
+    EXPECT_EQ(held->first, 3u);
+    EXPECT_EQ(buffer.getLatest(), held);
+
+    // The writer keeps going without ever touching the copy the reader holds
+    for (uint64_t value = 4; value <= 10; ++value) {
+        EXPECT_NE(&buffer.getBack(), held);
+        buffer.getBack().first = value;
+        buffer.publish();
+        EXPECT_EQ(held->first, 3u);
+    }
+    EXPECT_EQ(buffer.getLatest()->first, 10u);
+}
+
+TEST(TripleBufferTest, ReaderSeesWholeCopiesInOrder) {
+    TripleBuffer<Pair> buffer;
+    const uint64_t count = 200000;
+    std::atomic<bool> done{false};
+    std::thread writer([&]() {
+        for (uint64_t value = 1; value <= count; ++value) {
+            Pair& back = buffer.getBack();
+            back.first = value;
+            back.second = value * 3;
+            buffer.publish();
+        }
+        done = true;
+    });
+
+    uint64_t last = 0;
+    while (!done || last < count) {
+        const Pair* latest = buffer.getLatest();
+        if (latest == nullptr) continue;
+        ASSERT_EQ(latest->second, latest->first * 3);
+        ASSERT_GE(latest->first, last);
+        last = latest->first;
+    }
+    writer.join();
+    EXPECT_EQ(last, count);
+}
+
+class SnapshotTest: public ::testing::Test {
+protected:
+    static void expectSame(const WorldSnapshot& a, const WorldSnapshot& b) {
+        EXPECT_EQ(a.tick, b.tick);
+        EXPECT_EQ(a.rows, b.rows);
+        EXPECT_EQ(a.columns, b.columns);
+        EXPECT_EQ(a.occupied, b.occupied);
+        EXPECT_EQ(a.counts, b.counts);
+        EXPECT_EQ(a.species, b.species);
+        EXPECT_EQ(a.energy, b.energy);
+    }
+
+    // Patches one snapshot with each tick's changes and compares it with a full copy
+    static void expectPatchesMatch(World& world) {
+        world.setSeed(6);
+        world.setChangeTracking(true);
+        for (int i = 0; i < 250; ++i) world.addEntityType('*');
+        for (int i = 0; i < 100; ++i) world.addEntityType('H');
+        for (int i = 0; i < 12; ++i) world.addEntityType('C');
+
+        WorldSnapshot patched;
+        std::vector<uint32_t> changed;
+        for (int tick = 0; tick < 20; ++tick) {
+            world.updateSnapshot(patched, world.takeChangedCells(changed) ? &changed : nullptr);
+            WorldSnapshot full;
+            world.updateSnapshot(full);
+            expectSame(patched, full);
+            EXPECT_EQ(full.occupied, world.getOccupiedCellsCount());
+            world.run();
+        }
+    }
+};
+
+TEST_F(SnapshotTest, CopiesObjectWorlds) {
+    std::unique_ptr<World> world = World::createTestInstance(30, 40);
+    expectPatchesMatch(*world);
+
+    WorldSnapshot snapshot;
+    world->updateSnapshot(snapshot);
+    for (int x = 0; x < world->size.x; ++x) {
+        for (int y = 0; y < world->size.y; ++y) {
+            EXPECT_EQ(snapshot.species[snapshot.getCellId(x, y)], world->getCellSpecies(x, y));
+        }
+    }
+}
+
+TEST_F(SnapshotTest, CopiesDenseAndChunkedWorlds) {
+    std::unique_ptr<World> dense = World::createTestInstance(30, 40);
+    dense->setStorageMode(World::StorageMode::Dense);
+    dense->setThreadCount(2);
+    expectPatchesMatch(*dense);
+
+    std::unique_ptr<World> chunked = World::createTestInstance(0, 0);
+    chunked->setGridLayout(World::GridLayout::Chunked);
+    chunked->initialize(70, 90);
+    expectPatchesMatch(*chunked);
+}
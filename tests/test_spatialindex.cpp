@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <climits>
+#include "../include/SpatialIndex.h"
+#include "../include/Rng.h"
+
+namespace {
+    // The square-window scan the index replaces
+    kinematics::Vector2D bruteForce(const std::vector<animalconfig::SpeciesId>& cells, const int& rows, const int& cols,
+                                    const kinematics::Vector2D& pos, const int& range, const std::vector<animalconfig::SpeciesId>& species) {
+        kinematics::Vector2D nearest(-1, -1);
+        int minDist = INT_MAX;
+        for (int x = std::max(0, pos.x - range); x <= std::min(rows - 1, pos.x + range); ++x) {
+            for (int y = std::max(0, pos.y - range); y <= std::min(cols - 1, pos.y + range); ++y) {
+                if (x == pos.x && y == pos.y)
+                    continue;
+                bool match = false;
+                for (const animalconfig::SpeciesId& id : species) {
+                    match = match || cells[x * cols + y] == id;
+                }
+                int dist = abs(x - pos.x) + abs(y - pos.y);
+                if (match && dist < minDist) {
+                    minDist = dist;
+                    nearest = kinematics::Vector2D(x, y);
+                }
+            }
+        }
+        return nearest;
+    }
+}
+
+TEST(SpatialIndexTest, EmptyIndexFindsNothing) {
+    SpatialIndex index;
+    index.resize(10, 10);
+    animalconfig::SpeciesId species = 2;
+    EXPECT_EQ(index.findNearest(kinematics::Vector2D(5, 5), 4, &species, 1), kinematics::Vector2D(-1, -1));
+}
+
+TEST(SpatialIndexTest, SetResetAndCount) {
+    SpatialIndex index;
+    index.resize(4, 130);
+    index.set(3, 2, 129);
+    index.set(3, 0, 0);
+    EXPECT_TRUE(index.test(3, 2, 129));
+    EXPECT_FALSE(index.test(2, 2, 129));
+    EXPECT_EQ(index.getCount(3), 2);
+
+    index.reset(3, 2, 129);
+    index.reset(7, 0, 0);   // No such plane
+    EXPECT_EQ(index.getCount(3), 1);
+
+    index.clear();
+    EXPECT_EQ(index.getCount(3), 0);
+}
+
+TEST(SpatialIndexTest, SkipsOwnCell) {
+    SpatialIndex index;
+    index.resize(5, 5);
+    index.set(1, 2, 2);
+    animalconfig::SpeciesId species = 1;
+    EXPECT_EQ(index.findNearest(kinematics::Vector2D(2, 2), 3, &species, 1), kinematics::Vector2D(-1, -1));
+
+    index.set(1, 4, 2);
+    EXPECT_EQ(index.findNearest(kinematics::Vector2D(2, 2), 3, &species, 1), kinematics::Vector2D(4, 2));
+}
+
+TEST(SpatialIndexTest, TiesGoToFirstCellInRowMajorOrder) {
+    SpatialIndex index;
+    index.resize(9, 9);
+    animalconfig::SpeciesId species = 1;
+    index.set(1, 5, 4);
+    index.set(1, 4, 5);
+    index.set(1, 4, 3);
+    EXPECT_EQ(index.findNearest(kinematics::Vector2D(4, 4), 2, &species, 1), kinematics::Vector2D(4, 3));
+    index.set(1, 3, 4);
+    EXPECT_EQ(index.findNearest(kinematics::Vector2D(4, 4), 2, &species, 1), kinematics::Vector2D(3, 4));
+}
+
+TEST(SpatialIndexTest, QueriesEveryListedSpecies) {
+    SpatialIndex index;
+    index.resize(9, 9);
+    std::vector<animalconfig::SpeciesId> species;
+    for (animalconfig::SpeciesId id = 1; id <= 40; ++id) {
+        species.push_back(id);
+    }
+    // Only the last species of a long predator list is present
+    index.set(40, 6, 4);
+    EXPECT_EQ(index.findNearest(kinematics::Vector2D(4, 4), 3, species.data(), species.size()), kinematics::Vector2D(6, 4));
+}
+
+TEST(SpatialIndexTest, MatchesWindowScan) {
+    const int rows = 37, cols = 150;
+    std::vector<animalconfig::SpeciesId> cells(rows * cols, animalconfig::NO_SPECIES);
+    SpatialIndex index;
+    index.resize(rows, cols);
+
+    uint64_t counter = 0;
+    for (int x = 0; x < rows; ++x) {
+        for (int y = 0; y < cols; ++y) {
+            uint64_t draw = rng::draw(42, 0, counter++, 1, 0);
+            // Sparse, so most searches run to the edge of the window
+            if (draw % 50 < 3) {
+                animalconfig::SpeciesId species = 1 + (draw >> 8) % 3;
+                cells[x * cols + y] = species;
+                index.set(species, x, y);
+            }
+        }
+    }
+
+    const std::vector<std::vector<animalconfig::SpeciesId>> queries = {{1}, {2}, {3}, {2, 3}, {1, 2, 3}, {4}};
+    for (int range = 0; range <= 10; ++range) {
+        for (int i = 0; i < 300; ++i) {
+            uint64_t draw = rng::draw(7, range, i, 2, 0);
+            kinematics::Vector2D pos(draw % rows, (draw >> 16) % cols);
+            for (const std::vector<animalconfig::SpeciesId>& species : queries) {
+                EXPECT_EQ(index.findNearest(pos, range, species.data(), species.size()), bruteForce(cells, rows, cols, pos, range, species))
+                    << "pos " << pos.x << "," << pos.y << " range " << range;
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <cstdlib>
+#include <climits>
+#include "../include/VisionKernel.h"
+#include "../include/Rng.h"
+
+namespace {
+    const vision::Kernel KERNELS[3] = {vision::Kernel::Scalar, vision::Kernel::SSE41, vision::Kernel::AVX2};
+
+    kinematics::Vector2D bruteForce(const std::vector<uint8_t>& plane, const kinematics::Vector2D& size,
+                                    const kinematics::Vector2D& pos, const int& range, const vision::Match& match) {
+        kinematics::Vector2D nearest(-1, -1);
+        int minDist = INT_MAX;
+        for (int x = std::max(0, pos.x - range); x <= std::min(size.x - 1, pos.x + range); ++x) {
+            for (int y = std::max(0, pos.y - range); y <= std::min(size.y - 1, pos.y + range); ++y) {
+                uint8_t value = plane[x * size.y + y];
+                int dist = abs(x - pos.x) + abs(y - pos.y);
+                if (dist > 0 && value >= match.lo && value <= match.hi && dist < minDist) {
+                    minDist = dist;
+                    nearest = kinematics::Vector2D(x, y);
+                }
+            }
+        }
+        return nearest;
+    }
+}
+
+TEST(VisionKernelTest, UnsupportedKernelFallsBack) {
+    vision::Kernel best = vision::getBestKernel();
+    vision::setKernel(vision::Kernel::Scalar);
+    EXPECT_EQ(vision::getKernel(), vision::Kernel::Scalar);
+    vision::setKernel(vision::Kernel::AVX2);
+    EXPECT_EQ(vision::getKernel(), best == vision::Kernel::AVX2 ? vision::Kernel::AVX2 : best);
+    EXPECT_STREQ(vision::getKernelName(vision::Kernel::Scalar), "scalar");
+    vision::setKernel(best);
+}
+
+TEST(VisionKernelTest, KernelsAgreeOnBlocks) {
+    std::vector<uint8_t> cells(64);
+    for (uint32_t trial = 0; trial < 200; ++trial) {
+        for (uint32_t i = 0; i < 64; ++i) {
+            cells[i] = static_cast<uint8_t>(rng::draw(1, trial, i, 1, 0));
+        }
+        uint8_t a = static_cast<uint8_t>(rng::draw(2, trial, 0, 1, 0));
+        uint8_t b = static_cast<uint8_t>(rng::draw(2, trial, 1, 1, 0));
+        vision::Match match = {std::min(a, b), std::max(a, b)};
+
+        uint64_t expected = 0;
+        for (uint32_t i = 0; i < 64; ++i) {
+            expected |= static_cast<uint64_t>(cells[i] >= match.lo && cells[i] <= match.hi) << i;
+        }
+        for (const vision::Kernel& kernel : KERNELS) {
+            vision::setKernel(kernel);
+            EXPECT_EQ(vision::matchBlock(cells.data(), match), expected) << vision::getKernelName(vision::getKernel());
+        }
+    }
+    vision::setKernel(vision::getBestKernel());
+}
+
+TEST(VisionKernelTest, FindNearestMatchesWindowScan) {
+    const kinematics::Vector2D size(33, 140);
+    std::vector<uint8_t> plane(size.x * size.y + vision::PLANE_PADDING, 0);
+    for (int cell = 0; cell < size.x * size.y; ++cell) {
+        uint64_t draw = rng::draw(3, 0, cell, 1, 0);
+        plane[cell] = draw % 40 == 0 ? 1 + (draw >> 8) % 4 : 0;
+    }
+    for (size_t cell = size.x * size.y; cell < plane.size(); ++cell) {
+        plane[cell] = 2;   // Padding must never match
+    }
+
+    const vision::Match matches[3] = {{2, 2}, {3, UINT8_MAX}, {1, 4}};
+    for (const vision::Kernel& kernel : KERNELS) {
+        vision::setKernel(kernel);
+        for (int range = 0; range <= 40; range += 3) {
+            for (int i = 0; i < 100; ++i) {
+                uint64_t draw = rng::draw(4, range, i, 1, 0);
+                kinematics::Vector2D pos(draw % size.x, (draw >> 16) % size.y);
+                for (const vision::Match& match : matches) {
+                    EXPECT_EQ(vision::findNearest(plane.data(), size, pos, range, match), bruteForce(plane, size, pos, range, match))
+                        << vision::getKernelName(kernel) << " pos " << pos.x << "," << pos.y << " range " << range;
+                }
+            }
+        }
+    }
+    vision::setKernel(vision::getBestKernel());
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include "../include/WorkerPool.h"
+#include <atomic>
+#include <set>
+#include <vector>
+
+TEST(WorkerPoolTest, RunsEveryIndexOnce) {
+    WorkerPool pool(4);
+    EXPECT_EQ(pool.getThreadCount(), 4);
+
+    std::vector<std::atomic<uint32_t>> hits(1000);
+    pool.run(hits.size(), [&](uint32_t index, uint32_t worker) {
+        EXPECT_LT(worker, 4u);
+        hits[index].fetch_add(1);
+    });
+
+    for (const std::atomic<uint32_t>& hit : hits) {
+        EXPECT_EQ(hit.load(), 1);
+    }
+}
+
+TEST(WorkerPoolTest, ReusedAcrossBatches) {
+    WorkerPool pool(3);
+    std::atomic<uint64_t> sum{0};
+
+    for (uint32_t batch = 0; batch < 50; ++batch) {
+        pool.run(batch, [&](uint32_t index, uint32_t) {
+            sum.fetch_add(index);
+        });
+    }
+    EXPECT_EQ(sum.load(), 19600); // sum over batches of batch * (batch - 1) / 2
+}
+
+TEST(WorkerPoolTest, SingleThreadRunsInline) {
+    WorkerPool pool(1);
+    std::vector<uint32_t> order;
+    pool.run(5, [&](uint32_t index, uint32_t worker) {
+        EXPECT_EQ(worker, 0);
+        order.push_back(index);
+    });
+    EXPECT_EQ(order, std::vector<uint32_t>({0, 1, 2, 3, 4}));
+}
+
+TEST(WorkerPoolTest, NoPoolRunsInline) {
+    std::vector<uint32_t> order;
+    WorkerPool::run(nullptr, 4, [&](uint32_t index, uint32_t worker) {
+        EXPECT_EQ(worker, 0);
+        order.push_back(index);
+    });
+    EXPECT_EQ(order, std::vector<uint32_t>({0, 1, 2, 3}));
+
+    WorkerPool pool(2);
+    std::atomic<uint32_t> hits{0};
+    WorkerPool::run(&pool, 100, [&](uint32_t, uint32_t) { hits.fetch_add(1); });
+    EXPECT_EQ(hits.load(), 100u);
+}
@@ -4,6 +4,9 @@
 // #include "../include/Carnivore.h"
 // #include "../include/Herbivore.h"
 #include <memory>
+#include <set>
+#include <utility>
+#include <cmath>
 
 namespace {
     static uint32_t HEIGHT = 10;
@@ -40,7 +43,8 @@ TEST_F(WorldTest, WorldInitialization) {
     // Test world is already initialized in SetUp
     EXPECT_EQ(testWorld->getCellId(0, 0), 0);
     EXPECT_EQ(testWorld->getCellId(9, 9), 99);
-    EXPECT_EQ(testWorld->getCellId(10, 10), INT_MAX);
+    EXPECT_EQ(testWorld->getCellId(10, 10), World::INVALID_CELL);
+    EXPECT_EQ(testWorld->getCellId(-1, 0), World::INVALID_CELL);
 }
 
 TEST_F(WorldTest, AddEntity) {
@@ -141,3 +145,681 @@ TEST_F(WorldTest, GetOccupiedCellsCount) {
     EXPECT_EQ(testWorld->getOccupiedCellsCount(), 3);
 }
 
+
+TEST_F(WorldTest, NonSquareWorld) {
+    auto wideWorld = World::createTestInstance(3, 20);
+    Entity entity(animalconfig::PLANT_CONFIG, *wideWorld, 2, 19);
+    wideWorld->addEntity(&entity);
+
+    EXPECT_TRUE(wideWorld->isCellOccupied(2, 19));
+    EXPECT_FALSE(wideWorld->isCellOccupied(19, 2));
+    EXPECT_EQ(wideWorld->getEntityAt(2, 19), &entity);
+    EXPECT_EQ(wideWorld->getOccupiedCellsCount(), 1);
+
+    wideWorld->clearCell(2, 19);
+    EXPECT_FALSE(wideWorld->isCellOccupied(2, 19));
+    EXPECT_EQ(wideWorld->getOccupiedCellsCount(), 0);
+}
+
+TEST_F(WorldTest, SpawnEntityUsesPool) {
+    Entity* entity = testWorld->spawnEntity(animalconfig::HERBIVORE_CONFIG, kinematics::Vector2D(3, 4));
+
+    EXPECT_EQ(testWorld->getEntityAt(3, 4), entity);
+    EXPECT_EQ(testWorld->getEntityPool().getLiveCount(), 1);
+
+    testWorld->killEntity(entity);
+    EXPECT_EQ(entity, nullptr);
+    EXPECT_EQ(testWorld->getEntityPool().getLiveCount(), 0);
+    EXPECT_EQ(testWorld->getEntityPool().getHighWaterMark(), 1);
+}
+
+TEST_F(WorldTest, ClearWorld) {
+    for (int i = 0; i < 20; i++) {
+        testWorld->addEntityType('H');
+    }
+    testWorld->clear();
+
+    EXPECT_EQ(testWorld->getOccupiedCellsCount(), 0);
+    EXPECT_EQ(testWorld->getEntityPool().getLiveCount(), 0);
+    EXPECT_EQ(testWorld->getEntityAt(0, 0), nullptr);
+}
+
+TEST_F(WorldTest, DenseStorageSpawn) {
+    testWorld->setStorageMode(World::StorageMode::Dense);
+    uint32_t index = testWorld->spawnDense('H', kinematics::Vector2D(2, 3));
+
+    EXPECT_TRUE(testWorld->isCellOccupied(2, 3));
+    EXPECT_EQ(testWorld->getCellSymbol(2, 3), 'H');
+    EXPECT_EQ(testWorld->getSlotAt(2, 3), index);
+    EXPECT_EQ(testWorld->getEntityAt(2, 3), nullptr);
+    EXPECT_EQ(testWorld->getEntityStore().energy[index], animalconfig::HERBIVORE_CONFIG.energy);
+
+    testWorld->killDense(index);
+    EXPECT_FALSE(testWorld->isCellOccupied(2, 3));
+    EXPECT_EQ(testWorld->getSlotAt(2, 3), EntityStore::INVALID);
+}
+
+TEST_F(WorldTest, DenseStorageRequiresEmptyWorld) {
+    testWorld->addEntityType('H');
+    EXPECT_THROW(testWorld->setStorageMode(World::StorageMode::Dense), std::runtime_error);
+}
+
+TEST_F(WorldTest, DenseHerbivoreEatsAdjacentPlant) {
+    testWorld->setStorageMode(World::StorageMode::Dense);
+    uint32_t herbivore = testWorld->spawnDense('H', kinematics::Vector2D(5, 5));
+    testWorld->spawnDense('*', kinematics::Vector2D(5, 6));
+
+    testWorld->run();
+
+    const EntityStore& store = testWorld->getEntityStore();
+    EXPECT_EQ(store.posX[herbivore], 5);
+    EXPECT_EQ(store.posY[herbivore], 6);
+    EXPECT_EQ(testWorld->getCellSymbol(5, 6), 'H');
+    EXPECT_EQ(testWorld->getOccupiedCellsCount(), 1);
+    EXPECT_EQ(store.energy[herbivore], animalconfig::HERBIVORE_CONFIG.energy + animalconfig::HERBIVORE_CONFIG.energyGainFromEating - animalconfig::HERBIVORE_CONFIG.energyCostPerTick);
+}
+
+TEST_F(WorldTest, DenseHerbivoreFleesCarnivore) {
+    testWorld->setStorageMode(World::StorageMode::Dense);
+    uint32_t herbivore = testWorld->spawnDense('H', kinematics::Vector2D(5, 5));
+    testWorld->spawnDense('C', kinematics::Vector2D(5, 7));
+
+    const EntityStore& store = testWorld->getEntityStore();
+    kinematics::Vector2D before(store.posX[herbivore], store.posY[herbivore]);
+    testWorld->run();
+    kinematics::Vector2D after(store.posX[herbivore], store.posY[herbivore]);
+
+    // Either stood still (30% chance) or moved away from the carnivore
+    EXPECT_TRUE(after == before || after == kinematics::Vector2D(5, 4) || after == kinematics::Vector2D(4, 5) || after == kinematics::Vector2D(6, 5));
+}
+
+TEST_F(WorldTest, DenseRunWorld) {
+    testWorld->setStorageMode(World::StorageMode::Dense);
+    for (int i = 0; i < 10; i++) {
+        testWorld->addEntityType('H');
+        testWorld->addEntityType('C');
+        testWorld->addEntityType('*');
+    }
+
+    for (int tick = 0; tick < 50; tick++) {
+        EXPECT_NO_THROW(testWorld->run());
+    }
+
+    // Grid and store must agree
+    const EntityStore& store = testWorld->getEntityStore();
+    uint32_t live = 0;
+    for (uint32_t index = 0; index < store.getSlotCount(); ++index) {
+        if (!store.isAlive(index))
+            continue;
+        ++live;
+        EXPECT_EQ(testWorld->getSlotAt(store.posX[index], store.posY[index]), index);
+    }
+    EXPECT_EQ(live, testWorld->getOccupiedCellsCount());
+}
+
+TEST_F(WorldTest, ConfiguredSpeciesHunts) {
+    animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    registry.loadFromString(R"({"species": [{"name": "fox", "symbol": "F", "prey": "H", "energy": 50, "maxEnergy": 100, "visionRange": 3, "energyGainFromEating": 10, "energyCostPerTick": 1}]})");
+
+    Entity* fox = testWorld->spawnEntity(registry.findBySymbol('F'), kinematics::Vector2D(4, 4));
+    Entity* sheep = testWorld->spawnEntity(registry.findBySymbol('H'), kinematics::Vector2D(4, 5));
+
+    EXPECT_EQ(testWorld->getCellSymbol(4, 4), 'F');
+    EXPECT_EQ(fox->findNearestPrey(), kinematics::Vector2D(4, 5));
+
+    fox->feed(sheep);
+    EXPECT_EQ(sheep, nullptr);
+    EXPECT_EQ(fox->energy, 60);
+
+    registry.reset();
+}
+
+TEST_F(WorldTest, UnevenTickCostStarvesInEveryEngine) {
+    animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    registry.loadFromString(R"({"species": [{"name": "stray", "symbol": "S", "prey": "H", "energy": 5, "maxEnergy": 10, "visionRange": 1, "reproductionCost": 10, "reproductionThreshold": 10, "energyCostPerTick": 2}]})");
+
+    const World::StorageMode modes[2] = {World::StorageMode::Objects, World::StorageMode::Dense};
+    const World::TickEngine engines[2] = {World::TickEngine::Sweep, World::TickEngine::Intent};
+    for (World::StorageMode mode : modes) {
+        for (World::TickEngine engine : engines) {
+            std::unique_ptr<World> world = World::createTestInstance(WIDTH, HEIGHT);
+            world->setStorageMode(mode);
+            world->setTickEngine(engine);
+            world->addEntityType('S');
+
+            // 5 -> 3 -> 1 -> 0, never wrapping round to a huge energy
+            uint32_t lowest = 5;
+            for (int tick = 0; tick < 10 && world->getOccupiedCellsCount() != 0; ++tick) {
+                world->run();
+                for (int x = 0; x < world->size.x; ++x) {
+                    for (int y = 0; y < world->size.y; ++y) {
+                        if (world->isCellOccupied(x, y)) {
+                            EXPECT_LE(world->getCellEnergy(x, y), lowest);
+                            lowest = world->getCellEnergy(x, y);
+                        }
+                    }
+                }
+            }
+            EXPECT_EQ(lowest, 0);
+            EXPECT_EQ(world->getOccupiedCellsCount(), 0);
+        }
+    }
+
+    registry.reset();
+}
+
+namespace {
+    // Species of every cell after `ticks` ticks from a fixed seed
+    std::vector<animalconfig::SpeciesId> runStriped(World::StorageMode mode, uint32_t threads, uint32_t ticks,
+                                                    World::TickEngine engine = World::TickEngine::Sweep,
+                                                    World::NearestSearch search = World::NearestSearch::Scan) {
+        std::unique_ptr<World> world = World::createTestInstance(64, 40);
+        world->setStorageMode(mode);
+        world->setThreadCount(threads);
+        world->setTickEngine(engine);
+        world->setNearestSearch(search);
+        world->setSeed(1234);
+
+        for (int i = 0; i < 600; ++i) world->addEntityType('*');
+        for (int i = 0; i < 300; ++i) world->addEntityType('H');
+        for (int i = 0; i < 40; ++i) world->addEntityType('C');
+
+        for (uint32_t tick = 0; tick < ticks; ++tick) {
+            world->run();
+        }
+
+        std::vector<animalconfig::SpeciesId> cells;
+        uint32_t occupied = 0;
+        for (int x = 0; x < world->size.x; ++x) {
+            for (int y = 0; y < world->size.y; ++y) {
+                cells.push_back(world->getCellSpecies(x, y));
+                occupied += cells.back() != animalconfig::NO_SPECIES;
+            }
+        }
+        uint32_t live = mode == World::StorageMode::Dense ? world->getEntityStore().getLiveCount() : world->getEntityPool().getLiveCount();
+        EXPECT_EQ(world->getOccupiedCellsCount(), occupied);
+        EXPECT_EQ(live, occupied);
+        return cells;
+    }
+}
+
+TEST_F(WorldTest, ThreadCount) {
+    EXPECT_EQ(testWorld->getThreadCount(), 1);
+    testWorld->setThreadCount(3);
+    EXPECT_EQ(testWorld->getThreadCount(), 3);
+    testWorld->setThreadCount(1);
+    EXPECT_EQ(testWorld->getThreadCount(), 1);
+    EXPECT_GT(testWorld->getStripeRows(), animalconfig::CARNIVORE_CONFIG.visionRange);
+}
+
+TEST_F(WorldTest, StripedTickIndependentOfThreadCount) {
+    std::vector<animalconfig::SpeciesId> twoThreads = runStriped(World::StorageMode::Objects, 2, 30);
+    std::vector<animalconfig::SpeciesId> fourThreads = runStriped(World::StorageMode::Objects, 4, 30);
+    EXPECT_EQ(twoThreads, fourThreads);
+    EXPECT_EQ(runStriped(World::StorageMode::Objects, 1, 30), twoThreads);
+}
+
+TEST_F(WorldTest, DenseStripedTickIndependentOfThreadCount) {
+    std::vector<animalconfig::SpeciesId> twoThreads = runStriped(World::StorageMode::Dense, 2, 30);
+    std::vector<animalconfig::SpeciesId> fourThreads = runStriped(World::StorageMode::Dense, 4, 30);
+    EXPECT_EQ(twoThreads, fourThreads);
+    EXPECT_EQ(runStriped(World::StorageMode::Dense, 1, 30), twoThreads);
+}
+
+TEST_F(WorldTest, IntentTickIndependentOfThreadsAndStorage) {
+    std::vector<animalconfig::SpeciesId> serial = runStriped(World::StorageMode::Objects, 1, 30, World::TickEngine::Intent);
+    EXPECT_EQ(runStriped(World::StorageMode::Objects, 4, 30, World::TickEngine::Intent), serial);
+    EXPECT_EQ(runStriped(World::StorageMode::Dense, 1, 30, World::TickEngine::Intent), serial);
+    EXPECT_EQ(runStriped(World::StorageMode::Dense, 3, 30, World::TickEngine::Intent), serial);
+}
+
+TEST_F(WorldTest, IntentPredatorActsBeforeItsPrey) {
+    testWorld->setTickEngine(World::TickEngine::Intent);
+    testWorld->spawnEntity(animalconfig::PLANT_CONFIG, kinematics::Vector2D(4, 3));
+    testWorld->spawnEntity(animalconfig::HERBIVORE_CONFIG, kinematics::Vector2D(4, 4));
+    Entity* carnivore = testWorld->spawnEntity(animalconfig::CARNIVORE_CONFIG, kinematics::Vector2D(4, 5));
+
+    testWorld->run();
+
+    // The herbivore is eaten before it can eat or flee
+    EXPECT_EQ(testWorld->getCellSymbol(4, 3), '*');
+    EXPECT_EQ(testWorld->getEntityAt(4, 4), carnivore);
+    EXPECT_EQ(carnivore->getPosition(), kinematics::Vector2D(4, 4));
+    EXPECT_EQ(carnivore->energy, 120 + 30 - 2);
+    EXPECT_EQ(testWorld->getOccupiedCellsCount(), 2);
+}
+
+TEST_F(WorldTest, IntentSharedPreyGoesToOneEater) {
+    testWorld->setStorageMode(World::StorageMode::Dense);
+    testWorld->setTickEngine(World::TickEngine::Intent);
+    testWorld->spawnDense('H', kinematics::Vector2D(4, 3));
+    testWorld->spawnDense('*', kinematics::Vector2D(4, 4));
+    testWorld->spawnDense('H', kinematics::Vector2D(4, 5));
+
+    testWorld->run();
+
+    const EntityStore& store = testWorld->getEntityStore();
+    uint32_t eater = testWorld->getSlotAt(4, 4);
+    ASSERT_NE(eater, EntityStore::INVALID);
+    EXPECT_EQ(testWorld->getCellSymbol(4, 4), 'H');
+    EXPECT_EQ(store.energy[eater], 100 + 20 - 1);
+
+    // The other herbivore lost the draw and stayed put
+    uint32_t loser = testWorld->getSlotAt(4, eater == 0 ? 5 : 3);
+    ASSERT_NE(loser, EntityStore::INVALID);
+    EXPECT_EQ(store.energy[loser], 100);
+    EXPECT_EQ(store.getLiveCount(), 2);
+}
+
+TEST_F(WorldTest, SeedMakesRunsRepeatable) {
+    std::vector<animalconfig::SpeciesId> first = runStriped(World::StorageMode::Objects, 1, 30);
+    EXPECT_EQ(runStriped(World::StorageMode::Objects, 1, 30), first);
+    EXPECT_EQ(runStriped(World::StorageMode::Dense, 1, 30), runStriped(World::StorageMode::Dense, 1, 30));
+
+    testWorld->setSeed(99);
+    testWorld->run();
+    EXPECT_EQ(testWorld->getTick(), 1);
+    testWorld->setSeed(99);
+    EXPECT_EQ(testWorld->getTick(), 0);
+}
+
+TEST_F(WorldTest, EntityIdsFollowSeedAndParent) {
+    testWorld->setSeed(7);
+    Entity* first = testWorld->spawnEntity(animalconfig::HERBIVORE_CONFIG, kinematics::Vector2D(1, 1));
+    Entity* second = testWorld->spawnEntity(animalconfig::HERBIVORE_CONFIG, kinematics::Vector2D(1, 2));
+    EXPECT_NE(first->id, second->id);
+
+    std::unique_ptr<World> other = World::createTestInstance(WIDTH, HEIGHT);
+    other->setSeed(7);
+    EXPECT_EQ(other->spawnEntity(animalconfig::HERBIVORE_CONFIG, kinematics::Vector2D(4, 4))->id, first->id);
+
+    // Children take their id from the parent, wherever they are born
+    EXPECT_EQ(testWorld->childEntityId(first->id), other->childEntityId(first->id));
+    EXPECT_NE(testWorld->childEntityId(first->id), testWorld->childEntityId(second->id));
+
+    // Ids use all 64 bits, not a truncated hash
+    std::set<uint64_t> ids;
+    bool wide = false;
+    for (uint32_t i = 0; i < WIDTH * HEIGHT; ++i) {
+        const uint64_t id = other->newEntityId();
+        ids.insert(id);
+        wide = wide || id > UINT32_MAX;
+    }
+    EXPECT_EQ(ids.size(), static_cast<size_t>(WIDTH * HEIGHT));
+    EXPECT_TRUE(wide);
+}
+
+TEST_F(WorldTest, FieldSearchIndependentOfThreadsAndStorage) {
+    const World::TickEngine intent = World::TickEngine::Intent;
+    const World::NearestSearch field = World::NearestSearch::Field;
+    std::vector<animalconfig::SpeciesId> serial = runStriped(World::StorageMode::Objects, 1, 30, intent, field);
+    EXPECT_EQ(runStriped(World::StorageMode::Objects, 4, 30, intent, field), serial);
+    EXPECT_EQ(runStriped(World::StorageMode::Dense, 3, 30, intent, field), serial);
+}
+
+TEST_F(WorldTest, FieldSearchHuntsAndFlees) {
+    testWorld->setTickEngine(World::TickEngine::Intent);
+    testWorld->setNearestSearch(World::NearestSearch::Field);
+    Entity* herbivore = testWorld->spawnEntity(animalconfig::HERBIVORE_CONFIG, kinematics::Vector2D(4, 4));
+    Entity* carnivore = testWorld->spawnEntity(animalconfig::CARNIVORE_CONFIG, kinematics::Vector2D(4, 7));
+    testWorld->setSeed(2);
+
+    testWorld->run();
+
+    // The carnivore closes in; the herbivore, just beyond its own sight, did not wander towards it with this seed
+    EXPECT_EQ(carnivore->getPosition(), kinematics::Vector2D(4, 6));
+    kinematics::Vector2D fled = herbivore->getPosition();
+    EXPECT_GE(abs(fled.x - 4) + abs(fled.y - 7), 3);
+
+    testWorld->spawnEntity(animalconfig::PLANT_CONFIG, kinematics::Vector2D(0, 0));
+    testWorld->run();
+    EXPECT_EQ(testWorld->getOccupiedCellsCount(), 3);
+}
+
+
+TEST_F(WorldTest, ChunkedLayoutNeedsObjectsStorage) {
+    testWorld->setStorageMode(World::StorageMode::Dense);
+    EXPECT_THROW(testWorld->setGridLayout(World::GridLayout::Chunked), std::runtime_error);
+    testWorld->setStorageMode(World::StorageMode::Objects);
+    testWorld->setGridLayout(World::GridLayout::Chunked);
+    EXPECT_THROW(testWorld->setStorageMode(World::StorageMode::Dense), std::runtime_error);
+}
+
+TEST_F(WorldTest, ChunkedLayoutRunsTheSweepOnOneThread) {
+    testWorld->setTickEngine(World::TickEngine::Intent);
+    EXPECT_THROW(testWorld->setGridLayout(World::GridLayout::Chunked), std::runtime_error);
+    testWorld->setTickEngine(World::TickEngine::Sweep);
+    testWorld->setThreadCount(2);
+    EXPECT_THROW(testWorld->setGridLayout(World::GridLayout::Chunked), std::runtime_error);
+    testWorld->setThreadCount(1);
+    testWorld->setGridLayout(World::GridLayout::Chunked);
+    EXPECT_THROW(testWorld->setTickEngine(World::TickEngine::Intent), std::runtime_error);
+    EXPECT_THROW(testWorld->setThreadCount(2), std::runtime_error);
+    EXPECT_EQ(testWorld->getTickEngine(), World::TickEngine::Sweep);
+    EXPECT_EQ(testWorld->getThreadCount(), 1u);
+}
+
+TEST_F(WorldTest, ChunkedCellIdsDoNotOverflow) {
+    std::unique_ptr<World> world(new World());
+    world->setGridLayout(World::GridLayout::Chunked);
+    world->initialize(100000, 100000);
+    EXPECT_EQ(world->getCellId(99999, 99999), 9999999999ull);
+    EXPECT_EQ(world->getCellId(21474, 83648), static_cast<uint64_t>(INT_MAX) + 1);
+    EXPECT_EQ(world->getCellCoordinates(9999999999ull), kinematics::Vector2D(99999, 99999));
+    EXPECT_EQ(world->getCellId(100000, 0), World::INVALID_CELL);
+    EXPECT_THROW(world->setChangeTracking(true), std::runtime_error);
+}
+
+TEST_F(WorldTest, ChunkedHerbivoreEatsAcrossChunkBorder) {
+    std::unique_ptr<World> world(new World());
+    world->setGridLayout(World::GridLayout::Chunked);
+    world->initialize(100000, 100000);
+    world->setSeed(5);
+
+    world->spawnEntity(animalconfig::PLANT_CONFIG, kinematics::Vector2D(64, 63));
+    Entity* herbivore = world->spawnEntity(animalconfig::HERBIVORE_CONFIG, kinematics::Vector2D(63, 63));
+    EXPECT_EQ(world->getChunkedGrid().getChunkCount(), 2);
+
+    world->run();
+
+    EXPECT_EQ(herbivore->getPosition(), kinematics::Vector2D(64, 63));
+    EXPECT_EQ(herbivore->energy, 100 + 20 - 1);
+    EXPECT_EQ(world->getOccupiedCellsCount(), 1);
+    EXPECT_EQ(world->getChunkedGrid().getChunkCount(), 1);   // The emptied chunk is freed
+}
+
+TEST_F(WorldTest, ChunkedRunKeepsCountsInStep) {
+    std::unique_ptr<World> world(new World());
+    world->setGridLayout(World::GridLayout::Chunked);
+    world->initialize(640, 400);
+    world->setSeed(1234);
+    for (int i = 0; i < 600; ++i) world->addEntityType('*');
+    for (int i = 0; i < 300; ++i) world->addEntityType('H');
+    for (int i = 0; i < 40; ++i) world->addEntityType('C');
+
+    for (int tick = 0; tick < 30; ++tick) {
+        world->run();
+    }
+
+    uint32_t occupied = 0;
+    for (int x = 0; x < world->size.x; ++x) {
+        for (int y = 0; y < world->size.y; ++y) {
+            occupied += world->isCellOccupied(x, y);
+        }
+    }
+    EXPECT_EQ(world->getOccupiedCellsCount(), occupied);
+    EXPECT_EQ(world->getEntityPool().getLiveCount(), occupied);
+    EXPECT_LE(world->getChunkedGrid().getChunkCount(), 10u * 7u);
+}
+
+TEST_F(WorldTest, NewEmptyCellFindsTheLastHole) {
+    for (uint32_t x = 0; x < WIDTH; ++x) {
+        for (uint32_t y = 0; y < HEIGHT; ++y) {
+            if (x != 7 || y != 3)
+                testWorld->spawnEntity(animalconfig::PLANT_CONFIG, kinematics::Vector2D(x, y));
+        }
+    }
+    EXPECT_EQ(testWorld->getFreeCellCount(), 1u);
+    EXPECT_EQ(testWorld->getNewEmptyCell(), kinematics::Vector2D(7, 3));
+
+    testWorld->spawnEntity(animalconfig::PLANT_CONFIG, kinematics::Vector2D(7, 3));
+    EXPECT_TRUE(testWorld->isFull());
+    EXPECT_THROW(testWorld->getNewEmptyCell(), std::runtime_error);
+}
+
+TEST_F(WorldTest, NewEmptyCellsAreDistinctAndEmpty) {
+    testWorld->setSeed(3);
+    for (int i = 0; i < 40; ++i) {
+        testWorld->addEntityType(animalconfig::PLANT_CONFIG.symbol);
+    }
+
+    std::vector<kinematics::Vector2D> cells = testWorld->getNewEmptyCells(60);
+    ASSERT_EQ(cells.size(), 60u);
+    std::set<std::pair<int, int>> distinct;
+    for (const kinematics::Vector2D& cell : cells) {
+        EXPECT_FALSE(testWorld->isCellOccupied(cell.x, cell.y));
+        distinct.insert({cell.x, cell.y});
+    }
+    EXPECT_EQ(distinct.size(), 60u);
+
+    EXPECT_THROW(testWorld->getNewEmptyCells(61), std::runtime_error);
+}
+
+TEST_F(WorldTest, ChunkedNewEmptyCellsStayInside) {
+    std::unique_ptr<World> world(new World());
+    world->setGridLayout(World::GridLayout::Chunked);
+    world->initialize(1000, 700);
+    world->setSeed(8);
+
+    for (const kinematics::Vector2D& cell : world->getNewEmptyCells(5000)) {
+        ASSERT_TRUE(world->isInside(cell.x, cell.y));
+        ASSERT_FALSE(world->isCellOccupied(cell.x, cell.y));
+        world->spawnEntity(animalconfig::PLANT_CONFIG, cell);
+    }
+    EXPECT_EQ(world->getOccupiedCellsCount(), 5000u);
+    EXPECT_EQ(world->getFreeCellCount(), 1000u * 700u - 5000u);
+}
+
+namespace {
+    std::vector<World::Population> mixedPopulations() {
+        const animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+        std::vector<World::Population> populations(3);
+        populations[0].species = registry.findBySymbol('*');
+        populations[0].density = 0.3;
+        populations[1].species = registry.findBySymbol('H');
+        populations[1].count = 500;
+        populations[2].species = registry.findBySymbol('C');
+        populations[2].count = 60;
+        return populations;
+    }
+
+    // Species of every cell after populate() on a fresh 64x40 world
+    std::vector<animalconfig::SpeciesId> populateCells(World::StorageMode mode, uint32_t threads, const std::vector<World::Population>& populations) {
+        std::unique_ptr<World> world = World::createTestInstance(64, 40);
+        world->setStorageMode(mode);
+        world->setThreadCount(threads);
+        world->setSeed(77);
+        world->populate(populations);
+
+        std::vector<animalconfig::SpeciesId> cells;
+        uint32_t occupied = 0;
+        for (int x = 0; x < world->size.x; ++x) {
+            for (int y = 0; y < world->size.y; ++y) {
+                cells.push_back(world->getCellSpecies(x, y));
+                occupied += cells.back() != animalconfig::NO_SPECIES;
+            }
+        }
+        uint32_t live = mode == World::StorageMode::Dense ? world->getEntityStore().getLiveCount() : world->getEntityPool().getLiveCount();
+        EXPECT_EQ(world->getOccupiedCellsCount(), occupied);
+        EXPECT_EQ(live, occupied);
+        return cells;
+    }
+}
+
+TEST_F(WorldTest, PopulatePlacesExactCounts) {
+    std::vector<World::Population> populations = mixedPopulations();
+    populations[1].count = 20;
+    populations[2].count = 5;
+    std::vector<uint64_t> placed = testWorld->populate(populations);
+    EXPECT_EQ(placed, (std::vector<uint64_t>{30, 20, 5}));      // 0.3 of 100 cells are plants
+    EXPECT_EQ(testWorld->getOccupiedCellsCount(), 55u);
+    EXPECT_EQ(testWorld->getSpeciesIndex().getCount(populations[1].species), 20u);
+    EXPECT_EQ(testWorld->getSpeciesIndex().getCount(populations[2].species), 5u);
+
+    // 45 cells are left
+    populations[0].density = 0.0;
+    populations[0].count = 21;
+    EXPECT_THROW(testWorld->populate(populations), std::runtime_error);
+    EXPECT_EQ(testWorld->getOccupiedCellsCount(), 55u);
+}
+
+TEST_F(WorldTest, PopulateIndependentOfThreadsAndStorage) {
+    std::vector<World::Population> populations = mixedPopulations();
+    std::vector<animalconfig::SpeciesId> serial = populateCells(World::StorageMode::Objects, 1, populations);
+    EXPECT_EQ(populateCells(World::StorageMode::Objects, 3, populations), serial);
+    EXPECT_EQ(populateCells(World::StorageMode::Dense, 1, populations), serial);
+    EXPECT_EQ(populateCells(World::StorageMode::Dense, 4, populations), serial);
+
+    // A small batch takes the sampling path instead of the grid passes
+    populations[0].density = 0.01;
+    serial = populateCells(World::StorageMode::Objects, 1, populations);
+    EXPECT_EQ(populateCells(World::StorageMode::Dense, 2, populations), serial);
+}
+
+TEST_F(WorldTest, PopulatePoissonDiskKeepsSpacing) {
+    std::unique_ptr<World> world = World::createTestInstance(50, 50);
+    world->setSeed(5);
+    World::Population carnivores;
+    carnivores.species = animalconfig::SpeciesRegistry::getInstance().findBySymbol('C');
+    carnivores.count = 1000;
+    carnivores.pattern = World::Population::Pattern::PoissonDisk;
+    carnivores.spacing = 4;
+
+    uint64_t placed = world->populate({carnivores})[0];
+    EXPECT_GT(placed, 50u);
+    EXPECT_LE(placed, 13u * 13u);   // At most one per 4x4 block
+    EXPECT_EQ(world->getOccupiedCellsCount(), placed);
+    for (int x = 0; x < 50; ++x) {
+        for (int y = 0; y < 50; ++y) {
+            if (world->isCellOccupied(x, y)) {
+                EXPECT_EQ(world->findNearest(kinematics::Vector2D(x, y), 3, &carnivores.species, 1), kinematics::Vector2D(-1, -1));
+            }
+        }
+    }
+}
+
+TEST_F(WorldTest, PopulateClusteredStaysNearCentres) {
+    std::unique_ptr<World> world = World::createTestInstance(200, 200);
+    world->setSeed(9);
+    World::Population plants;
+    plants.species = animalconfig::SpeciesRegistry::getInstance().findBySymbol('*');
+    plants.count = 300;
+    plants.pattern = World::Population::Pattern::Clustered;
+    plants.clusters = 1;
+    plants.spread = 3.0;
+
+    world->populate({plants});
+    ASSERT_EQ(world->getOccupiedCellsCount(), 300u);
+
+    std::vector<kinematics::Vector2D> cells;
+    double meanX = 0, meanY = 0;
+    for (int x = 0; x < 200; ++x) {
+        for (int y = 0; y < 200; ++y) {
+            if (world->isCellOccupied(x, y)) {
+                cells.emplace_back(x, y);
+                meanX += x / 300.0;
+                meanY += y / 300.0;
+            }
+        }
+    }
+    // A uniform spread would put agents ~100 cells from their mean
+    double distance = 0;
+    for (const kinematics::Vector2D& cell : cells) {
+        distance += std::abs(cell.x - meanX) + std::abs(cell.y - meanY);
+    }
+    EXPECT_LT(distance / cells.size(), 20.0);
+}
+
+// Replays takeChangedCells() onto a copy of the grid and checks it against the real one
+static void expectChangesCoverTicks(World& world) {
+    world.setSeed(4);
+    world.setChangeTracking(true);
+    for (int i = 0; i < 300; ++i) world.addEntityType('*');
+    for (int i = 0; i < 120; ++i) world.addEntityType('H');
+    for (int i = 0; i < 15; ++i) world.addEntityType('C');
+
+    const uint32_t cells = world.getCellCount();
+    std::vector<uint64_t> shadow(cells, 0);
+    auto cellState = [&world](const uint32_t& cellId) {
+        kinematics::Vector2D pos = world.getCellCoordinates(cellId);
+        return static_cast<uint64_t>(world.getCellSpecies(pos.x, pos.y)) << 32 | world.getCellEnergy(pos.x, pos.y);
+    };
+
+    std::vector<uint32_t> changed;
+    for (int tick = 0; tick < 25; ++tick) {
+        if (!world.takeChangedCells(changed)) {
+            // Everything counts as changed the first time round
+            EXPECT_EQ(tick, 0);
+            for (uint32_t cellId = 0; cellId < cells; ++cellId) shadow[cellId] = cellState(cellId);
+        } else {
+            EXPECT_LT(changed.size(), cells);
+            for (const uint32_t& cellId : changed) shadow[cellId] = cellState(cellId);
+        }
+        for (uint32_t cellId = 0; cellId < cells; ++cellId) {
+            ASSERT_EQ(shadow[cellId], cellState(cellId)) << "cell " << cellId << " at tick " << tick;
+        }
+        world.run();
+        if (tick % 3 == 0) world.addEntityType('*');
+    }
+
+    world.clear();
+    EXPECT_FALSE(world.takeChangedCells(changed));
+    EXPECT_TRUE(world.takeChangedCells(changed));
+    EXPECT_TRUE(changed.empty());
+}
+
+TEST_F(WorldTest, ChangeTrackingCoversSweepTicks) {
+    std::unique_ptr<World> world = World::createTestInstance(40, 45);
+    EXPECT_FALSE(world->isTrackingChanges());
+    expectChangesCoverTicks(*world);
+
+    std::unique_ptr<World> chunked = World::createTestInstance(0, 0);
+    chunked->setGridLayout(World::GridLayout::Chunked);
+    chunked->initialize(40, 45);
+    expectChangesCoverTicks(*chunked);
+}
+
+TEST_F(WorldTest, ChangeTrackingCoversDenseAndStripedTicks) {
+    std::unique_ptr<World> dense = World::createTestInstance(40, 45);
+    dense->setStorageMode(World::StorageMode::Dense);
+    expectChangesCoverTicks(*dense);
+
+    std::unique_ptr<World> striped = World::createTestInstance(40, 45);
+    striped->setStorageMode(World::StorageMode::Dense);
+    striped->setThreadCount(3);
+    expectChangesCoverTicks(*striped);
+}
+
+TEST_F(WorldTest, ChangeTrackingCoversIntentTicks) {
+    std::unique_ptr<World> world = World::createTestInstance(40, 45);
+    world->setTickEngine(World::TickEngine::Intent);
+    expectChangesCoverTicks(*world);
+}
+
+TEST_F(WorldTest, LiveEntityIdsAreUnique) {
+    // Herbivores that breed every tick, so cells see several births a tick
+    animalconfig::SpeciesRegistry& registry = animalconfig::SpeciesRegistry::getInstance();
+    registry.loadFromString(R"({"species": [{"symbol": "H", "reproductionThreshold": 60, "reproductionCost": 10}]})");
+
+    const World::StorageMode modes[2] = {World::StorageMode::Objects, World::StorageMode::Dense};
+    const World::TickEngine engines[2] = {World::TickEngine::Sweep, World::TickEngine::Intent};
+    for (World::StorageMode mode : modes) {
+        for (World::TickEngine engine : engines) {
+            std::unique_ptr<World> world = World::createTestInstance(200, 200);
+            world->setStorageMode(mode);
+            world->setTickEngine(engine);
+            world->setThreadCount(2);
+            world->setSeed(11);
+            for (int i = 0; i < 12000; ++i) world->addEntityType('*');
+            for (int i = 0; i < 6000; ++i) world->addEntityType('H');
+            for (int i = 0; i < 800; ++i) world->addEntityType('C');
+
+            for (int tick = 0; tick < 12; ++tick) {
+                world->run();
+                std::set<uint64_t> ids;
+                uint64_t live = 0;
+                for (int x = 0; x < world->size.x; ++x) {
+                    for (int y = 0; y < world->size.y; ++y) {
+                        if (!world->isCellOccupied(x, y))
+                            continue;
+                        ++live;
+                        ids.insert(mode == World::StorageMode::Dense ? world->getEntityStore().id[world->getSlotAt(x, y)] : world->getEntityAt(x, y)->id);
+                    }
+                }
+                ASSERT_EQ(ids.size(), live) << "tick " << tick;
+            }
+        }
+    }
+
+    registry.reset();
+}